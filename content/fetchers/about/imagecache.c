@@ -93,6 +93,8 @@ bool fetch_about_imagecache_handler(struct fetch_about_context *ctx)
 				"(from %v images converted more than once)"
 				"</p>\n"
 		"<p>Bitmap of size %w had most (%x) conversions</p>\n"
+		"<p>Total conversion time %yms, %z bitmaps evicted</p>\n"
+		"<p>%A bitmaps scaled, plotted %B times</p>\n"
 		"<h2 class=\"ns-border\">Current contents</h2>\n");
 	if (slen >= (int) (sizeof(buffer))) {
 		goto fetch_about_imagecache_handler_aborted; /* overflow */
@@ -110,6 +112,7 @@ bool fetch_about_imagecache_handler(struct fetch_about_context *ctx)
 			"<span>Content Key</span>"
 			"<span>Redraw Count</span>"
 			"<span>Conversion Count</span>"
+			"<span>Conversion Time</span>"
 			"<span>Last Redraw</span>"
 			"<span>Bitmap Age</span>"
 			"<span>Bitmap Size</span>"
@@ -130,6 +133,7 @@ bool fetch_about_imagecache_handler(struct fetch_about_context *ctx)
 					"<span class=\"ns-border\">%k</span>"
 					"<span class=\"ns-border\">%r</span>"
 					"<span class=\"ns-border\">%c</span>"
+					"<span class=\"ns-border\">%tms</span>"
 					"<span class=\"ns-border\">%a</span>"
 					"<span class=\"ns-border\">%g</span>"
 					"<span class=\"ns-border\">%s</span>"
@@ -144,6 +148,7 @@ bool fetch_about_imagecache_handler(struct fetch_about_context *ctx)
 					"<span class=\"ns-border\">%k</span>"
 					"<span class=\"ns-border\">%r</span>"
 					"<span class=\"ns-border\">%c</span>"
+					"<span class=\"ns-border\">%tms</span>"
 					"<span class=\"ns-border\">%a</span>"
 					"<span class=\"ns-border\">%g</span>"
 					"<span class=\"ns-border\">%s</span>"
@@ -22,6 +22,8 @@
 #include <dom/dom.h>
 
 #include "utils/errors.h"
+#include "utils/ascii.h"
+#include "utils/bloom.h"
 #include "utils/corestrings.h"
 #include "utils/utils.h"
 #include "utils/http.h"
@@ -32,6 +34,7 @@
 #include "content/fetch.h"
 #include "content/hlcache.h"
 #include "desktop/system_colour.h"
+#include "desktop/gui_internal.h"
 
 #include "css/css.h"
 #include "css/hints.h"
@@ -40,6 +43,23 @@
 /* Define to trace import fetches */
 #undef NSCSS_IMPORT_TRACE
 
+/** Size in bytes of the filter of names used by a sheet's selectors */
+#define NSCSS_SELECTOR_FILTER_SIZE 2048
+
+/** Maximum nesting of blocks tracked while indexing selectors */
+#define NSCSS_SELECTOR_INDEX_DEPTH 16
+
+/** Maximum depth of imports searched for selector names */
+#define NSCSS_SELECTOR_IMPORT_DEPTH 8
+
+/** Total size of parsed stylesheets kept for reuse */
+#define NSCSS_SHEET_CACHE_SIZE (2 * 1024 * 1024)
+
+/** Bytes of stylesheet source parsed before yielding to other work */
+#define NSCSS_PARSE_SLICE (64 * 1024)
+
+struct nscss_sheet_entry;
+
 struct content_css_data;
 
 /**
@@ -62,6 +82,14 @@ struct content_css_data
 	uint32_t next_to_register;	/**< Index of next import to register */
 	nscss_done_callback done;	/**< Completion callback */
 	void *pw;			/**< Client data */
+
+	struct bloom_filter *selectors;	/**< Names used by selectors */
+	bool sibling_selectors;		/**< Selectors use sibling combinators */
+
+	const uint8_t *source;		/**< Stylesheet source */
+	uint64_t source_hash;		/**< Hash of stylesheet source */
+	size_t source_length;		/**< Length of stylesheet source */
+	struct nscss_sheet_entry *entry; /**< Reuse entry of sheet, if any */
 };
 
 /**
@@ -72,8 +100,33 @@ typedef struct nscss_content
 	struct content base;		/**< Underlying content object */
 
 	struct content_css_data data;	/**< CSS data */
+	size_t parsed;			/**< Bytes of source parsed */
 } nscss_content;
 
+/**
+ * A parsed stylesheet which may be reused
+ *
+ * Entries are kept on a most recently used list while their total size
+ * is within NSCSS_SHEET_CACHE_SIZE and destroyed once they are neither
+ * listed nor used by any content.
+ */
+struct nscss_sheet_entry {
+	struct nscss_sheet_entry *prev;	/**< Previous (more recent) entry */
+	struct nscss_sheet_entry *next;	/**< Next (less recent) entry */
+	bool listed;			/**< Entry is on the list */
+
+	uint64_t hash;			/**< Hash of source */
+	uint8_t *source;		/**< Copy of source */
+	size_t length;			/**< Length of source */
+	bool quirks;			/**< Sheet was parsed allowing quirks */
+	char *url;			/**< Base URL of sheet */
+	char *charset;			/**< Character set of sheet, or NULL */
+
+	css_stylesheet *sheet;		/**< The parsed stylesheet */
+	size_t size;			/**< Size of parsed sheet and source */
+	unsigned int users;		/**< Number of contents using sheet */
+};
+
 /**
  * Context for import fetches
  */
@@ -97,6 +150,10 @@ static css_error nscss_process_css_data(struct content_css_data *c, const char *
 static css_error nscss_convert_css_data(struct content_css_data *c);
 static void nscss_destroy_css_data(struct content_css_data *c);
 
+static bool nscss_sheet_reuse(struct content_css_data *c);
+static void nscss_sheet_insert(struct content_css_data *c);
+static void nscss_sheet_release(struct nscss_sheet_entry *entry);
+
 static void nscss_content_done(struct content_css_data *css, void *pw);
 static css_error nscss_handle_import(void *pw, css_stylesheet *parent,
 		lwc_string *url);
@@ -111,6 +168,13 @@ static css_error nscss_register_import(struct content_css_data *c,
 
 static css_stylesheet *blank_import;
 
+/** Reusable parsed stylesheets, most recently used first */
+static struct nscss_sheet_entry *sheet_entries;
+/** Least recently used reusable parsed stylesheet */
+static struct nscss_sheet_entry *sheet_entries_last;
+/** Total size of listed parsed stylesheets */
+static size_t sheet_entries_size;
+
 
 /**
  * Initialise a CSS content
@@ -209,6 +273,12 @@ static nserror nscss_create_css_data(struct content_css_data *c,
 	c->next_to_register = (uint32_t) -1;
 	c->import_count = 0;
 	c->imports = NULL;
+	c->selectors = NULL;
+	c->sibling_selectors = true;
+	c->source = NULL;
+	c->source_hash = 0;
+	c->source_length = 0;
+	c->entry = NULL;
 	if (charset != NULL)
 		c->charset = strdup(charset);
 	else
@@ -239,62 +309,433 @@ static nserror nscss_create_css_data(struct content_css_data *c,
 }
 
 /**
- * Process CSS source data
+ * Process CSS data
  *
- * \param c     Content structure
+ * \param c     CSS content object
  * \param data  Data to process
  * \param size  Number of bytes to process
+ * \return CSS_OK on success, appropriate error otherwise
+ */
+static css_error nscss_process_css_data(struct content_css_data *c,
+		const char *data, unsigned int size)
+{
+	return css_stylesheet_append_data(c->sheet,
+			(const uint8_t *) data, size);
+}
+
+/**
+ * Compute the hash of a name used by a selector
+ *
+ * Names are folded to lower case so case sensitive names which differ
+ * only in case are reported as possibly used.
+ *
+ * \param type  Kind of name
+ * \param name  The name
+ * \param len   Length of name in bytes
+ * \return The hash of the name
+ */
+static uint32_t nscss_selector_hash(enum nscss_selector_name type,
+		const char *name, size_t len)
+{
+	uint32_t z = 0x811c9dc5;
+
+	z ^= (uint32_t) type;
+	z *= 0x01000193;
+	while (len-- > 0) {
+		z ^= (uint8_t) ascii_to_lower(*name++);
+		z *= 0x01000193;
+	}
+
+	return z;
+}
+
+/**
+ * Find the length of a CSS name
+ *
+ * \param data  Data starting with the name
+ * \param size  Length of data
+ * \return Length of the name in bytes, zero if data does not start a name
+ */
+static size_t nscss_name_length(const char *data, size_t size)
+{
+	size_t len = 0;
+
+	while (len < size && (ascii_is_alphanumerical(data[len]) ||
+			data[len] == '-' || data[len] == '_' ||
+			(uint8_t) data[len] >= 0x80)) {
+		len++;
+	}
+
+	return len;
+}
+
+/**
+ * Determine if a CSS name is equal to an ascii string, ignoring case
+ *
+ * \param data  The name
+ * \param len   Length of the name
+ * \param name  The NULL terminated string to compare with
+ * \return true if the name and string are equal
+ */
+static bool nscss_name_is(const char *data, size_t len, const char *name)
+{
+	return (strlen(name) == len) &&
+		(ascii_strings_count_equal_caseless(name, data) == len);
+}
+
+/**
+ * Index the names used by the selectors of a stylesheet
+ *
+ * The source is scanned for the class, id and attribute names used in
+ * selectors, along with the attributes which pseudo classes depend on.
+ * Declaration blocks and at-rule preludes are skipped. Comments,
+ * strings and escapes end where the CSS tokeniser ends them so none can
+ * close a block early. libcss provides no way to enumerate the
+ * selectors it parsed, so the source is scanned instead. The scan only
+ * needs to find a superset of the names in use; if the source cannot
+ * be understood no index is made so every name is reported as possibly
+ * used.
+ *
+ * \param c     CSS data to index
+ * \param data  Source of the stylesheet
+ * \param size  Length of source in bytes
+ */
+static void nscss_index_selectors(struct content_css_data *c,
+		const char *data, size_t size)
+{
+	bool block_has_rules[NSCSS_SELECTOR_INDEX_DEPTH];
+	struct bloom_filter *filter;
+	enum nscss_selector_name type;
+	unsigned int depth = 0;
+	bool prelude_start = true;
+	bool at_rule = false;
+	bool group_rule = false;
+	bool siblings = false;
+	size_t i = 0;
+	size_t len;
+	char ch;
+
+	if (c->selectors != NULL) {
+		bloom_destroy(c->selectors);
+		c->selectors = NULL;
+	}
+	c->sibling_selectors = true;
+
+	/* Only ascii compatible encodings can be scanned */
+	if (size == 0 || memchr(data, '\0', size) != NULL) {
+		return;
+	}
+
+	filter = bloom_create(NSCSS_SELECTOR_FILTER_SIZE);
+	if (filter == NULL) {
+		return;
+	}
+
+	while (i < size) {
+		ch = data[i];
+
+		if (ch == '/' && i + 1 < size && data[i + 1] == '*') {
+			/* Comment */
+			for (i += 2; i + 1 < size; i++) {
+				if (data[i] == '*' && data[i + 1] == '/')
+					break;
+			}
+			i += 2;
+			continue;
+		}
+
+		if (ch == '"' || ch == '\'') {
+			/* String, ended early by an unescaped newline */
+			for (i++; i < size && data[i] != ch && data[i] != '\n' &&
+					data[i] != '\r' && data[i] != '\f'; i++) {
+				if (data[i] == '\\')
+					i++;
+			}
+			i++;
+			continue;
+		}
+
+		if (ch == '\\') {
+			if (at_rule || (depth > 0 &&
+					(depth > NSCSS_SELECTOR_INDEX_DEPTH ||
+					block_has_rules[depth - 1] == false))) {
+				/* Escaped characters never end a block */
+				i += 2;
+				continue;
+			}
+
+			/* Escaped names cannot be indexed */
+			bloom_destroy(filter);
+			return;
+		}
+
+		if (ch == '{') {
+			/* Only blocks of grouping rules contain selectors */
+			if (depth < NSCSS_SELECTOR_INDEX_DEPTH) {
+				block_has_rules[depth] = at_rule && group_rule;
+			}
+			depth++;
+			prelude_start = true;
+			at_rule = false;
+			i++;
+			continue;
+		}
+
+		if (ch == '}') {
+			if (depth > 0)
+				depth--;
+			prelude_start = true;
+			at_rule = false;
+			i++;
+			continue;
+		}
+
+		if (depth > 0 && (depth > NSCSS_SELECTOR_INDEX_DEPTH ||
+				block_has_rules[depth - 1] == false)) {
+			/* Declarations */
+			i++;
+			continue;
+		}
+
+		if (ch == ';') {
+			prelude_start = true;
+			at_rule = false;
+			i++;
+			continue;
+		}
+
+		if (ascii_is_space(ch)) {
+			i++;
+			continue;
+		}
+
+		if (prelude_start) {
+			prelude_start = false;
+
+			if (ch == '@') {
+				len = nscss_name_length(data + i + 1,
+						size - i - 1);
+				at_rule = true;
+				group_rule = nscss_name_is(data + i + 1, len,
+							"media") ||
+					nscss_name_is(data + i + 1, len,
+							"supports") ||
+					nscss_name_is(data + i + 1, len,
+							"document") ||
+					nscss_name_is(data + i + 1, len,
+							"-moz-document");
+				i += len + 1;
+				continue;
+			}
+		}
+
+		if (at_rule) {
+			i++;
+			continue;
+		}
+
+		switch (ch) {
+		case '+':
+		case '~':
+			siblings = true;
+			i++;
+			break;
+
+		case '.':
+		case '#':
+			type = (ch == '.') ? NSCSS_SELECTOR_CLASS :
+					NSCSS_SELECTOR_ID;
+			i++;
+			len = nscss_name_length(data + i, size - i);
+			if (len > 0) {
+				bloom_insert_hash(filter, nscss_selector_hash(
+						type, data + i, len));
+			}
+			i += len;
+			break;
+
+		case '[':
+			for (i++; i < size && ascii_is_space(data[i]); i++)
+				;
+			len = nscss_name_length(data + i, size - i);
+			if (len == 0 && i < size && data[i] == '*') {
+				/* Any namespace */
+				len = 1;
+			}
+			if (i + len + 1 < size && data[i + len] == '|' &&
+					data[i + len + 1] != '=') {
+				/* Skip namespace prefix */
+				i += len + 1;
+				len = nscss_name_length(data + i, size - i);
+			}
+			if (len > 0) {
+				bloom_insert_hash(filter, nscss_selector_hash(
+						NSCSS_SELECTOR_ATTRIBUTE,
+						data + i, len));
+			}
+			i += len;
+			break;
+
+		case ':':
+			for (i++; i < size && data[i] == ':'; i++)
+				;
+			len = nscss_name_length(data + i, size - i);
+			if (nscss_name_is(data + i, len, "link") ||
+					nscss_name_is(data + i, len, "visited") ||
+					nscss_name_is(data + i, len, "any-link")) {
+				/* Links are determined by their href */
+				bloom_insert_hash(filter, nscss_selector_hash(
+						NSCSS_SELECTOR_ATTRIBUTE,
+						"href", SLEN("href")));
+			}
+			i += len;
+			break;
+
+		default:
+			i++;
+			break;
+		}
+	}
+
+	c->selectors = filter;
+	c->sibling_selectors = siblings;
+}
+
+/**
+ * Compute the hash of stylesheet source
+ *
+ * \param data  Source data
+ * \param size  Length of source data
+ * \return 64bit FNV-1a hash of the source
+ */
+static uint64_t nscss_source_hash(const uint8_t *data, size_t size)
+{
+	uint64_t z = 0xcbf29ce484222325ULL;
+
+	while (size-- > 0) {
+		z ^= *data++;
+		z *= 0x100000001b3ULL;
+	}
+
+	return z;
+}
+
+/**
+ * Parse the next part of a CSS content's source
+ *
+ * \param css    Content to parse
+ * \param limit  Maximum number of bytes to parse
  * \return true on success, false on failure
  */
-static bool
-nscss_process_data(struct content *c, const char *data, unsigned int size)
+static bool nscss_parse_source(nscss_content *css, size_t limit)
 {
-	nscss_content *css = (nscss_content *) c;
+	const uint8_t *data;
+	size_t size;
 	css_error error;
 
-	error = nscss_process_css_data(&css->data, data, size);
+	data = content__get_source_data(&css->base, &size);
+
+	size -= css->parsed;
+	if (size > limit) {
+		size = limit;
+	}
+
+	error = nscss_process_css_data(&css->data,
+			(const char *) data + css->parsed, (unsigned int) size);
 	if (error != CSS_OK && error != CSS_NEEDDATA) {
-		content_broadcast_error(c, NSERROR_CSS, NULL);
+		return false;
 	}
 
-	return (error == CSS_OK || error == CSS_NEEDDATA);
+	css->parsed += size;
+
+	return true;
 }
 
 /**
- * Process CSS data
+ * Scheduler callback to continue parsing a large CSS content
  *
- * \param c     CSS content object
- * \param data  Data to process
- * \param size  Number of bytes to process
- * \return CSS_OK on success, appropriate error otherwise
+ * \param p  CSS content being parsed
  */
-static css_error nscss_process_css_data(struct content_css_data *c,
-		const char *data, unsigned int size)
+static void nscss_parse_callback(void *p)
 {
-	return css_stylesheet_append_data(c->sheet,
-			(const uint8_t *) data, size);
+	nscss_content *css = p;
+
+	if (nscss_parse_source(css, NSCSS_PARSE_SLICE) == false) {
+		content_broadcast_error(&css->base, NSERROR_CSS, NULL);
+		content_set_error(&css->base);
+		return;
+	}
+
+	if (css->parsed < css->data.source_length) {
+		guit->misc->schedule(0, nscss_parse_callback, css);
+		return;
+	}
+
+	if (nscss_convert_css_data(&css->data) != CSS_OK) {
+		content_broadcast_error(&css->base, NSERROR_CSS, NULL);
+		content_set_error(&css->base);
+	}
 }
 
 /**
- * Convert a CSS content ready for use
+ * Convert a CSS content's source
  *
- * \param c  Content to convert
+ * Source is only parsed once all of it has arrived so that an earlier
+ * parse of identical source may be reused instead.
+ *
+ * Source beyond the first \a slice bytes is parsed from the scheduler,
+ * a slice at a time, so large stylesheets do not hold up layout and
+ * input handling. The content becomes ready once parsing completes.
+ *
+ * \param css    Content to convert
+ * \param slice  Maximum number of bytes to parse before yielding
  * \return true on success, false on failure
  */
-bool nscss_convert(struct content *c)
+static bool nscss_convert_source(nscss_content *css, size_t slice)
 {
-	nscss_content *css = (nscss_content *) c;
+	const uint8_t *data;
+	size_t size;
 	css_error error;
 
+	data = content__get_source_data(&css->base, &size);
+	nscss_index_selectors(&css->data, (const char *) data, size);
+
+	css->data.source = data;
+	css->data.source_hash = nscss_source_hash(data, size);
+	css->data.source_length = size;
+
+	if (nscss_sheet_reuse(&css->data) == false && size > 0) {
+		if (nscss_parse_source(css, slice) == false) {
+			content_broadcast_error(&css->base, NSERROR_CSS, NULL);
+			return false;
+		}
+
+		if (css->parsed < size) {
+			guit->misc->schedule(0, nscss_parse_callback, css);
+			return true;
+		}
+	}
+
 	error = nscss_convert_css_data(&css->data);
 	if (error != CSS_OK) {
-		content_broadcast_error(c, NSERROR_CSS, NULL);
+		content_broadcast_error(&css->base, NSERROR_CSS, NULL);
 		return false;
 	}
 
 	return true;
 }
 
+/**
+ * Convert a CSS content ready for use
+ *
+ * \param c  Content to convert
+ * \return true on success, false on failure
+ */
+bool nscss_convert(struct content *c)
+{
+	return nscss_convert_source((nscss_content *) c, NSCSS_PARSE_SLICE);
+}
+
 /**
  * Convert CSS data ready for use
  *
@@ -305,6 +746,12 @@ static css_error nscss_convert_css_data(struct content_css_data *c)
 {
 	css_error error;
 
+	if (c->entry != NULL) {
+		/* Reused sheet was completed when first parsed */
+		c->done(c, c->pw);
+		return CSS_OK;
+	}
+
 	error = css_stylesheet_data_done(c->sheet);
 
 	/* Process pending imports */
@@ -318,6 +765,7 @@ static css_error nscss_convert_css_data(struct content_css_data *c)
 		error = nscss_register_imports(c);
 	} else if (error == CSS_OK) {
 		/* No imports, and no errors, so complete conversion */
+		nscss_sheet_insert(c);
 		c->done(c, c->pw);
 	} else {
 		const char *url;
@@ -343,6 +791,8 @@ void nscss_destroy(struct content *c)
 {
 	nscss_content *css = (nscss_content *) c;
 
+	guit->misc->schedule(-1, nscss_parse_callback, css);
+
 	nscss_destroy_css_data(&css->data);
 }
 
@@ -364,7 +814,16 @@ static void nscss_destroy_css_data(struct content_css_data *c)
 
 	free(c->imports);
 
-	if (c->sheet != NULL) {
+	if (c->selectors != NULL) {
+		bloom_destroy(c->selectors);
+		c->selectors = NULL;
+	}
+
+	if (c->entry != NULL) {
+		nscss_sheet_release(c->entry);
+		c->entry = NULL;
+		c->sheet = NULL;
+	} else if (c->sheet != NULL) {
 		css_stylesheet_destroy(c->sheet);
 		c->sheet = NULL;
 	}
@@ -376,8 +835,6 @@ nserror nscss_clone(const struct content *old, struct content **newc)
 {
 	const nscss_content *old_css = (const nscss_content *) old;
 	nscss_content *new_css;
-	const uint8_t *data;
-	size_t size;
 	nserror error;
 
 	new_css = calloc(1, sizeof(nscss_content));
@@ -391,7 +848,7 @@ nserror nscss_clone(const struct content *old, struct content **newc)
 		return error;
 	}
 
-	/* Simply replay create/process/convert */
+	/* Simply replay create/convert */
 	error = nscss_create_css_data(&new_css->data,
 			nsurl_access(content_get_url(&new_css->base)),
 			old_css->data.charset,
@@ -402,19 +859,10 @@ nserror nscss_clone(const struct content *old, struct content **newc)
 		return error;
 	}
 
-	data = content__get_source_data(&new_css->base, &size);
-	if (size > 0) {
-		if (nscss_process_data(&new_css->base,
-				       (char *)data,
-				       (unsigned int)size) == false) {
-			content_destroy(&new_css->base);
-			return NSERROR_CLONE_FAILED;
-		}
-	}
-
 	if (old->status == CONTENT_STATUS_READY ||
 			old->status == CONTENT_STATUS_DONE) {
-		if (nscss_convert(&new_css->base) == false) {
+		/* Old content is complete, so the clone must be too */
+		if (nscss_convert_source(new_css, SIZE_MAX) == false) {
 			content_destroy(&new_css->base);
 			return NSERROR_CLONE_FAILED;
 		}
@@ -453,6 +901,71 @@ struct nscss_import *nscss_get_imports(hlcache_handle *h, uint32_t *n)
 	return c->data.imports;
 }
 
+/**
+ * Search a stylesheet and its imports for a name used by selectors
+ *
+ * \param h      Stylesheet to search
+ * \param type   Kind of name
+ * \param hash   Hash of name
+ * \param depth  Depth of import
+ * \return false if the name is certainly unused else true
+ */
+static bool nscss_search_selectors(struct hlcache_handle *h,
+		enum nscss_selector_name type, uint32_t hash,
+		unsigned int depth)
+{
+	nscss_content *c = (nscss_content *) hlcache_handle_get_content(h);
+	uint32_t i;
+
+	if (c == NULL || c->data.selectors == NULL ||
+			depth > NSCSS_SELECTOR_IMPORT_DEPTH) {
+		return true;
+	}
+
+	if (bloom_search_hash(c->data.selectors, hash)) {
+		return true;
+	}
+
+	for (i = 0; i < c->data.import_count; i++) {
+		if (c->data.imports[i].c != NULL &&
+				nscss_search_selectors(c->data.imports[i].c,
+						type, hash, depth + 1)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* exported interface documented in css/css.h */
+bool nscss_selectors_use(struct hlcache_handle *h,
+		enum nscss_selector_name type, const char *name, size_t len)
+{
+	return nscss_search_selectors(h, type,
+			nscss_selector_hash(type, name, len), 0);
+}
+
+/* exported interface documented in css/css.h */
+bool nscss_selectors_use_siblings(struct hlcache_handle *h)
+{
+	nscss_content *c = (nscss_content *) hlcache_handle_get_content(h);
+	uint32_t i;
+
+	if (c == NULL || c->data.sibling_selectors) {
+		return true;
+	}
+
+	for (i = 0; i < c->data.import_count; i++) {
+		if (c->data.imports[i].c != NULL &&
+				nscss_selectors_use_siblings(
+						c->data.imports[i].c)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /**
  * Compute the type of a content
  *
@@ -785,11 +1298,221 @@ css_error nscss_register_import(struct content_css_data *c,
 	return error;
 }
 
+/*****************************************************************************
+ * Parsed stylesheet reuse                                                   *
+ *****************************************************************************/
+
+/**
+ * Remove a reusable parsed stylesheet from the list
+ *
+ * The entry is destroyed if no content is using it.
+ *
+ * \param entry  Entry to remove
+ */
+static void nscss_sheet_unlist(struct nscss_sheet_entry *entry)
+{
+	if (entry->prev != NULL)
+		entry->prev->next = entry->next;
+	else
+		sheet_entries = entry->next;
+
+	if (entry->next != NULL)
+		entry->next->prev = entry->prev;
+	else
+		sheet_entries_last = entry->prev;
+
+	entry->prev = entry->next = NULL;
+	entry->listed = false;
+	sheet_entries_size -= entry->size;
+
+	if (entry->users == 0) {
+		css_stylesheet_destroy(entry->sheet);
+		free(entry->source);
+		free(entry->url);
+		free(entry->charset);
+		free(entry);
+	}
+}
+
+/**
+ * Move a reusable parsed stylesheet to the head of the list
+ *
+ * \param entry  Entry to move
+ */
+static void nscss_sheet_touch(struct nscss_sheet_entry *entry)
+{
+	if (entry->prev == NULL)
+		return;
+
+	entry->prev->next = entry->next;
+	if (entry->next != NULL)
+		entry->next->prev = entry->prev;
+	else
+		sheet_entries_last = entry->prev;
+
+	entry->prev = NULL;
+	entry->next = sheet_entries;
+	sheet_entries->prev = entry;
+	sheet_entries = entry;
+}
+
+/**
+ * Find a reusable parse of a stylesheet's source
+ *
+ * On success the CSS data's own, empty, sheet is replaced by the
+ * reused sheet.
+ *
+ * \param c  CSS data which has all its source but has not been parsed
+ * \return true if a parsed sheet was found, false otherwise
+ */
+static bool nscss_sheet_reuse(struct content_css_data *c)
+{
+	struct nscss_sheet_entry *entry;
+	const char *url;
+	bool quirks;
+
+	if (css_stylesheet_get_url(c->sheet, &url) != CSS_OK ||
+	    css_stylesheet_quirks_allowed(c->sheet, &quirks) != CSS_OK) {
+		return false;
+	}
+
+	for (entry = sheet_entries; entry != NULL; entry = entry->next) {
+		if (entry->hash == c->source_hash &&
+		    entry->length == c->source_length &&
+		    memcmp(entry->source, c->source, c->source_length) == 0 &&
+		    entry->quirks == quirks &&
+		    strcmp(entry->url, url) == 0 &&
+		    ((entry->charset == NULL && c->charset == NULL) ||
+		     (entry->charset != NULL && c->charset != NULL &&
+		      strcmp(entry->charset, c->charset) == 0))) {
+			break;
+		}
+	}
+
+	if (entry == NULL) {
+		return false;
+	}
+
+	NSLOG(netsurf, DEBUG, "Reusing parsed sheet %p for %s",
+	      entry->sheet, url);
+
+	nscss_sheet_touch(entry);
+	entry->users++;
+
+	css_stylesheet_destroy(c->sheet);
+	c->sheet = entry->sheet;
+	c->entry = entry;
+
+	return true;
+}
+
+/**
+ * Make a newly parsed stylesheet available for reuse
+ *
+ * Only sheets without imports are reused, as imported sheets belong to
+ * the content which fetched them.
+ *
+ * A listed sheet's import handler private word still refers to the CSS
+ * data which parsed it and libcss cannot change it. libcss only calls
+ * the import handler while parsing, which is complete before a sheet
+ * is listed, so the sheet may safely outlive that content.
+ *
+ * \param c  CSS data whose sheet has been parsed without imports
+ */
+static void nscss_sheet_insert(struct content_css_data *c)
+{
+	struct nscss_sheet_entry *entry;
+	const char *url;
+	bool quirks;
+
+	if (c->source_length == 0 || c->import_count != 0 ||
+	    css_stylesheet_get_url(c->sheet, &url) != CSS_OK ||
+	    css_stylesheet_quirks_allowed(c->sheet, &quirks) != CSS_OK) {
+		return;
+	}
+
+	entry = calloc(1, sizeof(*entry));
+	if (entry == NULL) {
+		return;
+	}
+
+	/* The source is kept so a reuse is never made on a hash alone */
+	entry->source = malloc(c->source_length);
+	if (entry->source != NULL) {
+		memcpy(entry->source, c->source, c->source_length);
+	}
+	entry->url = strdup(url);
+	if (c->charset != NULL) {
+		entry->charset = strdup(c->charset);
+	}
+	if (entry->source == NULL ||
+	    entry->url == NULL ||
+	    (c->charset != NULL && entry->charset == NULL) ||
+	    css_stylesheet_size(c->sheet, &entry->size) != CSS_OK ||
+	    entry->size + c->source_length > NSCSS_SHEET_CACHE_SIZE) {
+		free(entry->source);
+		free(entry->url);
+		free(entry->charset);
+		free(entry);
+		return;
+	}
+
+	entry->size += c->source_length;
+	entry->hash = c->source_hash;
+	entry->length = c->source_length;
+	entry->quirks = quirks;
+	entry->sheet = c->sheet;
+	entry->users = 1;
+
+	entry->listed = true;
+	entry->next = sheet_entries;
+	if (sheet_entries != NULL)
+		sheet_entries->prev = entry;
+	else
+		sheet_entries_last = entry;
+	sheet_entries = entry;
+	sheet_entries_size += entry->size;
+
+	c->entry = entry;
+
+	/* Forget the least recently used sheets */
+	while (sheet_entries_size > NSCSS_SHEET_CACHE_SIZE &&
+	       sheet_entries_last != entry) {
+		nscss_sheet_unlist(sheet_entries_last);
+	}
+}
+
+/**
+ * Stop using a reusable parsed stylesheet
+ *
+ * \param entry  Entry of sheet which is no longer used by a content
+ */
+static void nscss_sheet_release(struct nscss_sheet_entry *entry)
+{
+	assert(entry->users > 0);
+
+	entry->users--;
+
+	if (entry->users == 0 && entry->listed == false) {
+		css_stylesheet_destroy(entry->sheet);
+		free(entry->source);
+		free(entry->url);
+		free(entry->charset);
+		free(entry);
+	}
+}
+
 /**
  * Clean up after the CSS content handler
  */
 static void nscss_fini(void)
 {
+	while (sheet_entries != NULL) {
+		/* hlcache_finalise() has destroyed every content */
+		assert(sheet_entries->users == 0);
+		nscss_sheet_unlist(sheet_entries);
+	}
+
 	if (blank_import != NULL) {
 		css_stylesheet_destroy(blank_import);
 		blank_import = NULL;
@@ -800,7 +1523,6 @@ static void nscss_fini(void)
 static const content_handler css_content_handler = {
 	.fini = nscss_fini,
 	.create = nscss_create,
-	.process_data = nscss_process_data,
 	.data_complete = nscss_convert,
 	.destroy = nscss_destroy,
 	.clone = nscss_clone,
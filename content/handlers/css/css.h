@@ -19,6 +19,7 @@
 #ifndef netsurf_css_css_h_
 #define netsurf_css_css_h_
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include <libcss/libcss.h>
@@ -34,6 +35,15 @@ struct nscss_import {
 	struct hlcache_handle *c;	/**< Content containing sheet */
 };
 
+/**
+ * Kinds of name used by selectors
+ */
+enum nscss_selector_name {
+	NSCSS_SELECTOR_CLASS,		/**< Class name */
+	NSCSS_SELECTOR_ID,		/**< Element id */
+	NSCSS_SELECTOR_ATTRIBUTE	/**< Attribute name */
+};
+
 /**
  * Initialise the CSS content handler
  *
@@ -58,4 +68,27 @@ css_stylesheet *nscss_get_stylesheet(struct hlcache_handle *h);
  */
 struct nscss_import *nscss_get_imports(struct hlcache_handle *h, uint32_t *n);
 
+/**
+ * Determine if the selectors of a stylesheet may use a name
+ *
+ * The stylesheet's imports are also searched. False positives are
+ * possible, in particular for names differing only in case.
+ *
+ * \param h     Stylesheet to search
+ * \param type  Kind of name
+ * \param name  The name
+ * \param len   Length of name in bytes
+ * \return false if no selector uses the name else true
+ */
+bool nscss_selectors_use(struct hlcache_handle *h,
+		enum nscss_selector_name type, const char *name, size_t len);
+
+/**
+ * Determine if the selectors of a stylesheet may use sibling combinators
+ *
+ * \param h  Stylesheet to search
+ * \return false if no selector uses sibling combinators else true
+ */
+bool nscss_selectors_use_siblings(struct hlcache_handle *h);
+
 #endif
@@ -1580,112 +1580,382 @@ static void css_hint_white_space_nowrap(
 }
 
 
+/**
+ * Attributes presentational hints are taken from
+ *
+ * The order must match enum css_hint_attr.
+ */
+static dom_string **css_hint_attributes[] = {
+	&corestring_dom_align,
+	&corestring_dom_background,
+	&corestring_dom_bgcolor,
+	&corestring_dom_border,
+	&corestring_dom_bordercolor,
+	&corestring_dom_cellpadding,
+	&corestring_dom_cellspacing,
+	&corestring_dom_color,
+	&corestring_dom_cols,
+	&corestring_dom_height,
+	&corestring_dom_hspace,
+	&corestring_dom_link,
+	&corestring_dom_nowrap,
+	&corestring_dom_rows,
+	&corestring_dom_size,
+	&corestring_dom_text,
+	&corestring_dom_type,
+	&corestring_dom_valign,
+	&corestring_dom_vlink,
+	&corestring_dom_vspace,
+	&corestring_dom_width,
+};
+
+/**
+ * Indices of attributes in css_hint_attributes
+ */
+enum css_hint_attr {
+	HINT_ATTR_ALIGN,
+	HINT_ATTR_BACKGROUND,
+	HINT_ATTR_BGCOLOR,
+	HINT_ATTR_BORDER,
+	HINT_ATTR_BORDERCOLOR,
+	HINT_ATTR_CELLPADDING,
+	HINT_ATTR_CELLSPACING,
+	HINT_ATTR_COLOR,
+	HINT_ATTR_COLS,
+	HINT_ATTR_HEIGHT,
+	HINT_ATTR_HSPACE,
+	HINT_ATTR_LINK,
+	HINT_ATTR_NOWRAP,
+	HINT_ATTR_ROWS,
+	HINT_ATTR_SIZE,
+	HINT_ATTR_TEXT,
+	HINT_ATTR_TYPE,
+	HINT_ATTR_VALIGN,
+	HINT_ATTR_VLINK,
+	HINT_ATTR_VSPACE,
+	HINT_ATTR_WIDTH,
+};
+
+/** Mask bit for an attribute in css_hint_attributes */
+#define HINT(a) (1u << HINT_ATTR_##a)
+
+/**
+ * A presentational hint handler
+ */
+struct css_hint_handler {
+	/** Function adding the hints */
+	void (*hint)(nscss_select_ctx *ctx, dom_node *node);
+	/**
+	 * Mask of the element's own attributes the hints are taken from.
+	 * Zero for handlers which must always be run, either because
+	 * they apply unconditionally or use attributes of other elements.
+	 */
+	uint32_t attrs;
+};
+
+static const struct css_hint_handler css_hints_table_cell[] = {
+	{ css_hint_width, HINT(WIDTH) },
+	{ css_hint_table_cell_border_padding, 0 },
+	{ css_hint_white_space_nowrap, HINT(NOWRAP) },
+	{ css_hint_height, HINT(HEIGHT) },
+	{ css_hint_text_align_special, HINT(ALIGN) },
+	{ css_hint_vertical_align_table_cells, HINT(VALIGN) },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_table_row[] = {
+	{ css_hint_height, HINT(HEIGHT) },
+	{ css_hint_text_align_special, HINT(ALIGN) },
+	{ css_hint_vertical_align_table_cells, HINT(VALIGN) },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_table_section[] = {
+	{ css_hint_text_align_special, HINT(ALIGN) },
+	{ css_hint_vertical_align_table_cells, HINT(VALIGN) },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_table_col[] = {
+	{ css_hint_vertical_align_table_cells, HINT(VALIGN) },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_image[] = {
+	{ css_hint_margin_hspace_vspace, HINT(HSPACE) | HINT(VSPACE) },
+	{ css_hint_height, HINT(HEIGHT) },
+	{ css_hint_width, HINT(WIDTH) },
+	{ css_hint_vertical_align_replaced, HINT(VALIGN) },
+	{ css_hint_float, HINT(ALIGN) },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_replaced[] = {
+	{ css_hint_height, HINT(HEIGHT) },
+	{ css_hint_width, HINT(WIDTH) },
+	{ css_hint_vertical_align_replaced, HINT(VALIGN) },
+	{ css_hint_float, HINT(ALIGN) },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_paragraph[] = {
+	{ css_hint_text_align_normal, HINT(ALIGN) },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_center[] = {
+	{ css_hint_text_align_center, 0 },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_caption[] = {
+	{ css_hint_caption_side, HINT(ALIGN) },
+	{ css_hint_text_align_special, HINT(ALIGN) },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_div[] = {
+	{ css_hint_text_align_special, HINT(ALIGN) },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_table[] = {
+	{ css_hint_text_align_table_special, 0 },
+	{ css_hint_table_spacing_border,
+	  HINT(BORDER) | HINT(BORDERCOLOR) | HINT(CELLSPACING) },
+	{ css_hint_float, HINT(ALIGN) },
+	{ css_hint_margin_left_right_align_center, HINT(ALIGN) },
+	{ css_hint_width, HINT(WIDTH) },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_hr[] = {
+	{ css_hint_width, HINT(WIDTH) },
+	{ css_hint_margin_left_right_hr, HINT(ALIGN) },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_textarea[] = {
+	{ css_hint_height_width_textarea, HINT(ROWS) | HINT(COLS) },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_input[] = {
+	{ css_hint_width_input, HINT(SIZE) },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_anchor[] = {
+	{ css_hint_anchor_color, 0 },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_font[] = {
+	{ css_hint_font_size, HINT(SIZE) },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_body[] = {
+	{ css_hint_body_color, HINT(TEXT) },
+	{ NULL, 0 }
+};
+
+static const struct css_hint_handler css_hints_canvas[] = {
+	{ css_hint_height_width_canvas, HINT(HEIGHT) | HINT(WIDTH) },
+	{ NULL, 0 }
+};
+
+/** Handlers run for every known element type after the per type ones */
+static const struct css_hint_handler css_hints_common[] = {
+	{ css_hint_color, HINT(COLOR) },
+	{ css_hint_bg_color, HINT(BGCOLOR) },
+	{ css_hint_bg_image, HINT(BACKGROUND) },
+	{ NULL, 0 }
+};
+
+/**
+ * Per element type presentational hint handlers
+ */
+static const struct css_hint_handler *
+css_hint_handlers[DOM_HTML_ELEMENT_TYPE__COUNT] = {
+	[DOM_HTML_ELEMENT_TYPE_TH] = css_hints_table_cell,
+	[DOM_HTML_ELEMENT_TYPE_TD] = css_hints_table_cell,
+	[DOM_HTML_ELEMENT_TYPE_TR] = css_hints_table_row,
+	[DOM_HTML_ELEMENT_TYPE_THEAD] = css_hints_table_section,
+	[DOM_HTML_ELEMENT_TYPE_TBODY] = css_hints_table_section,
+	[DOM_HTML_ELEMENT_TYPE_TFOOT] = css_hints_table_section,
+	[DOM_HTML_ELEMENT_TYPE_COL] = css_hints_table_col,
+	[DOM_HTML_ELEMENT_TYPE_APPLET] = css_hints_image,
+	[DOM_HTML_ELEMENT_TYPE_IMG] = css_hints_image,
+	[DOM_HTML_ELEMENT_TYPE_EMBED] = css_hints_replaced,
+	[DOM_HTML_ELEMENT_TYPE_IFRAME] = css_hints_replaced,
+	[DOM_HTML_ELEMENT_TYPE_OBJECT] = css_hints_replaced,
+	[DOM_HTML_ELEMENT_TYPE_P] = css_hints_paragraph,
+	[DOM_HTML_ELEMENT_TYPE_H1] = css_hints_paragraph,
+	[DOM_HTML_ELEMENT_TYPE_H2] = css_hints_paragraph,
+	[DOM_HTML_ELEMENT_TYPE_H3] = css_hints_paragraph,
+	[DOM_HTML_ELEMENT_TYPE_H4] = css_hints_paragraph,
+	[DOM_HTML_ELEMENT_TYPE_H5] = css_hints_paragraph,
+	[DOM_HTML_ELEMENT_TYPE_H6] = css_hints_paragraph,
+	[DOM_HTML_ELEMENT_TYPE_CENTER] = css_hints_center,
+	[DOM_HTML_ELEMENT_TYPE_CAPTION] = css_hints_caption,
+	[DOM_HTML_ELEMENT_TYPE_DIV] = css_hints_div,
+	[DOM_HTML_ELEMENT_TYPE_TABLE] = css_hints_table,
+	[DOM_HTML_ELEMENT_TYPE_HR] = css_hints_hr,
+	[DOM_HTML_ELEMENT_TYPE_TEXTAREA] = css_hints_textarea,
+	[DOM_HTML_ELEMENT_TYPE_INPUT] = css_hints_input,
+	[DOM_HTML_ELEMENT_TYPE_A] = css_hints_anchor,
+	[DOM_HTML_ELEMENT_TYPE_FONT] = css_hints_font,
+	[DOM_HTML_ELEMENT_TYPE_BODY] = css_hints_body,
+	[DOM_HTML_ELEMENT_TYPE_CANVAS] = css_hints_canvas,
+};
+
+
+/**
+ * Find which hint attributes an element has.
+ *
+ * The attribute list is walked once so hint handlers for attributes
+ * the element does not have need not look them up individually.
+ *
+ * \param node The element to examine.
+ * \return mask of attributes present, all set on error.
+ */
+static uint32_t css_hint_attribute_mask(dom_node *node)
+{
+	dom_namednodemap *attrs;
+	dom_exception exc;
+	dom_ulong num_attrs;
+	dom_ulong idx;
+	unsigned int i;
+	uint32_t mask = 0;
+	bool has_attrs;
+
+	exc = dom_node_has_attributes(node, &has_attrs);
+	if (exc != DOM_NO_ERR) {
+		return UINT32_MAX;
+	}
+	if (has_attrs == false) {
+		return 0;
+	}
+
+	exc = dom_node_get_attributes(node, &attrs);
+	if ((exc != DOM_NO_ERR) || (attrs == NULL)) {
+		return UINT32_MAX;
+	}
+
+	exc = dom_namednodemap_get_length(attrs, &num_attrs);
+	if (exc != DOM_NO_ERR) {
+		dom_namednodemap_unref(attrs);
+		return UINT32_MAX;
+	}
+
+	for (idx = 0; idx < num_attrs; idx++) {
+		dom_attr *attr;
+		dom_string *name;
+
+		exc = dom_namednodemap_item(attrs, idx, (void *) &attr);
+		if ((exc != DOM_NO_ERR) || (attr == NULL)) {
+			mask = UINT32_MAX;
+			break;
+		}
+
+		exc = dom_attr_get_name(attr, &name);
+		dom_node_unref(attr);
+		if (exc != DOM_NO_ERR) {
+			mask = UINT32_MAX;
+			break;
+		}
+
+		for (i = 0; i < NOF_ELEMENTS(css_hint_attributes); i++) {
+			if (dom_string_caseless_isequal(name,
+					*css_hint_attributes[i])) {
+				mask |= (1u << i);
+				break;
+			}
+		}
+		dom_string_unref(name);
+	}
+
+	dom_namednodemap_unref(attrs);
+
+	return mask;
+}
+
+
+/**
+ * Run presentational hint handlers for an element.
+ *
+ * \param ctx The selection context.
+ * \param node The element.
+ * \param handler NULL terminated list of handlers.
+ * \param mask The hint attributes the element has.
+ */
+static inline void css_hint_dispatch(
+		nscss_select_ctx *ctx,
+		dom_node *node,
+		const struct css_hint_handler *handler,
+		uint32_t mask)
+{
+	for (; handler->hint != NULL; handler++) {
+		if ((handler->attrs == 0) || ((handler->attrs & mask) != 0)) {
+			handler->hint(ctx, node);
+		}
+	}
+}
+
+
 /* Exported function, documeted in css/hints.h */
 css_error node_presentational_hint(void *pw, void *node,
 		uint32_t *nhints, css_hint **hints)
 {
 	dom_exception exc;
 	dom_html_element_type tag_type;
+	const struct css_hint_handler *handlers;
+	uint32_t mask;
 
 	css_hint_clean();
 
 	exc = dom_html_element_get_tag_type(node, &tag_type);
-	if (exc != DOM_NO_ERR) {
-		tag_type = DOM_HTML_ELEMENT_TYPE__UNKNOWN;
+	if ((exc != DOM_NO_ERR) ||
+	    (tag_type >= DOM_HTML_ELEMENT_TYPE__UNKNOWN)) {
+		/* no hints for unknown elements */
+		css_hint_get_hints(hints, nhints);
+		return CSS_OK;
 	}
 
-	switch (tag_type) {
-	case DOM_HTML_ELEMENT_TYPE_TH:
-	case DOM_HTML_ELEMENT_TYPE_TD:
-		css_hint_width(pw, node);
-		css_hint_table_cell_border_padding(pw, node);
-		css_hint_white_space_nowrap(pw, node);
-		/* fall through */
-	case DOM_HTML_ELEMENT_TYPE_TR:
-		css_hint_height(pw, node);
-		/* fall through */
-	case DOM_HTML_ELEMENT_TYPE_THEAD:
-	case DOM_HTML_ELEMENT_TYPE_TBODY:
-	case DOM_HTML_ELEMENT_TYPE_TFOOT:
-		css_hint_text_align_special(pw, node);
-		/* fall through */
-	case DOM_HTML_ELEMENT_TYPE_COL:
-		css_hint_vertical_align_table_cells(pw, node);
-		break;
-	case DOM_HTML_ELEMENT_TYPE_APPLET:
-	case DOM_HTML_ELEMENT_TYPE_IMG:
-		css_hint_margin_hspace_vspace(pw, node);
-		/* fall through */
-	case DOM_HTML_ELEMENT_TYPE_EMBED:
-	case DOM_HTML_ELEMENT_TYPE_IFRAME:
-	case DOM_HTML_ELEMENT_TYPE_OBJECT:
-		css_hint_height(pw, node);
-		css_hint_width(pw, node);
-		css_hint_vertical_align_replaced(pw, node);
-		css_hint_float(pw, node);
-		break;
-	case DOM_HTML_ELEMENT_TYPE_P:
-	case DOM_HTML_ELEMENT_TYPE_H1:
-	case DOM_HTML_ELEMENT_TYPE_H2:
-	case DOM_HTML_ELEMENT_TYPE_H3:
-	case DOM_HTML_ELEMENT_TYPE_H4:
-	case DOM_HTML_ELEMENT_TYPE_H5:
-	case DOM_HTML_ELEMENT_TYPE_H6:
-		css_hint_text_align_normal(pw, node);
-		break;
-	case DOM_HTML_ELEMENT_TYPE_CENTER:
-		css_hint_text_align_center(pw, node);
-		break;
-	case DOM_HTML_ELEMENT_TYPE_CAPTION:
-		css_hint_caption_side(pw, node);
-		/* fall through */
-	case DOM_HTML_ELEMENT_TYPE_DIV:
-		css_hint_text_align_special(pw, node);
-		break;
-	case DOM_HTML_ELEMENT_TYPE_TABLE:
-		css_hint_text_align_table_special(pw, node);
-		css_hint_table_spacing_border(pw, node);
-		css_hint_float(pw, node);
-		css_hint_margin_left_right_align_center(pw, node);
-		css_hint_width(pw, node);
-		break;
-	case DOM_HTML_ELEMENT_TYPE_HR:
-		css_hint_width(pw, node);
-		css_hint_margin_left_right_hr(pw, node);
-		break;
-	case DOM_HTML_ELEMENT_TYPE_TEXTAREA:
-		css_hint_height_width_textarea(pw, node);
-		break;
-	case DOM_HTML_ELEMENT_TYPE_INPUT:
-		css_hint_width_input(pw, node);
-		break;
-	case DOM_HTML_ELEMENT_TYPE_A:
-		css_hint_anchor_color(pw, node);
-		break;
-	case DOM_HTML_ELEMENT_TYPE_FONT:
-		css_hint_font_size(pw, node);
-		break;
-	case DOM_HTML_ELEMENT_TYPE_BODY:
-		css_hint_body_color(pw, node);
-		break;
-	case DOM_HTML_ELEMENT_TYPE_CANVAS:
-		css_hint_height_width_canvas(pw, node);
-		break;
-	default:
-		break;
-	}
+	handlers = css_hint_handlers[tag_type];
+	mask = css_hint_attribute_mask(node);
 
-	if (tag_type != DOM_HTML_ELEMENT_TYPE__UNKNOWN) {
-		css_hint_color(pw, node);
-		css_hint_bg_color(pw, node);
-		css_hint_bg_image(pw, node);
+	if (handlers != NULL) {
+		css_hint_dispatch(pw, node, handlers, mask);
+	}
+	if (mask != 0) {
+		/* the common hints are all taken from attributes */
+		css_hint_dispatch(pw, node, css_hints_common, mask);
 	}
 
 #ifdef LOG_STATS
-	NSLOG(netsurf, INFO, "Properties with hints: %i", hint_ctx.len);
+	NSLOG(netsurf, INFO, "Properties with hints: %i (attributes %x)",
+	      hint_ctx.len, mask);
 #endif
 
 	css_hint_get_hints(hints, nhints);
 
 	return CSS_OK;
 }
+
+
+/* exported interface documented in css/hints.h */
+bool css_hint_attribute(dom_string *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < NOF_ELEMENTS(css_hint_attributes); i++) {
+		if (dom_string_caseless_isequal(name,
+				*css_hint_attributes[i])) {
+			return true;
+		}
+	}
+
+	return false;
+}
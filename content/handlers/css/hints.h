@@ -22,6 +22,7 @@
 #include <stdint.h>
 
 #include <libcss/libcss.h>
+#include <dom/dom.h>
 
 nserror css_hint_init(void);
 void css_hint_fini(void);
@@ -43,6 +44,14 @@ css_error node_presentational_hint(
 		uint32_t *nhints,
 		css_hint **hints);
 
+/**
+ * Determine if presentational hints may be taken from an attribute
+ *
+ * \param name The attribute name
+ * \return true if hints may depend on the attribute
+ */
+bool css_hint_attribute(dom_string *name);
+
 /**
  * Parser for colours specified in attribute values.
  *
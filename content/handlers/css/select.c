@@ -17,15 +17,18 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include <strings.h>
 
 #include "utils/nsoption.h"
+#include "utils/ascii.h"
 #include "utils/corestrings.h"
 #include "utils/log.h"
 #include "utils/nsurl.h"
 #include "netsurf/plot_style.h"
 #include "netsurf/url_db.h"
+#include "content/urldb.h"
 #include "desktop/system_colour.h"
 
 #include "css/internal.h"
@@ -244,6 +247,730 @@ static void nscss_dom_user_data_handler(dom_node_operation operation,
 	}
 }
 
+/**
+ * Number of entries in the sibling count cache.
+ */
+#define SIBLING_CACHE_SIZE 256
+
+/**
+ * Cached sibling count of an element.
+ *
+ * Style selection visits siblings in document order so the count for
+ * an element can almost always be derived from the count of its
+ * previous element sibling instead of walking all its siblings again.
+ */
+struct sibling_count {
+	dom_node *node; /**< Element the count is for */
+	uint32_t generation; /**< Cache generation entry was made in */
+	bool same_name; /**< Count is of siblings with the same name */
+	bool after; /**< Count is of following siblings */
+	int32_t count; /**< The count */
+};
+
+/** Sibling count cache, direct mapped on element */
+static struct sibling_count sibling_cache[SIBLING_CACHE_SIZE];
+
+/** Current sibling count cache generation, zero is never valid */
+static uint32_t sibling_cache_generation = 1;
+
+/* exported interface documented in css/select.h */
+void nscss_select_invalidate_siblings(void)
+{
+	sibling_cache_generation++;
+	if (sibling_cache_generation == 0) {
+		sibling_cache_generation = 1;
+	}
+}
+
+/**
+ * Get the previous element sibling of a node.
+ *
+ * \param n  DOM node
+ * \return The previous element sibling with a reference or NULL if none.
+ */
+static dom_node *node_previous_element(dom_node *n)
+{
+	dom_node *node = dom_node_ref(n);
+	dom_node *prev;
+	dom_node_type type;
+	dom_exception exc;
+
+	do {
+		exc = dom_node_get_previous_sibling(node, &prev);
+		dom_node_unref(node);
+		if (exc != DOM_NO_ERR)
+			return NULL;
+
+		node = prev;
+		if (node == NULL)
+			return NULL;
+
+		exc = dom_node_get_node_type(node, &type);
+	} while ((exc == DOM_NO_ERR) && (type != DOM_ELEMENT_NODE));
+
+	if (exc != DOM_NO_ERR) {
+		dom_node_unref(node);
+		return NULL;
+	}
+
+	return node;
+}
+
+/**
+ * Number of entries in the style sharing cache.
+ */
+#define SHARE_CACHE_SIZE 64
+
+/**
+ * Style sharing cache entry.
+ *
+ * Records the partial (uncomposed) style selected for an element so
+ * that following siblings which cannot be distinguished from it by any
+ * selector can reuse it without running the cascade.
+ */
+struct share_entry {
+	dom_node *node; /**< Element the style was selected for */
+	uint32_t generation; /**< Cache generation entry was made in */
+	css_select_ctx *select_ctx; /**< Selection context used */
+	const css_media *media; /**< Media used */
+	const css_computed_style *parent_style; /**< Parent style used */
+	const css_computed_style *root_style; /**< Root style used */
+	css_computed_style *partial; /**< Partial style, owned by entry */
+};
+
+/** Style sharing cache, direct mapped on element */
+static struct share_entry share_cache[SHARE_CACHE_SIZE];
+
+/** Element style is currently being selected for */
+static dom_node *select_node;
+
+/**
+ * Whether the selection in progress depends on the element's position
+ * among its siblings or on its children.
+ */
+static bool select_node_tainted;
+
+/**
+ * Selection callbacks counted in the selection statistics
+ *
+ * The order must match select_callback_name.
+ */
+enum select_callback {
+	SELECT_CB_NODE_NAME,
+	SELECT_CB_NODE_CLASSES,
+	SELECT_CB_NODE_ID,
+	SELECT_CB_NAMED_ANCESTOR_NODE,
+	SELECT_CB_NAMED_PARENT_NODE,
+	SELECT_CB_NAMED_SIBLING_NODE,
+	SELECT_CB_NAMED_GENERIC_SIBLING_NODE,
+	SELECT_CB_PARENT_NODE,
+	SELECT_CB_SIBLING_NODE,
+	SELECT_CB_NODE_HAS_NAME,
+	SELECT_CB_NODE_HAS_CLASS,
+	SELECT_CB_NODE_HAS_ID,
+	SELECT_CB_NODE_HAS_ATTRIBUTE,
+	SELECT_CB_NODE_HAS_ATTRIBUTE_EQUAL,
+	SELECT_CB_NODE_HAS_ATTRIBUTE_DASHMATCH,
+	SELECT_CB_NODE_HAS_ATTRIBUTE_INCLUDES,
+	SELECT_CB_NODE_HAS_ATTRIBUTE_PREFIX,
+	SELECT_CB_NODE_HAS_ATTRIBUTE_SUFFIX,
+	SELECT_CB_NODE_HAS_ATTRIBUTE_SUBSTRING,
+	SELECT_CB_NODE_IS_ROOT,
+	SELECT_CB_NODE_COUNT_SIBLINGS,
+	SELECT_CB_NODE_IS_EMPTY,
+	SELECT_CB_NODE_IS_LINK,
+	SELECT_CB_NODE_IS_VISITED,
+	SELECT_CB_NODE_IS_HOVER,
+	SELECT_CB_NODE_IS_ACTIVE,
+	SELECT_CB_NODE_IS_FOCUS,
+	SELECT_CB_NODE_IS_ENABLED,
+	SELECT_CB_NODE_IS_DISABLED,
+	SELECT_CB_NODE_IS_CHECKED,
+	SELECT_CB_NODE_IS_TARGET,
+	SELECT_CB_NODE_IS_LANG,
+	SELECT_CB__COUNT
+};
+
+/** Names of counted selection callbacks */
+static const char *select_callback_name[SELECT_CB__COUNT] = {
+	"node_name",
+	"node_classes",
+	"node_id",
+	"named_ancestor_node",
+	"named_parent_node",
+	"named_sibling_node",
+	"named_generic_sibling_node",
+	"parent_node",
+	"sibling_node",
+	"node_has_name",
+	"node_has_class",
+	"node_has_id",
+	"node_has_attribute",
+	"node_has_attribute_equal",
+	"node_has_attribute_dashmatch",
+	"node_has_attribute_includes",
+	"node_has_attribute_prefix",
+	"node_has_attribute_suffix",
+	"node_has_attribute_substring",
+	"node_is_root",
+	"node_count_siblings",
+	"node_is_empty",
+	"node_is_link",
+	"node_is_visited",
+	"node_is_hover",
+	"node_is_active",
+	"node_is_focus",
+	"node_is_enabled",
+	"node_is_disabled",
+	"node_is_checked",
+	"node_is_target",
+	"node_is_lang",
+};
+
+/**
+ * Style selection statistics
+ */
+struct nscss_select_stats {
+	unsigned int elements; /**< Elements styles were requested for */
+	unsigned int shared; /**< Elements which were given a shared style */
+	unsigned int ancestor_searches; /**< Named ancestor searches */
+	unsigned int ancestor_rejects; /**< Searches rejected by filter */
+	unsigned int callback[SELECT_CB__COUNT]; /**< Callback invocations */
+};
+
+/** Statistics of the selection in progress, or NULL */
+static struct nscss_select_stats *select_stats;
+
+/** Count an invocation of a selection callback */
+#define SELECT_CALLBACK(cb)						\
+	do {								\
+		if (select_stats != NULL)				\
+			select_stats->callback[SELECT_CB_##cb]++;	\
+	} while (0)
+
+/**
+ * Note that selection depends on the structure around a node.
+ *
+ * \param node The node whose siblings or children are being examined.
+ */
+static inline void select_taint(void *node)
+{
+	if (node == select_node) {
+		select_node_tainted = true;
+	}
+}
+
+/**
+ * Number of counters in the ancestor filter.
+ */
+#define ANCESTOR_FILTER_SIZE 1024
+
+/**
+ * Maximum depth of ancestor chain the ancestor filter tracks.
+ */
+#define ANCESTOR_FILTER_DEPTH 256
+
+/**
+ * Counting bloom filter of the element names of the ancestors of the
+ * element being selected for.
+ *
+ * Selection visits elements in document order so the ancestor chain
+ * is kept as a stack which is adjusted to each element's parent by
+ * pushing and popping only the elements which differ.
+ *
+ * Any node libcss asks for the ancestors of while selecting for an
+ * element is that element, one of its ancestors or a sibling of
+ * either, so a name absent from the filter cannot be the name of any
+ * ancestor it asks about.
+ */
+struct ancestor_filter {
+	uint32_t generation; /**< Cache generation stack was built in */
+	unsigned int depth; /**< Number of ancestors in stack */
+	bool valid; /**< Whether the filter may be used */
+	dom_node *node[ANCESTOR_FILTER_DEPTH]; /**< Ancestor stack */
+	uint32_t hash[ANCESTOR_FILTER_DEPTH]; /**< Name hashes of stack */
+	uint8_t count[ANCESTOR_FILTER_SIZE]; /**< Filter counters */
+};
+
+/** Ancestor filter for the element being selected for */
+static struct ancestor_filter ancestor_filter;
+
+/**
+ * Hash an element name ignoring case.
+ *
+ * \param data  The name
+ * \param len   Length of name
+ * \return The hash.
+ */
+static uint32_t ancestor_filter_hash(const char *data, size_t len)
+{
+	uint32_t hash = 0x811c9dc5;
+
+	while (len-- > 0) {
+		hash ^= (uint8_t) ascii_to_lower(*data++);
+		hash *= 0x01000193;
+	}
+
+	return hash;
+}
+
+static inline void ancestor_filter_add(uint32_t hash, int delta)
+{
+	unsigned int probe[2];
+	unsigned int idx;
+
+	probe[0] = hash % ANCESTOR_FILTER_SIZE;
+	probe[1] = (hash >> 16) % ANCESTOR_FILTER_SIZE;
+
+	for (idx = 0; idx < 2; idx++) {
+		uint8_t *counter = &ancestor_filter.count[probe[idx]];
+
+		/* saturated counters stay saturated */
+		if (*counter != UINT8_MAX) {
+			*counter += delta;
+		}
+	}
+}
+
+/**
+ * Push an element onto the ancestor stack.
+ *
+ * \param n  The element.
+ * \return true on success, false if the stack is full or on error.
+ */
+static bool ancestor_filter_push(dom_node *n)
+{
+	dom_string *name;
+	dom_exception exc;
+	uint32_t hash;
+
+	if (ancestor_filter.depth == ANCESTOR_FILTER_DEPTH)
+		return false;
+
+	exc = dom_node_get_node_name(n, &name);
+	if ((exc != DOM_NO_ERR) || (name == NULL))
+		return false;
+
+	hash = ancestor_filter_hash(dom_string_data(name),
+			dom_string_byte_length(name));
+	dom_string_unref(name);
+
+	ancestor_filter.node[ancestor_filter.depth] = n;
+	ancestor_filter.hash[ancestor_filter.depth] = hash;
+	ancestor_filter.depth++;
+	ancestor_filter_add(hash, 1);
+
+	return true;
+}
+
+/**
+ * Rebuild the ancestor stack from scratch.
+ *
+ * \param parent  The parent of the element being selected for.
+ */
+static void ancestor_filter_rebuild(dom_node *parent)
+{
+	dom_node *chain[ANCESTOR_FILTER_DEPTH];
+	dom_node *node, *next;
+	dom_node_type type;
+	dom_exception exc;
+	unsigned int length = 0;
+	bool too_deep = false;
+
+	memset(&ancestor_filter.count, 0, sizeof(ancestor_filter.count));
+	ancestor_filter.depth = 0;
+	ancestor_filter.valid = false;
+	ancestor_filter.generation = sibling_cache_generation;
+
+	/* collect the element ancestors, nearest first */
+	node = dom_node_ref(parent);
+	while (node != NULL) {
+		exc = dom_node_get_node_type(node, &type);
+		if ((exc != DOM_NO_ERR) || (type != DOM_ELEMENT_NODE)) {
+			break;
+		}
+		if (length == ANCESTOR_FILTER_DEPTH) {
+			too_deep = true;
+			break;
+		}
+		chain[length++] = node;
+
+		exc = dom_node_get_parent_node(node, &next);
+		if (exc != DOM_NO_ERR) {
+			node = NULL;
+			break;
+		}
+		node = next;
+	}
+
+	if (node != NULL) {
+		dom_node_unref(node);
+	}
+
+	/* the filter cannot be used if the chain is too deep to track */
+	ancestor_filter.valid = !too_deep;
+	while (length > 0) {
+		length--;
+		if (ancestor_filter.valid) {
+			ancestor_filter.valid = ancestor_filter_push(chain[length]);
+		}
+		dom_node_unref(chain[length]);
+	}
+}
+
+/**
+ * Update the ancestor filter for selection of an element.
+ *
+ * \param n  The element about to be selected for.
+ */
+static void ancestor_filter_update(dom_node *n)
+{
+	dom_node *parent, *grandparent = NULL;
+	dom_exception exc;
+	unsigned int depth;
+
+	exc = dom_node_get_parent_node(n, &parent);
+	if ((exc != DOM_NO_ERR) || (parent == NULL)) {
+		ancestor_filter.valid = false;
+		return;
+	}
+
+	if (ancestor_filter.valid &&
+	    ancestor_filter.generation == sibling_cache_generation) {
+		/* look for the parent in the stack, popping any
+		 * ancestors of previous elements on the way */
+		for (depth = ancestor_filter.depth; depth > 0; depth--) {
+			if (ancestor_filter.node[depth - 1] == parent)
+				break;
+		}
+
+		if (depth == 0) {
+			/* not in stack; is it a child of the top? */
+			exc = dom_node_get_parent_node(parent, &grandparent);
+			if (exc != DOM_NO_ERR)
+				grandparent = NULL;
+			for (depth = ancestor_filter.depth; depth > 0; depth--) {
+				if (ancestor_filter.node[depth - 1] ==
+				    grandparent)
+					break;
+			}
+			if (grandparent != NULL)
+				dom_node_unref(grandparent);
+		}
+
+		if (depth > 0) {
+			while (ancestor_filter.depth > depth) {
+				ancestor_filter.depth--;
+				ancestor_filter_add(ancestor_filter.hash[
+						ancestor_filter.depth], -1);
+			}
+			if (ancestor_filter.node[depth - 1] != parent) {
+				ancestor_filter.valid =
+					ancestor_filter_push(parent);
+			}
+			dom_node_unref(parent);
+			return;
+		}
+	}
+
+	ancestor_filter_rebuild(parent);
+	dom_node_unref(parent);
+}
+
+/**
+ * Check whether an ancestor of the element being selected for may have
+ * the given name.
+ *
+ * \param name  Element name to search for
+ * \return false if no ancestor has the name, true if one may have.
+ */
+static bool ancestor_filter_maybe(lwc_string *name)
+{
+	uint32_t hash;
+
+	if (select_node == NULL || ancestor_filter.valid == false) {
+		return true;
+	}
+
+	if (select_stats != NULL) {
+		select_stats->ancestor_searches++;
+	}
+
+	hash = ancestor_filter_hash(lwc_string_data(name),
+			lwc_string_length(name));
+
+	if (ancestor_filter.count[hash % ANCESTOR_FILTER_SIZE] == 0 ||
+	    ancestor_filter.count[(hash >> 16) % ANCESTOR_FILTER_SIZE] == 0) {
+		if (select_stats != NULL) {
+			select_stats->ancestor_rejects++;
+		}
+		return false;
+	}
+
+	return true;
+}
+
+static inline struct share_entry *share_cache_entry(dom_node *node)
+{
+	uintptr_t hash = (uintptr_t) node;
+
+	hash = (hash >> 4) ^ (hash >> 10);
+
+	return &share_cache[hash % SHARE_CACHE_SIZE];
+}
+
+/**
+ * Release the style held by a style sharing cache entry.
+ *
+ * \param entry The entry to clear.
+ */
+static void share_entry_clear(struct share_entry *entry)
+{
+	if (entry->partial != NULL) {
+		css_computed_style_destroy(entry->partial);
+		entry->partial = NULL;
+	}
+	entry->node = NULL;
+}
+
+/* exported interface documented in css/select.h */
+void nscss_select_cache_flush(void)
+{
+	unsigned int idx;
+
+	nscss_select_invalidate_siblings();
+
+	for (idx = 0; idx < SHARE_CACHE_SIZE; idx++) {
+		share_entry_clear(&share_cache[idx]);
+	}
+
+	ancestor_filter.valid = false;
+}
+
+/* exported interface documented in css/select.h */
+nserror nscss_select_stats_create(struct nscss_select_stats **stats_out)
+{
+	struct nscss_select_stats *stats;
+
+	stats = calloc(1, sizeof(struct nscss_select_stats));
+	if (stats == NULL) {
+		return NSERROR_NOMEM;
+	}
+
+	*stats_out = stats;
+
+	return NSERROR_OK;
+}
+
+/* exported interface documented in css/select.h */
+void nscss_select_stats_destroy(struct nscss_select_stats *stats)
+{
+	if (stats->elements > 0) {
+		NSLOG(netsurf, INFO, "Shared %u of %u element styles",
+		      stats->shared, stats->elements);
+	}
+
+	if (stats->ancestor_searches > 0) {
+		NSLOG(netsurf, INFO,
+		      "Ancestor filter rejected %u of %u ancestor searches",
+		      stats->ancestor_rejects,
+		      stats->ancestor_searches);
+	}
+
+	free(stats);
+}
+
+/* exported interface documented in css/select.h */
+nserror nscss_select_stats_dump(const struct nscss_select_stats *stats,
+		FILE *f)
+{
+	unsigned int idx;
+
+	fprintf(f, "elements %u\n", stats->elements);
+	fprintf(f, "shared %u\n", stats->shared);
+	fprintf(f, "selected %u\n", stats->elements - stats->shared);
+	fprintf(f, "ancestor_searches %u\n", stats->ancestor_searches);
+	fprintf(f, "ancestor_rejects %u\n", stats->ancestor_rejects);
+
+	for (idx = 0; idx < SELECT_CB__COUNT; idx++) {
+		fprintf(f, "callback %s %u\n",
+			select_callback_name[idx],
+			stats->callback[idx]);
+	}
+
+	return NSERROR_OK;
+}
+
+/**
+ * Determine if two elements have the same name and attributes.
+ *
+ * \param a  First element
+ * \param b  Second element
+ * \return true if the name and all attributes match else false.
+ */
+static bool nscss_same_element(dom_node *a, dom_node *b)
+{
+	dom_namednodemap *attrs;
+	dom_string *name_a, *name_b;
+	dom_exception exc;
+	uint32_t count_a, count_b, idx;
+	bool same;
+
+	exc = dom_node_get_node_name(a, &name_a);
+	if ((exc != DOM_NO_ERR) || (name_a == NULL))
+		return false;
+
+	exc = dom_node_get_node_name(b, &name_b);
+	if ((exc != DOM_NO_ERR) || (name_b == NULL)) {
+		dom_string_unref(name_a);
+		return false;
+	}
+
+	same = dom_string_isequal(name_a, name_b);
+	dom_string_unref(name_a);
+	dom_string_unref(name_b);
+	if (same == false)
+		return false;
+
+	exc = dom_node_get_attributes(b, &attrs);
+	if ((exc != DOM_NO_ERR) || (attrs == NULL))
+		return false;
+	exc = dom_namednodemap_get_length(attrs, &count_b);
+	dom_namednodemap_unref(attrs);
+	if (exc != DOM_NO_ERR)
+		return false;
+
+	exc = dom_node_get_attributes(a, &attrs);
+	if ((exc != DOM_NO_ERR) || (attrs == NULL))
+		return false;
+	exc = dom_namednodemap_get_length(attrs, &count_a);
+	if ((exc != DOM_NO_ERR) || (count_a != count_b)) {
+		dom_namednodemap_unref(attrs);
+		return false;
+	}
+
+	for (idx = 0; same && idx < count_a; idx++) {
+		dom_attr *attr;
+		dom_string *name, *value_a, *value_b = NULL;
+
+		exc = dom_namednodemap_item(attrs, idx, (void *) &attr);
+		if ((exc != DOM_NO_ERR) || (attr == NULL)) {
+			same = false;
+			break;
+		}
+
+		exc = dom_attr_get_name(attr, &name);
+		if (exc != DOM_NO_ERR) {
+			dom_node_unref(attr);
+			same = false;
+			break;
+		}
+
+		exc = dom_attr_get_value(attr, &value_a);
+		dom_node_unref(attr);
+		if (exc != DOM_NO_ERR) {
+			dom_string_unref(name);
+			same = false;
+			break;
+		}
+
+		exc = dom_element_get_attribute(b, name, &value_b);
+		if ((exc != DOM_NO_ERR) || (value_b == NULL) ||
+		    (value_a == NULL) ||
+		    (dom_string_isequal(value_a, value_b) == false)) {
+			same = false;
+		}
+
+		if (value_b != NULL)
+			dom_string_unref(value_b);
+		if (value_a != NULL)
+			dom_string_unref(value_a);
+		dom_string_unref(name);
+	}
+
+	dom_namednodemap_unref(attrs);
+
+	return same;
+}
+
+/**
+ * Determine if an element has any element children.
+ *
+ * \param n  Element to examine
+ * \return true if n has element children or on error, else false.
+ */
+static bool node_has_element_children(dom_node *n)
+{
+	dom_node *child, *next;
+	dom_node_type type;
+	dom_exception exc;
+
+	exc = dom_node_get_first_child(n, &child);
+	if (exc != DOM_NO_ERR)
+		return true;
+
+	while (child != NULL) {
+		exc = dom_node_get_node_type(child, &type);
+		if ((exc != DOM_NO_ERR) || (type == DOM_ELEMENT_NODE)) {
+			dom_node_unref(child);
+			return true;
+		}
+
+		exc = dom_node_get_next_sibling(child, &next);
+		dom_node_unref(child);
+		if (exc != DOM_NO_ERR)
+			return true;
+		child = next;
+	}
+
+	return false;
+}
+
+/**
+ * Find a style which can be shared from an element's previous sibling.
+ *
+ * \param ctx    CSS selection context
+ * \param n      Element to select for
+ * \param media  Permitted media types
+ * \return The cache entry holding the style to share or NULL if none.
+ */
+static struct share_entry *
+nscss_find_shared_style(nscss_select_ctx *ctx, dom_node *n,
+		const css_media *media)
+{
+	struct share_entry *entry;
+	dom_node *prev;
+	bool same;
+
+	/* libcss keeps data, such as the ancestor bloom filter, on the
+	 * elements it selects for which makes selection of their
+	 * children faster. Only elements whose children are all text
+	 * may skip selection without losing that.
+	 */
+	if (node_has_element_children(n))
+		return NULL;
+
+	prev = node_previous_element(n);
+	if (prev == NULL)
+		return NULL;
+
+	entry = share_cache_entry(prev);
+	if (entry->node != prev ||
+	    entry->generation != sibling_cache_generation ||
+	    entry->select_ctx != ctx->ctx ||
+	    entry->media != media ||
+	    entry->parent_style != ctx->parent_style ||
+	    entry->root_style != ctx->root_style) {
+		dom_node_unref(prev);
+		return NULL;
+	}
+
+	same = nscss_same_element(prev, n);
+	dom_node_unref(prev);
+
+	return same ? entry : NULL;
+}
+
 /**
  * Get style selection results for an element
  *
@@ -259,18 +986,86 @@ css_select_results *nscss_get_style(nscss_select_ctx *ctx, dom_node *n,
 {
 	css_computed_style *composed;
 	css_select_results *styles;
+	struct share_entry *entry = NULL;
+	struct share_entry *next;
+	bool shareable;
 	int pseudo_element;
 	css_error error;
 
+	/* Elements with inline style never share as the inline style
+	 * is not kept, nor does the root as it has no siblings */
+	shareable = (inline_style == NULL && ctx->parent_style != NULL);
+	if (ctx->stats != NULL) {
+		ctx->stats->elements++;
+	}
+
+	if (shareable) {
+		entry = nscss_find_shared_style(ctx, n, media);
+	}
+
+	if (entry != NULL) {
+		/* Reuse the previous sibling's partial style */
+		styles = calloc(1, sizeof(css_select_results));
+		if (styles == NULL) {
+			return NULL;
+		}
+
+		error = css_computed_style_compose(ctx->parent_style,
+				entry->partial,
+				nscss_compute_font_size, ctx,
+				&styles->styles[CSS_PSEUDO_ELEMENT_NONE]);
+		if (error != CSS_OK) {
+			css_select_results_destroy(styles);
+			return NULL;
+		}
+
+		/* Hand the entry on to this element for its next sibling */
+		next = share_cache_entry(n);
+		if (next != entry) {
+			share_entry_clear(next);
+			*next = *entry;
+			entry->partial = NULL;
+			entry->node = NULL;
+		}
+		next->node = n;
+
+		if (ctx->stats != NULL) {
+			ctx->stats->shared++;
+		}
+
+		return styles;
+	}
+
 	/* Select style for node */
+	ancestor_filter_update(n);
+	select_node = n;
+	select_node_tainted = false;
+	select_stats = ctx->stats;
+
 	error = css_select_style(ctx->ctx, n, media, inline_style,
 			&selection_handler, ctx, &styles);
 
+	select_node = NULL;
+	select_stats = NULL;
+
 	if (error != CSS_OK || styles == NULL) {
 		/* Failed selecting partial style -- bail out */
 		return NULL;
 	}
 
+	/* Only share styles which depend on nothing but the element
+	 * itself and its ancestors */
+	for (pseudo_element = CSS_PSEUDO_ELEMENT_NONE + 1;
+			pseudo_element < CSS_PSEUDO_ELEMENT_COUNT;
+			pseudo_element++) {
+		if (styles->styles[pseudo_element] != NULL) {
+			shareable = false;
+		}
+	}
+	if (select_node_tainted) {
+		shareable = false;
+	}
+
 	/* If there's a parent style, compose with partial to obtain
 	 * complete computed style for element */
 	if (ctx->parent_style != NULL) {
@@ -285,9 +1080,25 @@ css_select_results *nscss_get_style(nscss_select_ctx *ctx, dom_node *n,
 			return NULL;
 		}
 
+		entry = share_cache_entry(n);
+		share_entry_clear(entry);
+
+		if (shareable) {
+			/* Keep partial style for following siblings */
+			entry->node = n;
+			entry->generation = sibling_cache_generation;
+			entry->select_ctx = ctx->ctx;
+			entry->media = media;
+			entry->parent_style = ctx->parent_style;
+			entry->root_style = ctx->root_style;
+			entry->partial =
+				styles->styles[CSS_PSEUDO_ELEMENT_NONE];
+		} else {
+			css_computed_style_destroy(
+					styles->styles[CSS_PSEUDO_ELEMENT_NONE]);
+		}
+
 		/* Replace select_results style with composed style */
-		css_computed_style_destroy(
-				styles->styles[CSS_PSEUDO_ELEMENT_NONE]);
 		styles->styles[CSS_PSEUDO_ELEMENT_NONE] = composed;
 	}
 
@@ -505,6 +1316,8 @@ css_error node_name(void *pw, void *node, css_qname *qname)
 	dom_string *name;
 	dom_exception err;
 
+	SELECT_CALLBACK(NODE_NAME);
+
 	err = dom_node_get_node_name(n, &name);
 	if (err != DOM_NO_ERR)
 		return CSS_NOMEM;
@@ -542,6 +1355,8 @@ css_error node_classes(void *pw, void *node,
 	dom_node *n = node;
 	dom_exception err;
 
+	SELECT_CALLBACK(NODE_CLASSES);
+
 	*classes = NULL;
 	*n_classes = 0;
 
@@ -567,6 +1382,8 @@ css_error node_id(void *pw, void *node, lwc_string **id)
 	dom_string *attr;
 	dom_exception err;
 
+	SELECT_CALLBACK(NODE_ID);
+
 	*id = NULL;
 
 	/** \todo Assumes an HTML DOM */
@@ -600,6 +1417,13 @@ css_error node_id(void *pw, void *node, lwc_string **id)
 css_error named_ancestor_node(void *pw, void *node,
 		const css_qname *qname, void **ancestor)
 {
+	SELECT_CALLBACK(NAMED_ANCESTOR_NODE);
+
+	if (ancestor_filter_maybe(qname->name) == false) {
+		*ancestor = NULL;
+		return CSS_OK;
+	}
+
 	dom_element_named_ancestor_node(node, qname->name,
 			(struct dom_element **)ancestor);
 
@@ -620,6 +1444,13 @@ css_error named_ancestor_node(void *pw, void *node,
 css_error named_parent_node(void *pw, void *node,
 		const css_qname *qname, void **parent)
 {
+	SELECT_CALLBACK(NAMED_PARENT_NODE);
+
+	if (ancestor_filter_maybe(qname->name) == false) {
+		*parent = NULL;
+		return CSS_OK;
+	}
+
 	dom_element_named_parent_node(node, qname->name,
 			(struct dom_element **)parent);
 
@@ -644,6 +1475,10 @@ css_error named_sibling_node(void *pw, void *node,
 	dom_node *prev;
 	dom_exception err;
 
+	SELECT_CALLBACK(NAMED_SIBLING_NODE);
+
+	select_taint(node);
+
 	*sibling = NULL;
 
 	/* Find sibling element */
@@ -712,6 +1547,10 @@ css_error named_generic_sibling_node(void *pw, void *node,
 	dom_node *prev;
 	dom_exception err;
 
+	SELECT_CALLBACK(NAMED_GENERIC_SIBLING_NODE);
+
+	select_taint(node);
+
 	*sibling = NULL;
 
 	err = dom_node_get_previous_sibling(n, &n);
@@ -770,6 +1609,8 @@ css_error named_generic_sibling_node(void *pw, void *node,
  */
 css_error parent_node(void *pw, void *node, void **parent)
 {
+	SELECT_CALLBACK(PARENT_NODE);
+
 	dom_element_parent_node(node, (struct dom_element **)parent);
 
 	return CSS_OK;
@@ -791,6 +1632,10 @@ css_error sibling_node(void *pw, void *node, void **sibling)
 	dom_node *prev;
 	dom_exception err;
 
+	SELECT_CALLBACK(SIBLING_NODE);
+
+	select_taint(node);
+
 	*sibling = NULL;
 
 	/* Find sibling element */
@@ -847,6 +1692,8 @@ css_error node_has_name(void *pw, void *node,
 	nscss_select_ctx *ctx = pw;
 	dom_node *n = node;
 
+	SELECT_CALLBACK(NODE_HAS_NAME);
+
 	if (lwc_string_isequal(qname->name, ctx->universal, match) ==
 			lwc_error_ok && *match == false) {
 		dom_string *name;
@@ -882,6 +1729,8 @@ css_error node_has_class(void *pw, void *node,
 	dom_node *n = node;
 	dom_exception err;
 
+	SELECT_CALLBACK(NODE_HAS_CLASS);
+
 	/** \todo: Ensure that libdom performs case-insensitive
 	 * matching in quirks mode */
 	err = dom_element_has_class(n, name, match);
@@ -909,6 +1758,8 @@ css_error node_has_id(void *pw, void *node,
 	dom_string *attr;
 	dom_exception err;
 
+	SELECT_CALLBACK(NODE_HAS_ID);
+
 	*match = false;
 
 	/** \todo Assumes an HTML DOM */
@@ -944,6 +1795,8 @@ css_error node_has_attribute(void *pw, void *node,
 	dom_string *name;
 	dom_exception err;
 
+	SELECT_CALLBACK(NODE_HAS_ATTRIBUTE);
+
 	err = dom_string_create_interned(
 			(const uint8_t *) lwc_string_data(qname->name),
 			lwc_string_length(qname->name), &name);
@@ -985,6 +1838,8 @@ css_error node_has_attribute_equal(void *pw, void *node,
 
 	size_t vlen = lwc_string_length(value);
 
+	SELECT_CALLBACK(NODE_HAS_ATTRIBUTE_EQUAL);
+
 	if (vlen == 0) {
 		*match = false;
 		return CSS_OK;
@@ -1037,6 +1892,8 @@ css_error node_has_attribute_dashmatch(void *pw, void *node,
 
 	size_t vlen = lwc_string_length(value);
 
+	SELECT_CALLBACK(NODE_HAS_ATTRIBUTE_DASHMATCH);
+
 	if (vlen == 0) {
 		*match = false;
 		return CSS_OK;
@@ -1104,6 +1961,8 @@ css_error node_has_attribute_includes(void *pw, void *node,
 	const char *start;
 	const char *end;
 
+	SELECT_CALLBACK(NODE_HAS_ATTRIBUTE_INCLUDES);
+
 	*match = false;
 
 	if (vlen == 0) {
@@ -1173,6 +2032,8 @@ css_error node_has_attribute_prefix(void *pw, void *node,
 
 	size_t vlen = lwc_string_length(value);
 
+	SELECT_CALLBACK(NODE_HAS_ATTRIBUTE_PREFIX);
+
 	if (vlen == 0) {
 		*match = false;
 		return CSS_OK;
@@ -1237,6 +2098,8 @@ css_error node_has_attribute_suffix(void *pw, void *node,
 
 	size_t vlen = lwc_string_length(value);
 
+	SELECT_CALLBACK(NODE_HAS_ATTRIBUTE_SUFFIX);
+
 	if (vlen == 0) {
 		*match = false;
 		return CSS_OK;
@@ -1305,6 +2168,8 @@ css_error node_has_attribute_substring(void *pw, void *node,
 
 	size_t vlen = lwc_string_length(value);
 
+	SELECT_CALLBACK(NODE_HAS_ATTRIBUTE_SUBSTRING);
+
 	if (vlen == 0) {
 		*match = false;
 		return CSS_OK;
@@ -1370,6 +2235,8 @@ css_error node_is_root(void *pw, void *node, bool *match)
 	dom_node_type type;
 	dom_exception err;
 
+	SELECT_CALLBACK(NODE_IS_ROOT);
+
 	err = dom_node_get_parent_node(n, &parent);
 	if (err != DOM_NO_ERR) {
 		return CSS_NOMEM;
@@ -1430,6 +2297,57 @@ node_count_siblings_check(dom_node *node,
 	return ret;
 }
 
+static inline struct sibling_count *
+sibling_cache_entry(dom_node *node, bool same_name, bool after)
+{
+	uintptr_t hash = (uintptr_t) node;
+
+	hash = (hash >> 4) ^ (hash >> 12);
+	hash = (hash << 2) | (same_name << 1) | after;
+
+	return &sibling_cache[hash % SIBLING_CACHE_SIZE];
+}
+
+/**
+ * Find a node's sibling count from the count of its previous element.
+ *
+ * \param n          DOM node
+ * \param same_name  Only count siblings with the same name, or all
+ * \param node_name  Name of n if same_name is set
+ * \param after      Count anteceding instead of preceding siblings
+ * \param count      Pointer to location to receive result
+ * \return true if count was found else false.
+ */
+static bool
+node_count_siblings_cached(dom_node *n, bool same_name, dom_string *node_name,
+		bool after, int32_t *count)
+{
+	struct sibling_count *entry;
+	dom_node *prev;
+	bool found = false;
+
+	prev = node_previous_element(n);
+	if (prev == NULL)
+		return false;
+
+	entry = sibling_cache_entry(prev, same_name, after);
+	if (entry->node == prev &&
+	    entry->generation == sibling_cache_generation &&
+	    entry->same_name == same_name &&
+	    entry->after == after &&
+	    node_count_siblings_check(prev, same_name, node_name) == 1) {
+		/* previous element is included in the preceding count
+		 * of this node and this node in its anteceding count
+		 */
+		*count = after ? entry->count - 1 : entry->count + 1;
+		found = true;
+	}
+
+	dom_node_unref(prev);
+
+	return found;
+}
+
 /**
  * Callback to count a node's siblings.
  *
@@ -1448,6 +2366,11 @@ css_error node_count_siblings(void *pw, void *n, bool same_name,
 	int32_t cnt = 0;
 	dom_exception exc;
 	dom_string *node_name = NULL;
+	struct sibling_count *entry;
+
+	SELECT_CALLBACK(NODE_COUNT_SIBLINGS);
+
+	select_taint(n);
 
 	if (same_name) {
 		dom_node *node = n;
@@ -1457,7 +2380,10 @@ css_error node_count_siblings(void *pw, void *n, bool same_name,
 		}
 	}
 
-	if (after) {
+	if (node_count_siblings_cached(n, same_name, node_name,
+			after, &cnt)) {
+		/* count derived from previous sibling */
+	} else if (after) {
 		dom_node *node = dom_node_ref(n);
 		dom_node *next;
 
@@ -1492,6 +2418,13 @@ css_error node_count_siblings(void *pw, void *n, bool same_name,
 		dom_string_unref(node_name);
 	}
 
+	entry = sibling_cache_entry(n, same_name, after);
+	entry->node = n;
+	entry->generation = sibling_cache_generation;
+	entry->same_name = same_name;
+	entry->after = after;
+	entry->count = cnt;
+
 	*count = cnt;
 	return CSS_OK;
 }
@@ -1511,6 +2444,10 @@ css_error node_is_empty(void *pw, void *node, bool *match)
 	dom_node *n = node, *next;
 	dom_exception err;
 
+	SELECT_CALLBACK(NODE_IS_EMPTY);
+
+	select_taint(node);
+
 	*match = true;
 
 	err = dom_node_get_first_child(n, &n);
@@ -1561,6 +2498,8 @@ css_error node_is_link(void *pw, void *n, bool *match)
 	dom_exception exc;
 	dom_string *node_name = NULL;
 
+	SELECT_CALLBACK(NODE_IS_LINK);
+
 	exc = dom_node_get_node_name(node, &node_name);
 	if ((exc != DOM_NO_ERR) || (node_name == NULL)) {
 		return CSS_NOMEM;
@@ -1583,10 +2522,141 @@ css_error node_is_link(void *pw, void *n, bool *match)
 	return CSS_OK;
 }
 
+/**
+ * Link state cached on anchor element nodes.
+ */
+struct nscss_link_data {
+	dom_string *href; /**< href attribute the url was made from */
+	nsurl *base_url; /**< base url the url was made from */
+	nsurl *url; /**< absolute url of link */
+	unsigned int generation; /**< urldb visit generation of visited */
+	bool visited; /**< whether the url has been visited */
+};
+
+/**
+ * Destroy cached link state.
+ *
+ * \param data The link state to destroy.
+ */
+static void nscss_link_data_destroy(struct nscss_link_data *data)
+{
+	dom_string_unref(data->href);
+	nsurl_unref(data->base_url);
+	nsurl_unref(data->url);
+	free(data);
+}
+
+/* Handler for cached link state, stored as libdom node user data */
+static void nscss_link_user_data_handler(dom_node_operation operation,
+		dom_string *key, void *data, struct dom_node *src,
+		struct dom_node *dst)
+{
+	if (dom_string_isequal(corestring_dom___ns_key_link_node_data,
+			key) == false || data == NULL) {
+		return;
+	}
+
+	switch (operation) {
+	case DOM_NODE_DELETED:
+		nscss_link_data_destroy(data);
+		break;
+
+	case DOM_NODE_CLONED:
+	case DOM_NODE_RENAMED:
+	case DOM_NODE_IMPORTED:
+	case DOM_NODE_ADOPTED:
+	default:
+		/* The state is revalidated against the href attribute
+		 * and base url on every use so needs no update.
+		 */
+		break;
+	}
+}
+
+/**
+ * Get the cached link state of an anchor element, updating it if stale.
+ *
+ * \param n         Anchor element
+ * \param href      The current href attribute of the element
+ * \param base_url  The current base url of the document
+ * \return The link state or NULL on error.
+ */
+static struct nscss_link_data *
+nscss_get_link_data(dom_node *n, dom_string *href, nsurl *base_url)
+{
+	struct nscss_link_data *data = NULL;
+	struct nscss_link_data *old = NULL;
+	const struct url_data *url_data;
+	dom_exception exc;
+	nserror error;
+
+	exc = dom_node_get_user_data(n,
+			corestring_dom___ns_key_link_node_data,
+			(void *) &data);
+	if (exc != DOM_NO_ERR) {
+		return NULL;
+	}
+
+	if (data != NULL &&
+	    (data->base_url != base_url ||
+	     dom_string_isequal(data->href, href) == false)) {
+		/* href or base changed; resolve again */
+		dom_node_set_user_data(n,
+				corestring_dom___ns_key_link_node_data,
+				NULL, nscss_link_user_data_handler,
+				(void *) &old);
+		nscss_link_data_destroy(data);
+		data = NULL;
+	}
+
+	if (data == NULL) {
+		data = malloc(sizeof(struct nscss_link_data));
+		if (data == NULL) {
+			return NULL;
+		}
+
+		error = nsurl_join(base_url, dom_string_data(href), &data->url);
+		if (error != NSERROR_OK) {
+			free(data);
+			return NULL;
+		}
+
+		data->href = dom_string_ref(href);
+		data->base_url = nsurl_ref(base_url);
+		/* force the visited state to be looked up */
+		data->generation = urldb_get_visit_generation() - 1;
+		data->visited = false;
+
+		exc = dom_node_set_user_data(n,
+				corestring_dom___ns_key_link_node_data,
+				data, nscss_link_user_data_handler,
+				(void *) &old);
+		if (exc != DOM_NO_ERR) {
+			nscss_link_data_destroy(data);
+			return NULL;
+		}
+	}
+
+	if (data->generation != urldb_get_visit_generation()) {
+		url_data = urldb_get_url_data(data->url);
+
+		/* Visited if in the db and has
+		 * non-zero visit count */
+		data->visited = (url_data != NULL && url_data->visits > 0);
+		data->generation = urldb_get_visit_generation();
+	}
+
+	return data;
+}
+
 /**
  * Callback to determine if a node is a linking element whose target has been
  * visited.
  *
+ * The absolute link url and its visited state are cached on the node
+ * and only recomputed when the href, document base url or the url
+ * database visit data change.
+ *
  * \param pw     HTML document
  * \param node   DOM node
  * \param match  Pointer to location to receive result
@@ -1597,14 +2667,14 @@ css_error node_is_link(void *pw, void *n, bool *match)
 css_error node_is_visited(void *pw, void *node, bool *match)
 {
 	nscss_select_ctx *ctx = pw;
-	nsurl *url;
-	nserror error;
-	const struct url_data *data;
+	struct nscss_link_data *data;
 
 	dom_exception exc;
 	dom_node *n = node;
 	dom_string *s = NULL;
 
+	SELECT_CALLBACK(NODE_IS_VISITED);
+
 	*match = false;
 
 	exc = dom_node_get_node_name(n, &s);
@@ -1628,27 +2698,17 @@ css_error node_is_visited(void *pw, void *node, bool *match)
 		return CSS_OK;
 	}
 
-	/* Make href absolute */
-	/* TODO: this duplicates what we do for box->href
-	 *       should we put the absolute URL on the dom node? */
-	error = nsurl_join(ctx->base_url, dom_string_data(s), &url);
+	data = nscss_get_link_data(n, s, ctx->base_url);
 
 	/* Finished with href string */
 	dom_string_unref(s);
 
-	if (error != NSERROR_OK) {
+	if (data == NULL) {
 		/* Couldn't make nsurl object */
 		return CSS_NOMEM;
 	}
 
-	data = urldb_get_url_data(url);
-
-	/* Visited if in the db and has
-	 * non-zero visit count */
-	if (data != NULL && data->visits > 0)
-		*match = true;
-
-	nsurl_unref(url);
+	*match = data->visited;
 
 	return CSS_OK;
 }
@@ -1665,6 +2725,8 @@ css_error node_is_visited(void *pw, void *node, bool *match)
  */
 css_error node_is_hover(void *pw, void *node, bool *match)
 {
+	SELECT_CALLBACK(NODE_IS_HOVER);
+
 	/** \todo Support hovering */
 
 	*match = false;
@@ -1684,6 +2746,8 @@ css_error node_is_hover(void *pw, void *node, bool *match)
  */
 css_error node_is_active(void *pw, void *node, bool *match)
 {
+	SELECT_CALLBACK(NODE_IS_ACTIVE);
+
 	/** \todo Support active nodes */
 
 	*match = false;
@@ -1703,6 +2767,8 @@ css_error node_is_active(void *pw, void *node, bool *match)
  */
 css_error node_is_focus(void *pw, void *node, bool *match)
 {
+	SELECT_CALLBACK(NODE_IS_FOCUS);
+
 	/** \todo Support focussed nodes */
 
 	*match = false;
@@ -1722,6 +2788,8 @@ css_error node_is_focus(void *pw, void *node, bool *match)
  */
 css_error node_is_enabled(void *pw, void *node, bool *match)
 {
+	SELECT_CALLBACK(NODE_IS_ENABLED);
+
 	/** \todo Support enabled nodes */
 
 	*match = false;
@@ -1741,6 +2809,8 @@ css_error node_is_enabled(void *pw, void *node, bool *match)
  */
 css_error node_is_disabled(void *pw, void *node, bool *match)
 {
+	SELECT_CALLBACK(NODE_IS_DISABLED);
+
 	/** \todo Support disabled nodes */
 
 	*match = false;
@@ -1760,6 +2830,8 @@ css_error node_is_disabled(void *pw, void *node, bool *match)
  */
 css_error node_is_checked(void *pw, void *node, bool *match)
 {
+	SELECT_CALLBACK(NODE_IS_CHECKED);
+
 	/** \todo Support checked nodes */
 
 	*match = false;
@@ -1779,6 +2851,8 @@ css_error node_is_checked(void *pw, void *node, bool *match)
  */
 css_error node_is_target(void *pw, void *node, bool *match)
 {
+	SELECT_CALLBACK(NODE_IS_TARGET);
+
 	/** \todo Support target */
 
 	*match = false;
@@ -1800,6 +2874,8 @@ css_error node_is_target(void *pw, void *node, bool *match)
 css_error node_is_lang(void *pw, void *node,
 		lwc_string *lang, bool *match)
 {
+	SELECT_CALLBACK(NODE_IS_LANG);
+
 	/** \todo Support languages */
 
 	*match = false;
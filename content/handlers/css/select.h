@@ -20,13 +20,17 @@
 #define NETSURF_CSS_SELECT_H_
 
 #include <stdint.h>
+#include <stdio.h>
 
 #include <dom/dom.h>
 
 #include <libcss/libcss.h>
 
+#include "utils/errors.h"
+
 struct content;
 struct nsurl;
+struct nscss_select_stats;
 
 /**
  * Selection context
@@ -39,6 +43,8 @@ typedef struct nscss_select_ctx
 	lwc_string *universal;
 	const css_computed_style *root_style;
 	const css_computed_style *parent_style;
+	/** Statistics accumulated by nscss_get_style, or NULL */
+	struct nscss_select_stats *stats;
 } nscss_select_ctx;
 
 css_stylesheet *nscss_create_inline_style(const uint8_t *data, size_t len,
@@ -56,4 +62,51 @@ css_error named_ancestor_node(void *pw, void *node,
 
 css_error node_is_visited(void *pw, void *node, bool *match);
 
+/**
+ * Invalidate cached element sibling counts.
+ *
+ * Must be called whenever the DOM is modified and before any DOM is
+ * destroyed so the cache never holds counts for stale nodes.
+ */
+void nscss_select_invalidate_siblings(void);
+
+/**
+ * Invalidate and release all cached selection state.
+ *
+ * Must be called before a document or selection context is destroyed
+ * so styles are never shared with elements of another document.
+ */
+void nscss_select_cache_flush(void);
+
+/**
+ * Create a set of style selection statistics.
+ *
+ * \param stats_out Updated with the statistics on success.
+ * \return NSERROR_OK on success else NSERROR_NOMEM.
+ */
+nserror nscss_select_stats_create(struct nscss_select_stats **stats_out);
+
+/**
+ * Destroy a set of style selection statistics.
+ *
+ * A summary of the statistics is logged.
+ *
+ * \param stats The statistics to destroy.
+ */
+void nscss_select_stats_destroy(struct nscss_select_stats *stats);
+
+/**
+ * Write style selection statistics.
+ *
+ * The statistics are written one per line as a name followed by a
+ * count. Each selection callback has a line of the form
+ * "callback <name> <count>".
+ *
+ * \param stats The statistics to write.
+ * \param f The file to write to.
+ * \return NSERROR_OK on success else error code.
+ */
+nserror nscss_select_stats_dump(const struct nscss_select_stats *stats,
+		FILE *f);
+
 #endif
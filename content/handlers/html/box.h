@@ -86,7 +86,8 @@ typedef enum {
 	REPLACE_DIM = 1 << 9,	/* replaced element has given dimensions */
 	IFRAME      = 1 << 10,	/* box contains an iframe */
 	CONVERT_CHILDREN = 1 << 11,  /* wanted children converting */
-	IS_REPLACED = 1 << 12	/* box is a replaced element */
+	IS_REPLACED = 1 << 12,	/* box is a replaced element */
+	FREED       = 1 << 13	/* box has been freed back to its arena */
 } box_flags;
 
 
@@ -170,29 +171,53 @@ struct object_params {
 
 
 /**
- * Node in box tree. All dimensions are in pixels.
+ * Rarely used box data.
+ *
+ * Only a small minority of boxes have any of these so they are kept
+ * out of the main box structure and allocated on demand with
+ * box_get_extra().
  */
-struct box {
+struct box_extra {
 	/**
-	 * Type of box.
+	 * Title, or NULL.
 	 */
-	box_type type;
+	const char *title;
 
 	/**
-	 * Box flags
+	 * (Image)map to use with this object, or NULL if none
 	 */
-	box_flags flags;
+	char *usemap;
 
 	/**
-	 * DOM node that generated this box or NULL
+	 * Parameters for the object, or NULL.
 	 */
-	struct dom_node *node;
+	struct object_params *object_params;
 
 	/**
-	 * Computed styles for elements and their pseudo elements.
-	 *  NULL on non-element boxes.
+	 * Iframe's browser_window, or NULL if none
 	 */
-	css_select_results *styles;
+	struct browser_window *iframe;
+};
+
+
+/**
+ * Node in box tree. All dimensions are in pixels.
+ *
+ * The members are ordered so those used throughout layout and redraw
+ * are together at the start of the structure with those used mostly
+ * during box tree construction towards the end. Rarely used data is
+ * held separately in a struct box_extra.
+ */
+struct box {
+	/**
+	 * Type of box.
+	 */
+	box_type type;
+
+	/**
+	 * Box flags
+	 */
+	box_flags flags;
 
 	/**
 	 * Style for this box. 0 for INLINE_CONTAINER and
@@ -202,11 +227,6 @@ struct box {
 	 */
 	css_computed_style *style;
 
-	/**
-	 *  value of id attribute (or name for anchors)
-	 */
-	lwc_string *id;
-
 
 	/**
 	 * Next sibling box, or NULL.
@@ -233,42 +253,6 @@ struct box {
 	 */
 	struct box *parent;
 
-	/**
-	 * INLINE_END box corresponding to this INLINE box, or INLINE
-	 * box corresponding to this INLINE_END box.
-	 */
-	struct box *inline_end;
-
-
-	/**
-	 * First float child box, or NULL. Float boxes are in the tree
-	 * twice, in this list for the block box which defines the
-	 * area for floats, and also in the standard tree given by
-	 * children, next, prev, etc.
-	 */
-	struct box *float_children;
-
-	/**
-	 * Next sibling float box.
-	 */
-	struct box *next_float;
-
-	/**
-	 * If box is a float, points to box's containing block
-	 */
-	struct box *float_container;
-
-	/**
-	 * Level below which subsequent floats must be cleared.  This
-	 * is used only for boxes with float_children
-	 */
-	int clear_level;
-
-	/**
-	 * Level below which floats have been placed.
-	 */
-	int cached_place_below_level;
-
 
 	/**
 	 * Coordinate of left padding edge relative to parent box, or
@@ -324,15 +308,21 @@ struct box {
 	 */
 	struct box_border border[4];
 
+
 	/**
-	 * Horizontal scroll.
+	 * Text, or NULL if none. Unterminated.
 	 */
-	struct scrollbar *scroll_x;
+	char *text;
 
 	/**
-	 * Vertical scroll.
+	 * Length of text.
 	 */
-	struct scrollbar *scroll_y;
+	size_t length;
+
+	/**
+	 * Width of space after current text (depends on font and size).
+	 */
+	int space;
 
 	/**
 	 * Width of box taking all line breaks (including margins
@@ -348,40 +338,71 @@ struct box {
 
 
 	/**
-	 * Text, or NULL if none. Unterminated.
+	 * Level below which subsequent floats must be cleared.  This
+	 * is used only for boxes with float_children
 	 */
-	char *text;
+	int clear_level;
 
 	/**
-	 * Length of text.
+	 * Level below which floats have been placed.
 	 */
-	size_t length;
+	int cached_place_below_level;
 
 	/**
-	 * Width of space after current text (depends on font and size).
+	 * INLINE_END box corresponding to this INLINE box, or INLINE
+	 * box corresponding to this INLINE_END box.
 	 */
-	int space;
+	struct box *inline_end;
 
 	/**
-	 * Byte offset within a textual representation of this content.
+	 * First float child box, or NULL. Float boxes are in the tree
+	 * twice, in this list for the block box which defines the
+	 * area for floats, and also in the standard tree given by
+	 * children, next, prev, etc.
 	 */
-	size_t byte_offset;
+	struct box *float_children;
 
+	/**
+	 * Next sibling float box.
+	 */
+	struct box *next_float;
 
 	/**
-	 * Link, or NULL.
+	 * If box is a float, points to box's containing block
 	 */
-	struct nsurl *href;
+	struct box *float_container;
+
 
 	/**
-	 * Link target, or NULL.
+	 * Horizontal scroll.
 	 */
-	const char *target;
+	struct scrollbar *scroll_x;
 
 	/**
-	 * Title, or NULL.
+	 * Vertical scroll.
 	 */
-	const char *title;
+	struct scrollbar *scroll_y;
+
+
+	/**
+	 * Object in this box (usually an image), or NULL if none.
+	 */
+	struct hlcache_handle* object;
+
+	/**
+	 * Background image for this box, or NULL if none
+	 */
+	struct hlcache_handle *background;
+
+	/**
+	 * Form control data, or NULL if not a form control.
+	 */
+	struct form_control* gadget;
+
+	/**
+	 * List marker box if this is a list-item, or NULL.
+	 */
+	struct box *list_marker;
 
 
 	/**
@@ -406,45 +427,41 @@ struct box {
 
 
 	/**
-	 * List marker box if this is a list-item, or NULL.
+	 * Link, or NULL.
 	 */
-	struct box *list_marker;
-
+	struct nsurl *href;
 
 	/**
-	 * Form control data, or NULL if not a form control.
+	 * Link target, or NULL.
 	 */
-	struct form_control* gadget;
-
+	const char *target;
 
 	/**
-	 * (Image)map to use with this object, or NULL if none
+	 * Byte offset within a textual representation of this content.
 	 */
-	char *usemap;
+	size_t byte_offset;
 
 
 	/**
-	 * Background image for this box, or NULL if none
+	 * Computed styles for elements and their pseudo elements.
+	 *  NULL on non-element boxes.
 	 */
-	struct hlcache_handle *background;
-
+	css_select_results *styles;
 
 	/**
-	 * Object in this box (usually an image), or NULL if none.
+	 * DOM node that generated this box or NULL
 	 */
-	struct hlcache_handle* object;
+	struct dom_node *node;
 
 	/**
-	 * Parameters for the object, or NULL.
+	 *  value of id attribute (or name for anchors)
 	 */
-	struct object_params *object_params;
-
+	lwc_string *id;
 
 	/**
-	 * Iframe's browser_window, or NULL if none
+	 * Rarely used data, or NULL if the box has none.
 	 */
-	struct browser_window *iframe;
-
+	struct box_extra *extra;
 };
 
 
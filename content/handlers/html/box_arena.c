@@ -0,0 +1,232 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Box tree arena allocator implementation.
+ *
+ * The arena keeps two kinds of block:
+ *
+ *  - Slabs which are arrays of box structures. Boxes are handed out
+ *    in order and the slabs are walked at destruction to finalise the
+ *    boxes which are still live.
+ *
+ *  - Chunks which are bump allocated for everything else. Allocations
+ *    too large to fit sensibly in a chunk are given a chunk of their
+ *    own.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/errors.h"
+#include "utils/log.h"
+
+#include "html/box.h"
+#include "html/box_manipulate.h"
+#include "html/box_arena.h"
+
+/** Number of boxes in each slab */
+#define BOX_ARENA_SLAB_BOXES 256
+
+/** Size of the data area of a chunk */
+#define BOX_ARENA_CHUNK_SIZE (16 * 1024)
+
+/** Alignment of chunk allocations */
+#define BOX_ARENA_ALIGN 8
+
+/**
+ * A slab of boxes
+ */
+struct box_arena_slab {
+	struct box_arena_slab *next; /**< Next slab in list */
+	unsigned int used; /**< Number of boxes allocated from slab */
+	struct box box[BOX_ARENA_SLAB_BOXES]; /**< The boxes */
+};
+
+/**
+ * A chunk of memory for bump allocation
+ */
+struct box_arena_chunk {
+	struct box_arena_chunk *next; /**< Next chunk in list */
+	size_t size; /**< Size of data area */
+	size_t used; /**< Number of bytes of data area allocated */
+	uint64_t data[]; /**< Data area (64bit type for alignment) */
+};
+
+/**
+ * Box tree arena
+ */
+struct box_arena {
+	struct box_arena_slab *slabs; /**< Box slabs, current slab first */
+	struct box_arena_chunk *chunks; /**< Chunks, current chunk first */
+
+	unsigned int box_count; /**< Number of boxes allocated */
+	size_t chunk_bytes; /**< Bytes allocated from chunks */
+};
+
+
+/* exported interface documented in html/box_arena.h */
+nserror box_arena_create(struct box_arena **arena_out)
+{
+	struct box_arena *arena;
+
+	arena = calloc(1, sizeof(struct box_arena));
+	if (arena == NULL) {
+		return NSERROR_NOMEM;
+	}
+
+	*arena_out = arena;
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in html/box_arena.h */
+void box_arena_destroy(struct box_arena *arena)
+{
+	struct box_arena_slab *slab;
+	struct box_arena_chunk *chunk;
+	unsigned int idx;
+
+	NSLOG(netsurf, DEBUG,
+	      "box arena %p: %u boxes of %zu bytes, %zu bytes of data",
+	      arena, arena->box_count, sizeof(struct box),
+	      arena->chunk_bytes);
+
+	while (arena->slabs != NULL) {
+		slab = arena->slabs;
+		arena->slabs = slab->next;
+
+		for (idx = 0; idx < slab->used; idx++) {
+			if ((slab->box[idx].flags & (CLONE | FREED)) == 0) {
+				box_finalise(&slab->box[idx]);
+			}
+		}
+		free(slab);
+	}
+
+	while (arena->chunks != NULL) {
+		chunk = arena->chunks;
+		arena->chunks = chunk->next;
+		free(chunk);
+	}
+
+	free(arena);
+}
+
+
+/* exported interface documented in html/box_arena.h */
+struct box *box_arena_alloc_box(struct box_arena *arena)
+{
+	struct box_arena_slab *slab = arena->slabs;
+
+	if ((slab == NULL) || (slab->used == BOX_ARENA_SLAB_BOXES)) {
+		slab = malloc(sizeof(struct box_arena_slab));
+		if (slab == NULL) {
+			return NULL;
+		}
+		slab->used = 0;
+		slab->next = arena->slabs;
+		arena->slabs = slab;
+	}
+
+	arena->box_count++;
+
+	return &slab->box[slab->used++];
+}
+
+
+/**
+ * Add a new chunk to an arena.
+ *
+ * \param arena The arena to add the chunk to.
+ * \param size The minimum size of the data area.
+ * \return The new chunk or NULL on memory exhaustion.
+ */
+static struct box_arena_chunk *
+box_arena_new_chunk(struct box_arena *arena, size_t size)
+{
+	struct box_arena_chunk *chunk;
+
+	if (size < BOX_ARENA_CHUNK_SIZE) {
+		size = BOX_ARENA_CHUNK_SIZE;
+	}
+
+	chunk = malloc(sizeof(struct box_arena_chunk) + size);
+	if (chunk == NULL) {
+		return NULL;
+	}
+	chunk->size = size;
+	chunk->used = 0;
+
+	if ((arena->chunks == NULL) || (size == BOX_ARENA_CHUNK_SIZE)) {
+		/* new current chunk */
+		chunk->next = arena->chunks;
+		arena->chunks = chunk;
+	} else {
+		/* oversize chunk is inserted after the current chunk
+		 * so allocation continues from the current chunk.
+		 */
+		chunk->next = arena->chunks->next;
+		arena->chunks->next = chunk;
+	}
+
+	return chunk;
+}
+
+
+/* exported interface documented in html/box_arena.h */
+void *box_arena_alloc(struct box_arena *arena, size_t size)
+{
+	struct box_arena_chunk *chunk = arena->chunks;
+	void *ret;
+
+	/* round up to keep all allocations aligned */
+	size = (size + (BOX_ARENA_ALIGN - 1)) & ~(size_t)(BOX_ARENA_ALIGN - 1);
+
+	if ((chunk == NULL) || ((chunk->size - chunk->used) < size)) {
+		chunk = box_arena_new_chunk(arena, size);
+		if (chunk == NULL) {
+			return NULL;
+		}
+	}
+
+	ret = ((uint8_t *)chunk->data) + chunk->used;
+	chunk->used += size;
+	arena->chunk_bytes += size;
+
+	return ret;
+}
+
+
+/* exported interface documented in html/box_arena.h */
+char *box_arena_strdup(struct box_arena *arena, const char *s)
+{
+	size_t len = strlen(s) + 1;
+	char *ret;
+
+	ret = box_arena_alloc(arena, len);
+	if (ret != NULL) {
+		memcpy(ret, s, len);
+	}
+
+	return ret;
+}
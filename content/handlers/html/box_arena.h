@@ -0,0 +1,80 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Box tree arena allocator interface.
+ *
+ * Boxes are allocated from slabs holding many box structures and box
+ * text and other small per box data from a bump pointer arena. Nothing
+ * allocated from an arena is released individually; all of it is
+ * released together when the arena is destroyed.
+ */
+
+#ifndef NETSURF_HTML_BOX_ARENA_H
+#define NETSURF_HTML_BOX_ARENA_H
+
+struct box;
+struct box_arena;
+
+/**
+ * Create a box arena.
+ *
+ * \param arena_out updated with the new arena on success
+ * \return NSERROR_OK on success or NSERROR_NOMEM
+ */
+nserror box_arena_create(struct box_arena **arena_out);
+
+/**
+ * Destroy a box arena.
+ *
+ * Every box allocated from the arena which has not been freed and is
+ * not a clone is finalised with box_finalise() before all the arena
+ * memory is released.
+ *
+ * \param arena The arena to destroy.
+ */
+void box_arena_destroy(struct box_arena *arena);
+
+/**
+ * Allocate an uninitialised box from an arena.
+ *
+ * \param arena The arena to allocate from.
+ * \return The new box or NULL on memory exhaustion.
+ */
+struct box *box_arena_alloc_box(struct box_arena *arena);
+
+/**
+ * Allocate memory from an arena.
+ *
+ * \param arena The arena to allocate from.
+ * \param size The number of bytes to allocate.
+ * \return The allocation or NULL on memory exhaustion.
+ */
+void *box_arena_alloc(struct box_arena *arena, size_t size);
+
+/**
+ * Duplicate a string into an arena.
+ *
+ * \param arena The arena to allocate from.
+ * \param s The NULL terminated string to copy.
+ * \return The copy or NULL on memory exhaustion.
+ */
+char *box_arena_strdup(struct box_arena *arena, const char *s);
+
+#endif
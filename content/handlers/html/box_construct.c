@@ -29,6 +29,7 @@
 #include <dom/dom.h>
 
 #include "utils/errors.h"
+#include "utils/log.h"
 #include "utils/nsoption.h"
 #include "utils/corestrings.h"
 #include "utils/talloc.h"
@@ -43,6 +44,7 @@
 #include "html/object.h"
 #include "html/box.h"
 #include "html/box_manipulate.h"
+#include "html/box_arena.h"
 #include "html/box_construct.h"
 #include "html/box_special.h"
 #include "html/box_normalise.h"
@@ -61,6 +63,8 @@ struct box_construct_ctx {
 	box_construct_complete_cb cb;	/**< Callback to invoke on completion */
 
 	int *bctx;			/**< talloc context */
+
+	struct box_arena *box_arena;	/**< box tree arena */
 };
 
 /**
@@ -176,7 +180,8 @@ box_extract_properties(dom_node *n, struct box_construct_props *props)
 				props->parent_style = parent_box->style;
 				props->href = parent_box->href;
 				props->target = parent_box->target;
-				props->title = parent_box->title;
+				props->title = (parent_box->extra != NULL) ?
+						parent_box->extra->title : NULL;
 
 				dom_node_unref(parent_node);
 				break;
@@ -280,6 +285,7 @@ box_get_style(html_content *c,
 	ctx.universal = c->universal;
 	ctx.root_style = root_style;
 	ctx.parent_style = parent_style;
+	ctx.stats = c->select_stats;
 
 	/* Select style for element */
 	styles = nscss_get_style(&ctx, n, &c->media, inline_style);
@@ -335,7 +341,8 @@ box_construct_generate(dom_node *n,
 
 		/** \todo Not wise to drop const from the computed style */
 		gen = box_create(NULL, (css_computed_style *) style,
-				false, NULL, NULL, NULL, NULL, content->bctx);
+				false, NULL, NULL, NULL, NULL,
+				content->box_arena);
 		if (gen == NULL) {
 			return;
 		}
@@ -368,7 +375,7 @@ box_construct_marker(struct box *box,
 	struct box *marker;
 
 	marker = box_create(NULL, box->style, false, NULL, NULL, title,
-			NULL, ctx->bctx);
+			NULL, ctx->box_arena);
 	if (marker == false)
 		return false;
 
@@ -440,7 +447,7 @@ box_construct_marker(struct box *box,
 			}
 		}
 
-		marker->text = talloc_array(ctx->bctx, char, 20);
+		marker->text = box_arena_alloc(ctx->box_arena, 20);
 		if (marker->text == NULL)
 			return false;
 
@@ -560,7 +567,7 @@ box_construct_element(struct box_construct_ctx *ctx, bool *convert_children)
 
 	box = box_create(styles, styles->styles[CSS_PSEUDO_ELEMENT_NONE], false,
 			props.href, props.target, props.title, id,
-			ctx->bctx);
+			ctx->box_arena);
 	if (box == NULL)
 		return false;
 
@@ -648,8 +655,8 @@ box_construct_element(struct box_construct_ctx *ctx, bool *convert_children)
 		}
 
 		/* Can't do this, because the lifetimes of boxes and gadgets
-		 * are inextricably linked. Fortunately, talloc will save us
-		 * (for now) */
+		 * are inextricably linked. Fortunately, the box arena will
+		 * save us (for now) */
 		/* box_free_box(box); */
 
 		*convert_children = false;
@@ -681,7 +688,7 @@ box_construct_element(struct box_construct_ctx *ctx, bool *convert_children)
 				"Box must have containing block.");
 
 		props.inline_container = box_create(NULL, NULL, false, NULL,
-				NULL, NULL, NULL, ctx->bctx);
+				NULL, NULL, NULL, ctx->box_arena);
 		if (props.inline_container == NULL)
 			return false;
 
@@ -743,7 +750,7 @@ box_construct_element(struct box_construct_ctx *ctx, bool *convert_children)
 			/* Float: insert a float between the parent and box. */
 			struct box *flt = box_create(NULL, NULL, false,
 					props.href, props.target, props.title,
-					NULL, ctx->bctx);
+					NULL, ctx->box_arena);
 			if (flt == NULL)
 				return false;
 
@@ -803,7 +810,8 @@ static void box_construct_element_after(dom_node *n, html_content *content)
 		if (props.inline_container == NULL) {
 			/* Create inline container if we don't have one */
 			props.inline_container = box_create(NULL, NULL, false,
-					NULL, NULL, NULL, NULL, content->bctx);
+					NULL, NULL, NULL, NULL,
+					content->box_arena);
 			if (props.inline_container == NULL)
 				return;
 
@@ -814,9 +822,10 @@ static void box_construct_element_after(dom_node *n, html_content *content)
 		}
 
 		inline_end = box_create(NULL, box->style, false,
-				box->href, box->target, box->title,
+				box->href, box->target,
+				(box->extra != NULL) ? box->extra->title : NULL,
 				box->id == NULL ? NULL :
-				lwc_string_ref(box->id), content->bctx);
+				lwc_string_ref(box->id), content->box_arena);
 		if (inline_end != NULL) {
 			inline_end->type = BOX_INLINE_END;
 
@@ -1045,7 +1054,7 @@ static bool box_construct_text(struct box_construct_ctx *ctx)
 			 * (i.e. this box is the first child of its parent, or
 			 * was preceded by block-level siblings) */
 			props.inline_container = box_create(NULL, NULL, false,
-					NULL, NULL, NULL, NULL, ctx->bctx);
+					NULL, NULL, NULL, NULL, ctx->box_arena);
 			if (props.inline_container == NULL) {
 				free(text);
 				return false;
@@ -1061,7 +1070,7 @@ static bool box_construct_text(struct box_construct_ctx *ctx)
 		box = box_create(NULL,
 				(css_computed_style *) props.parent_style,
 				false, props.href, props.target, props.title,
-				NULL, ctx->bctx);
+				NULL, ctx->box_arena);
 		if (box == NULL) {
 			free(text);
 			return false;
@@ -1069,7 +1078,7 @@ static bool box_construct_text(struct box_construct_ctx *ctx)
 
 		box->type = BOX_TEXT;
 
-		box->text = talloc_strdup(ctx->bctx, text);
+		box->text = box_arena_strdup(ctx->box_arena, text);
 		free(text);
 		if (box->text == NULL)
 			return false;
@@ -1163,7 +1172,7 @@ static bool box_construct_text(struct box_construct_ctx *ctx)
 				 * siblings) */
 				props.inline_container = box_create(NULL, NULL,
 						false, NULL, NULL, NULL, NULL,
-						ctx->bctx);
+						ctx->box_arena);
 				if (props.inline_container == NULL) {
 					free(text);
 					return false;
@@ -1180,7 +1189,7 @@ static bool box_construct_text(struct box_construct_ctx *ctx)
 			box = box_create(NULL,
 				(css_computed_style *) props.parent_style,
 				false, props.href, props.target, props.title,
-				NULL, ctx->bctx);
+				NULL, ctx->box_arena);
 			if (box == NULL) {
 				free(text);
 				return false;
@@ -1188,7 +1197,7 @@ static bool box_construct_text(struct box_construct_ctx *ctx)
 
 			box->type = BOX_TEXT;
 
-			box->text = talloc_strdup(ctx->bctx, current);
+			box->text = box_arena_strdup(ctx->box_arena, current);
 			if (box->text == NULL) {
 				free(text);
 				return false;
@@ -1206,7 +1215,7 @@ static bool box_construct_text(struct box_construct_ctx *ctx)
 				/* Linebreak: create new inline container */
 				props.inline_container = box_create(NULL, NULL,
 						false, NULL, NULL, NULL, NULL,
-						ctx->bctx);
+						ctx->box_arena);
 				if (props.inline_container == NULL) {
 					free(text);
 					return false;
@@ -1339,6 +1348,13 @@ dom_to_box(dom_node *n,
 		}
 	}
 
+	if (c->box_arena == NULL) {
+		/* create the arena for the boxes of this box tree */
+		if (box_arena_create(&c->box_arena) != NSERROR_OK) {
+			return NSERROR_NOMEM;
+		}
+	}
+
 	ctx = malloc(sizeof(*ctx));
 	if (ctx == NULL) {
 		return NSERROR_NOMEM;
@@ -1349,6 +1365,7 @@ dom_to_box(dom_node *n,
 	ctx->root_box = NULL;
 	ctx->cb = cb;
 	ctx->bctx = c->bctx;
+	ctx->box_arena = c->box_arena;
 
 	*box_conversion_context = ctx;
 
@@ -1457,3 +1474,356 @@ box_extract_link(const html_content *content,
 
 	return true;
 }
+
+
+/**
+ * Find the style a restyled element inherits from
+ *
+ * \param n  element being restyled
+ * \return style of nearest ancestor element with a box or NULL
+ */
+static const css_computed_style *box_restyle_parent_style(dom_node *n)
+{
+	const css_computed_style *style = NULL;
+	dom_node *current = dom_node_ref(n);
+	dom_node *parent;
+	struct box *box;
+	dom_exception err;
+
+	while (style == NULL) {
+		err = dom_node_get_parent_node(current, &parent);
+		dom_node_unref(current);
+		if (err != DOM_NO_ERR || parent == NULL) {
+			return NULL;
+		}
+
+		box = box_for_node(parent);
+		if (box != NULL) {
+			style = box->style;
+		}
+		current = parent;
+	}
+	dom_node_unref(current);
+
+	return style;
+}
+
+
+/**
+ * Determine if selected styles would generate a pseudo element box
+ *
+ * \param styles  selection results for an element
+ * \param pseudo  the pseudo element
+ * \return true if the pseudo element would have a box
+ */
+static bool
+box_restyle_generates(const css_select_results *styles,
+		      enum css_pseudo_element pseudo)
+{
+	const css_computed_content_item *item;
+
+	return (styles->styles[pseudo] != NULL) &&
+		(css_computed_content(styles->styles[pseudo], &item) !=
+				CSS_CONTENT_NORMAL);
+}
+
+
+/**
+ * Determine if a change of style needs the box tree to be rebuilt
+ *
+ * Only properties which are used when boxes are constructed are
+ * considered; anything else is picked up by layout.
+ *
+ * \param box     box being restyled
+ * \param old     the box's current selection results
+ * \param styles  the box's new selection results
+ * \param root    whether the box is for the root element
+ * \return true if the box structure depends on the change
+ */
+static bool
+box_restyle_structural(const struct box *box,
+		       const css_select_results *old,
+		       const css_select_results *styles,
+		       bool root)
+{
+	const css_computed_style *a = old->styles[CSS_PSEUDO_ELEMENT_NONE];
+	const css_computed_style *b = styles->styles[CSS_PSEUDO_ELEMENT_NONE];
+
+	if ((ns_computed_display(a, root) != ns_computed_display(b, root)) ||
+	    (css_computed_position(a) != css_computed_position(b)) ||
+	    (css_computed_float(a) != css_computed_float(b)) ||
+	    (css_computed_white_space(a) != css_computed_white_space(b)) ||
+	    (css_computed_text_transform(a) !=
+			css_computed_text_transform(b))) {
+		return true;
+	}
+
+	if ((box->list_marker != NULL) &&
+	    (css_computed_list_style_type(a) !=
+			css_computed_list_style_type(b))) {
+		return true;
+	}
+
+	/* generated content is not compared so any is structural */
+	return box_restyle_generates(old, CSS_PSEUDO_ELEMENT_BEFORE) ||
+		box_restyle_generates(old, CSS_PSEUDO_ELEMENT_AFTER) ||
+		box_restyle_generates(styles, CSS_PSEUDO_ELEMENT_BEFORE) ||
+		box_restyle_generates(styles, CSS_PSEUDO_ELEMENT_AFTER);
+}
+
+
+/**
+ * Discard layout information cached on a restyled box
+ *
+ * \param box  the box
+ */
+static void box_restyle_invalidate(struct box *box)
+{
+	box->max_width = UNKNOWN_MAX_WIDTH;
+
+	if (box->type == BOX_TEXT || box->type == BOX_INLINE_END) {
+		box->width = UNKNOWN_WIDTH;
+		box->flags &= ~MEASURED;
+		if (box->space != 0) {
+			box->space = UNKNOWN_WIDTH;
+		}
+	}
+}
+
+
+/**
+ * Move a box borrowing an element's style to the element's new style
+ *
+ * \param box     box to update
+ * \param old     element's previous selection results
+ * \param styles  element's new selection results
+ */
+static void
+box_restyle_borrowed(struct box *box,
+		     const css_select_results *old,
+		     const css_select_results *styles)
+{
+	unsigned int i;
+
+	if (box->style == NULL) {
+		return;
+	}
+
+	for (i = 0; i != CSS_PSEUDO_ELEMENT_COUNT; i++) {
+		if (box->style == old->styles[i]) {
+			box->style = styles->styles[i];
+			break;
+		}
+	}
+}
+
+
+/**
+ * Update the descendants of a restyled box which have no element
+ *
+ * Text and generated boxes are moved to the new styles and anonymous
+ * boxes have their styles recomposed. The boxes of other elements are
+ * left for those elements' own restyle.
+ *
+ * \param c       html content
+ * \param box     the restyled box
+ * \param old     previous selection results of the restyled element
+ * \param styles  new selection results of the restyled element
+ */
+static void
+box_restyle_children(html_content *c,
+		     struct box *box,
+		     const css_select_results *old,
+		     const css_select_results *styles)
+{
+	struct box *child;
+	css_computed_style *style;
+	nscss_select_ctx ctx;
+
+	for (child = box->children; child != NULL; child = child->next) {
+		if (child->styles != NULL) {
+			continue;
+		}
+
+		if ((child->flags & STYLE_OWNED) && (child->style != NULL)) {
+			ctx.ctx = c->select_ctx;
+			ctx.quirks = (c->quirks == DOM_DOCUMENT_QUIRKS_MODE_FULL);
+			ctx.base_url = c->base_url;
+			ctx.universal = c->universal;
+
+			style = nscss_get_blank_style(&ctx, box->style);
+			if (style != NULL) {
+				css_computed_style_destroy(child->style);
+				child->style = style;
+			}
+		} else {
+			box_restyle_borrowed(child, old, styles);
+		}
+
+		box_restyle_invalidate(child);
+		box_restyle_children(c, child, old, styles);
+	}
+}
+
+
+/**
+ * Restyle the box of one element
+ *
+ * \param c             html content
+ * \param n             the element
+ * \param box           the element's box
+ * \param parent_style  style the element inherits from
+ * \return true if the box's style was replaced
+ */
+static bool
+box_restyle_box(html_content *c,
+		dom_node *n,
+		struct box *box,
+		const css_computed_style *parent_style)
+{
+	const css_computed_style *root_style = NULL;
+	css_select_results *styles;
+	css_select_results *old;
+	struct box *b;
+	bool root = box_is_root(n);
+
+	if (box->style != box->styles->styles[CSS_PSEUDO_ELEMENT_NONE]) {
+		/* style was replaced during construction */
+		return false;
+	}
+
+	if (root == false) {
+		for (b = box; b->parent != NULL; b = b->parent)
+			;
+		root_style = b->style;
+	}
+
+	styles = box_get_style(c, parent_style, root_style, n);
+	if (styles == NULL) {
+		return false;
+	}
+
+	if (box_restyle_structural(box, box->styles, styles, root)) {
+		NSLOG(netsurf, INFO, "restyle of box %p needs reconstruction",
+		      box);
+		css_select_results_destroy(styles);
+		return false;
+	}
+
+	old = box->styles;
+	box->styles = styles;
+	box->style = styles->styles[CSS_PSEUDO_ELEMENT_NONE];
+	box_restyle_invalidate(box);
+
+	box_restyle_children(c, box, old, styles);
+
+	/* the content of inline elements follows their box */
+	if (box->inline_end != NULL) {
+		for (b = box->next; b != NULL; b = b->next) {
+			if (b->styles == NULL) {
+				box_restyle_borrowed(b, old, styles);
+				box_restyle_invalidate(b);
+			}
+			if (b == box->inline_end) {
+				break;
+			}
+		}
+	}
+
+	if (box->list_marker != NULL) {
+		box_restyle_borrowed(box->list_marker, old, styles);
+		box_restyle_invalidate(box->list_marker);
+		box_restyle_children(c, box->list_marker, old, styles);
+	}
+
+	/* containing boxes' minimum and maximum widths may change */
+	for (b = box->parent; b != NULL; b = b->parent) {
+		b->max_width = UNKNOWN_MAX_WIDTH;
+	}
+
+	css_select_results_destroy(old);
+
+	return true;
+}
+
+
+/**
+ * Restyle the boxes of an element and its descendants
+ *
+ * \param c             html content
+ * \param n             the element
+ * \param parent_style  style the element inherits from
+ * \return true if any box's style was replaced
+ */
+static bool
+box_restyle_element(html_content *c,
+		    dom_node *n,
+		    const css_computed_style *parent_style)
+{
+	struct box *box = box_for_node(n);
+	dom_node *child, *next;
+	dom_node_type type;
+	dom_exception err;
+	bool changed = false;
+
+	if ((box != NULL) && (box->styles != NULL)) {
+		changed = box_restyle_box(c, n, box, parent_style);
+		parent_style = box->style;
+	}
+
+	err = dom_node_get_first_child(n, &child);
+	while ((err == DOM_NO_ERR) && (child != NULL)) {
+		err = dom_node_get_node_type(child, &type);
+		if ((err == DOM_NO_ERR) && (type == DOM_ELEMENT_NODE)) {
+			if (box_restyle_element(c, child, parent_style)) {
+				changed = true;
+			}
+		}
+
+		err = dom_node_get_next_sibling(child, &next);
+		dom_node_unref(child);
+		child = next;
+	}
+
+	return changed;
+}
+
+
+/* exported function documented in html/box_construct.h */
+bool box_restyle(html_content *c, dom_node *n, bool siblings)
+{
+	const css_computed_style *parent_style;
+	dom_node *sibling, *next;
+	dom_node_type type;
+	dom_exception err;
+	bool changed;
+
+	if ((c->select_ctx == NULL) || (c->layout == NULL)) {
+		/* box conversion has not finished styling the boxes */
+		return false;
+	}
+
+	parent_style = box_restyle_parent_style(n);
+
+	changed = box_restyle_element(c, n, parent_style);
+
+	if (siblings == false) {
+		return changed;
+	}
+
+	err = dom_node_get_next_sibling(n, &sibling);
+	while ((err == DOM_NO_ERR) && (sibling != NULL)) {
+		err = dom_node_get_node_type(sibling, &type);
+		if ((err == DOM_NO_ERR) && (type == DOM_ELEMENT_NODE)) {
+			if (box_restyle_element(c, sibling, parent_style)) {
+				changed = true;
+			}
+		}
+
+		err = dom_node_get_next_sibling(sibling, &next);
+		dom_node_unref(sibling);
+		sibling = next;
+	}
+
+	return changed;
+}
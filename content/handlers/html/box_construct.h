@@ -98,6 +98,21 @@ nserror cancel_dom_to_box(void *box_conversion_context);
  */
 struct box *box_for_node(struct dom_node *node);
 
+/**
+ * Restyle the boxes of an element after a change to it
+ *
+ * Styles are selected again for the element and its descendants and
+ * the boxes updated in place. Changes to styles which would alter the
+ * structure of the box tree are not applied.
+ *
+ * \param c content of type CONTENT_HTML the element is in
+ * \param n the element to restyle
+ * \param siblings whether the following siblings of the element must also
+ *                 be restyled
+ * \return true if the style of any box was replaced and layout is required
+ */
+bool box_restyle(struct html_content *c, struct dom_node *n, bool siblings);
+
 /**
  * Extract a URL from a relative link, handling junk like whitespace and
  * attempting to read a real URL from "javascript:" links.
@@ -733,7 +733,7 @@ void box_dump(FILE *stream, struct box *box, unsigned int depth, bool style)
 		fprintf(stream, "(object '%s') ",
 			nsurl_access(hlcache_handle_get_url(box->object)));
 	}
-	if (box->iframe) {
+	if ((box->extra != NULL) && (box->extra->iframe != NULL)) {
 		fprintf(stream, "(iframe) ");
 	}
 	if (box->gadget)
@@ -744,8 +744,8 @@ void box_dump(FILE *stream, struct box *box, unsigned int depth, bool style)
 		fprintf(stream, " -> '%s'", nsurl_access(box->href));
 	if (box->target)
 		fprintf(stream, " |%s|", box->target);
-	if (box->title)
-		fprintf(stream, " [%s]", box->title);
+	if ((box->extra != NULL) && (box->extra->title != NULL))
+		fprintf(stream, " [%s]", box->extra->title);
 	if (box->id)
 		fprintf(stream, " ID:%s", lwc_string_data(box->id));
 	if (box->type == BOX_INLINE || box->type == BOX_INLINE_END)
@@ -27,7 +27,6 @@
 
 
 #include "utils/errors.h"
-#include "utils/talloc.h"
 #include "utils/nsurl.h"
 #include "netsurf/types.h"
 #include "netsurf/mouse.h"
@@ -38,15 +37,11 @@
 #include "html/interaction.h"
 #include "html/box.h"
 #include "html/box_manipulate.h"
+#include "html/box_arena.h"
 
 
-/**
- * Destructor for box nodes which own styles
- *
- * \param b The box being destroyed.
- * \return 0 to allow talloc to continue destroying the tree.
- */
-static int box_talloc_destructor(struct box *b)
+/* Exported function documented in html/box_manipulate.h */
+void box_finalise(struct box *b)
 {
 	struct html_scrollbar_data *data;
 
@@ -82,8 +77,23 @@ static int box_talloc_destructor(struct box *b)
 		scrollbar_destroy(b->scroll_y);
 		free(data);
 	}
+}
+
 
-	return 0;
+/* Exported function documented in html/box_manipulate.h */
+struct box_extra *box_get_extra(struct box *box, struct box_arena *arena)
+{
+	if (box->extra == NULL) {
+		box->extra = box_arena_alloc(arena, sizeof(struct box_extra));
+		if (box->extra != NULL) {
+			box->extra->title = NULL;
+			box->extra->usemap = NULL;
+			box->extra->object_params = NULL;
+			box->extra->iframe = NULL;
+		}
+	}
+
+	return box->extra;
 }
 
 
@@ -96,17 +106,25 @@ box_create(css_select_results *styles,
 	   const char *target,
 	   const char *title,
 	   lwc_string *id,
-	   void *context)
+	   struct box_arena *arena)
 {
 	unsigned int i;
 	struct box *box;
 
-	box = talloc(context, struct box);
+	box = box_arena_alloc_box(arena);
 	if (!box) {
 		return 0;
 	}
 
-	talloc_set_destructor(box, box_talloc_destructor);
+	box->extra = NULL;
+	if (title != NULL) {
+		if (box_get_extra(box, arena) == NULL) {
+			/* nothing to finalise when the arena is destroyed */
+			box->flags = FREED;
+			return 0;
+		}
+		box->extra->title = title;
+	}
 
 	box->type = BOX_INLINE;
 	box->flags = 0;
@@ -129,7 +147,6 @@ box_create(css_select_results *styles,
 	box->space = 0;
 	box->href = (href == NULL) ? NULL : nsurl_ref(href);
 	box->target = target;
-	box->title = title;
 	box->columns = 1;
 	box->rows = 1;
 	box->start_column = 0;
@@ -146,12 +163,9 @@ box_create(css_select_results *styles,
 	box->list_marker = NULL;
 	box->col = NULL;
 	box->gadget = NULL;
-	box->usemap = NULL;
 	box->id = id;
 	box->background = NULL;
 	box->object = NULL;
-	box->object_params = NULL;
-	box->iframe = NULL;
 	box->node = NULL;
 
 	return box;
@@ -236,15 +250,11 @@ void box_free_box(struct box *box)
 	if (!(box->flags & CLONE)) {
 		if (box->gadget)
 			form_free_control(box->gadget);
-		if (box->scroll_x != NULL)
-			scrollbar_destroy(box->scroll_x);
-		if (box->scroll_y != NULL)
-			scrollbar_destroy(box->scroll_y);
-		if (box->styles != NULL)
-			css_select_results_destroy(box->styles);
+		box_finalise(box);
 	}
 
-	talloc_free(box);
+	/* the memory is released with the rest of the arena */
+	box->flags |= FREED;
 }
 
 
@@ -25,6 +25,7 @@
 #ifndef NETSURF_HTML_BOX_MANIPULATE_H
 #define NETSURF_HTML_BOX_MANIPULATE_H
 
+struct box_arena;
 
 /**
  * Create a box tree node.
@@ -36,13 +37,23 @@
  * \param  target       target for the box (not copied), or 0
  * \param  title        title for the box (not copied), or 0
  * \param  id           id for the box (not copied), or 0
- * \param  context      context for allocations
+ * \param  arena        box tree arena to allocate from
  * \return  allocated and initialised box, or 0 on memory exhaustion
  *
  * styles is always owned by the box, if it is set.
  * style is only owned by the box in the case of implied boxes.
  */
-struct box * box_create(css_select_results *styles, css_computed_style *style, bool style_owned, struct nsurl *href, const char *target, const char *title, lwc_string *id, void *context);
+struct box * box_create(css_select_results *styles, css_computed_style *style, bool style_owned, struct nsurl *href, const char *target, const char *title, lwc_string *id, struct box_arena *arena);
+
+
+/**
+ * Get the rarely used data of a box, creating it if necessary.
+ *
+ * \param box   box to get the data of
+ * \param arena box tree arena to allocate from
+ * \return the box's extra data, or NULL on memory exhaustion
+ */
+struct box_extra *box_get_extra(struct box *box, struct box_arena *arena);
 
 
 /**
@@ -89,6 +100,17 @@ void box_free(struct box *box);
 void box_free_box(struct box *box);
 
 
+/**
+ * Release the resources referenced by a single box structure.
+ *
+ * The styles, href, id, DOM node and scrollbars of the box are
+ * released. The box memory itself belongs to the box tree arena.
+ *
+ * \param box box to finalise
+ */
+void box_finalise(struct box *box);
+
+
 /**
  * Applies the given scroll setup to a box. This includes scroll
  * creation/deletion as well as scroll dimension updates.
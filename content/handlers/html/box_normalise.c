@@ -195,7 +195,7 @@ box_normalise_table_row(struct box *row,
 				return false;
 
 			cell = box_create(NULL, style, true, row->href,
-					row->target, NULL, NULL, c->bctx);
+					row->target, NULL, NULL, c->box_arena);
 			if (cell == NULL) {
 				css_computed_style_destroy(style);
 				return false;
@@ -331,7 +331,8 @@ box_normalise_table_row_group(struct box *row_group,
 				return false;
 
 			row = box_create(NULL, style, true, row_group->href,
-					row_group->target, NULL, NULL, c->bctx);
+					row_group->target, NULL, NULL,
+					c->box_arena);
 			if (row == NULL) {
 				css_computed_style_destroy(style);
 				return false;
@@ -408,7 +409,7 @@ box_normalise_table_row_group(struct box *row_group,
 		}
 
 		row = box_create(NULL, style, true, row_group->href,
-				row_group->target, NULL, NULL, c->bctx);
+				row_group->target, NULL, NULL, c->box_arena);
 		if (row == NULL) {
 			css_computed_style_destroy(style);
 			return false;
@@ -540,7 +541,8 @@ box_normalise_table_spans(struct box *table,
 					cell = box_create(NULL, style, true,
 							table_row->href,
 							table_row->target,
-							NULL, NULL, c->bctx);
+							NULL, NULL,
+							c->box_arena);
 					if (cell == NULL) {
 						css_computed_style_destroy(
 								style);
@@ -664,7 +666,7 @@ box_normalise_table(struct box *table, const struct box *root, html_content * c)
 			}
 
 			row_group = box_create(NULL, style, true, table->href,
-					table->target, NULL, NULL, c->bctx);
+					table->target, NULL, NULL, c->box_arena);
 			if (row_group == NULL) {
 				css_computed_style_destroy(style);
 				free(col_info.spans);
@@ -751,7 +753,7 @@ box_normalise_table(struct box *table, const struct box *root, html_content * c)
 		}
 
 		row_group = box_create(NULL, style, true, table->href,
-				table->target, NULL, NULL, c->bctx);
+				table->target, NULL, NULL, c->box_arena);
 		if (row_group == NULL) {
 			css_computed_style_destroy(style);
 			free(col_info.spans);
@@ -767,7 +769,7 @@ box_normalise_table(struct box *table, const struct box *root, html_content * c)
 		}
 
 		row = box_create(NULL, style, true, row_group->href,
-				row_group->target, NULL, NULL, c->bctx);
+				row_group->target, NULL, NULL, c->box_arena);
 		if (row == NULL) {
 			css_computed_style_destroy(style);
 			box_free(row_group);
@@ -953,7 +955,7 @@ box_normalise_block(struct box *block, const struct box *root, html_content *c)
 				return false;
 
 			table = box_create(NULL, style, true, block->href,
-					block->target, NULL, NULL, c->bctx);
+					block->target, NULL, NULL, c->box_arena);
 			if (table == NULL) {
 				css_computed_style_destroy(style);
 				return false;
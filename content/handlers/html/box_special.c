@@ -48,6 +48,7 @@
 #include "html/object.h"
 #include "html/box.h"
 #include "html/box_manipulate.h"
+#include "html/box_arena.h"
 #include "html/box_construct.h"
 #include "html/box_special.h"
 #include "html/box_textarea.h"
@@ -550,6 +551,35 @@ box_get_attribute(dom_node *n,
 }
 
 
+/**
+ * Get the imagemap used by an element.
+ *
+ * \param  content  html content being converted
+ * \param  n        dom element node
+ * \param  box      box to set the imagemap name of
+ * \return  true on success, false on memory exhaustion
+ */
+static bool
+box_get_usemap(html_content *content, dom_node *n, struct box *box)
+{
+	char *usemap = NULL;
+
+	if (!box_get_attribute(n, "usemap", content->bctx, &usemap))
+		return false;
+	if (usemap == NULL)
+		return true;
+
+	if (box_get_extra(box, content->box_arena) == NULL)
+		return false;
+
+	if (usemap[0] == '#')
+		usemap++;
+	box->extra->usemap = usemap;
+
+	return true;
+}
+
+
 /**
  * Helper function for adding textarea widget to box.
  *
@@ -563,16 +593,18 @@ box_input_text(html_content *html, struct box *box, struct dom_node *node)
 
 	box->type = BOX_INLINE_BLOCK;
 
-	inline_container = box_create(NULL, 0, false, 0, 0, 0, 0, html->bctx);
+	inline_container = box_create(NULL, 0, false, 0, 0, 0, 0,
+			html->box_arena);
 	if (!inline_container)
 		return false;
 	inline_container->type = BOX_INLINE_CONTAINER;
-	inline_box = box_create(NULL, box->style, false, 0, 0, box->title, 0,
-			html->bctx);
+	inline_box = box_create(NULL, box->style, false, 0, 0,
+			(box->extra != NULL) ? box->extra->title : NULL, 0,
+			html->box_arena);
 	if (!inline_box)
 		return false;
 	inline_box->type = BOX_TEXT;
-	inline_box->text = talloc_strdup(html->bctx, "");
+	inline_box->text = box_arena_strdup(html->box_arena, "");
 
 	box_add_child(inline_container, inline_box);
 	box_add_child(box, inline_container);
@@ -963,7 +995,9 @@ box_embed(dom_node *n,
 
 	dom_namednodemap_unref(attrs);
 
-	box->object_params = params;
+	if (box_get_extra(box, content->box_arena) == NULL)
+		return false;
+	box->extra->object_params = params;
 
 	/* start fetch */
 	box->flags |= IS_REPLACED;
@@ -1055,6 +1089,12 @@ box_iframe(dom_node *n,
 		return true;
 	}
 
+	/* the browser window is attached to the box's extra data */
+	if (box_get_extra(box, content->box_arena) == NULL) {
+		nsurl_unref(url);
+		return false;
+	}
+
 	/* create a new iframe */
 	iframe = talloc(content->bctx, struct content_html_iframe);
 	if (iframe == NULL) {
@@ -1165,7 +1205,7 @@ box_image(dom_node *n,
 		dom_string_unref(s);
 		if (alt == NULL)
 			return false;
-		box->text = talloc_strdup(content->bctx, alt);
+		box->text = box_arena_strdup(content->box_arena, alt);
 		free(alt);
 		if (box->text == NULL)
 			return false;
@@ -1177,10 +1217,8 @@ box_image(dom_node *n,
 	}
 
 	/* imagemap associated with this image */
-	if (!box_get_attribute(n, "usemap", content->bctx, &box->usemap))
+	if (!box_get_usemap(content, n, box))
 		return false;
-	if (box->usemap && box->usemap[0] == '#')
-		box->usemap++;
 
 	/* get image URL */
 	err = dom_element_get_attribute(n, corestring_dom_src, &s);
@@ -1283,30 +1321,31 @@ box_input(dom_node *n,
 			goto no_memory;
 
 		inline_container = box_create(NULL, 0, false, 0, 0, 0, 0,
-				content->bctx);
+				content->box_arena);
 		if (inline_container == NULL)
 			goto no_memory;
 
 		inline_container->type = BOX_INLINE_CONTAINER;
 
 		inline_box = box_create(NULL, box->style, false, 0, 0,
-				box->title, 0, content->bctx);
+				(box->extra != NULL) ? box->extra->title : NULL,
+				0, content->box_arena);
 		if (inline_box == NULL)
 			goto no_memory;
 
 		inline_box->type = BOX_TEXT;
 
 		if (box->gadget->value != NULL)
-			inline_box->text = talloc_strdup(content->bctx,
+			inline_box->text = box_arena_strdup(content->box_arena,
 					box->gadget->value);
 		else if (box->gadget->type == GADGET_SUBMIT)
-			inline_box->text = talloc_strdup(content->bctx,
+			inline_box->text = box_arena_strdup(content->box_arena,
 					messages_get("Form_Submit"));
 		else if (box->gadget->type == GADGET_RESET)
-			inline_box->text = talloc_strdup(content->bctx,
+			inline_box->text = box_arena_strdup(content->box_arena,
 					messages_get("Form_Reset"));
 		else
-			inline_box->text = talloc_strdup(content->bctx,
+			inline_box->text = box_arena_strdup(content->box_arena,
 							 "Button");
 
 		if (inline_box->text == NULL)
@@ -1409,11 +1448,8 @@ box_object(dom_node *n,
 	    ns_computed_display(box->style, box_is_root(n)) == CSS_DISPLAY_NONE)
 		return true;
 
-	if (box_get_attribute(n, "usemap", content->bctx, &box->usemap) ==
-			false)
+	if (!box_get_usemap(content, n, box))
 		return false;
-	if (box->usemap && box->usemap[0] == '#')
-		box->usemap++;
 
 	params = talloc(content->bctx, struct object_params);
 	if (params == NULL)
@@ -1617,7 +1653,9 @@ box_object(dom_node *n,
 		c = next;
 	}
 
-	box->object_params = params;
+	if (box_get_extra(box, content->box_arena) == NULL)
+		return false;
+	box->extra->object_params = params;
 
 	/* start fetch (MIME type is ok or not specified) */
 	box->flags |= IS_REPLACED;
@@ -1767,12 +1805,14 @@ box_select(dom_node *n,
 	box->flags |= IS_REPLACED;
 	gadget->box = box;
 
-	inline_container = box_create(NULL, 0, false, 0, 0, 0, 0, content->bctx);
+	inline_container = box_create(NULL, 0, false, 0, 0, 0, 0,
+			content->box_arena);
 	if (inline_container == NULL)
 		goto no_memory;
 	inline_container->type = BOX_INLINE_CONTAINER;
-	inline_box = box_create(NULL, box->style, false, 0, 0, box->title, 0,
-			content->bctx);
+	inline_box = box_create(NULL, box->style, false, 0, 0,
+			(box->extra != NULL) ? box->extra->title : NULL, 0,
+			content->box_arena);
 	if (inline_box == NULL)
 		goto no_memory;
 	inline_box->type = BOX_TEXT;
@@ -1789,6 +1829,9 @@ box_select(dom_node *n,
 				gadget->data.select.current->node, true);
 	}
 
+	/* The text is replaced whenever the selection changes so it is
+	 * not allocated from the box arena, see
+	 * form__select_process_selection() */
 	if (gadget->data.select.num_selected == 0)
 		inline_box->text = talloc_strdup(content->bctx,
 				messages_get("Form_None"));
@@ -41,8 +41,45 @@
 
 #include "html/html.h"
 #include "html/private.h"
+#include "html/box_construct.h"
 #include "html/css.h"
 
+/**
+ * An element waiting to be restyled
+ */
+struct html_restyle {
+	dom_node *node; /**< The element */
+	bool siblings; /**< Whether following siblings need restyling */
+};
+
+/** Initial number of elements allocated for restyling */
+#define RESTYLE_SIZE_MIN 16
+
+/**
+ * A stylesheet in a selection context
+ */
+struct html_select_sheet {
+	css_stylesheet *sheet; /**< The stylesheet */
+	css_origin origin; /**< Origin the stylesheet was added with */
+};
+
+/**
+ * A selection context shared by html contents using the same stylesheets
+ *
+ * Contents using a context hold the stylesheets it was built from so
+ * the sheet pointers identify them for as long as the context is used.
+ */
+struct html_select_ctx {
+	struct html_select_ctx *next; /**< Next context in list */
+	css_select_ctx *ctx; /**< The selection context */
+	unsigned int users; /**< Number of contents using the context */
+	uint32_t sheet_count; /**< Number of entries in sheets */
+	struct html_select_sheet sheets[]; /**< Stylesheets in order added */
+};
+
+/** Selection contexts in use */
+static struct html_select_ctx *html_select_ctxs;
+
 static nsurl *html_default_stylesheet_url;
 static nsurl *html_adblock_stylesheet_url;
 static nsurl *html_quirks_stylesheet_url;
@@ -347,6 +384,175 @@ bool html_css_update_style(html_content *c, dom_node *style)
 }
 
 
+/**
+ * restyle the elements waiting to be restyled.
+ */
+static void html_css_process_restyles(void *pw)
+{
+	html_content *c = pw;
+	struct html_restyle *restyles = c->restyles;
+	unsigned int count = c->restyle_count;
+	unsigned int i;
+	bool changed = false;
+
+	free(c->restyle_index);
+	c->restyle_index = NULL;
+	c->restyles = NULL;
+	c->restyle_count = 0;
+	c->restyle_size = 0;
+
+	for (i = 0; i != count; i++) {
+		if (box_restyle(c, restyles[i].node, restyles[i].siblings)) {
+			changed = true;
+		}
+		dom_node_unref(restyles[i].node);
+	}
+	free(restyles);
+
+	NSLOG(netsurf, DEBUG, "restyled %u elements of %p", count, c);
+
+	if (changed && c->had_initial_layout &&
+	    (c->base.status == CONTENT_STATUS_READY ||
+	     c->base.status == CONTENT_STATUS_DONE)) {
+		content__reformat(&c->base, false, c->base.available_width,
+				c->base.available_height);
+	}
+}
+
+
+/**
+ * Find the slot of an element in the restyle index.
+ *
+ * \param c The html content.
+ * \param node The element.
+ * \return The slot holding the element or the empty slot for it.
+ */
+static unsigned int *html_css_restyle_slot(html_content *c, dom_node *node)
+{
+	unsigned int mask = (c->restyle_size * 2) - 1;
+	uintptr_t hash = (uintptr_t) node;
+	unsigned int idx;
+
+	idx = ((hash >> 4) ^ (hash >> 12)) & mask;
+
+	/* entries hold the restyle index plus one so zero is empty */
+	while ((c->restyle_index[idx] != 0) &&
+	       (c->restyles[c->restyle_index[idx] - 1].node != node)) {
+		idx = (idx + 1) & mask;
+	}
+
+	return &c->restyle_index[idx];
+}
+
+
+/**
+ * Double the number of elements which may wait to be restyled.
+ *
+ * \param c The html content.
+ * \return NSERROR_OK on success else NSERROR_NOMEM.
+ */
+static nserror html_css_restyle_grow(html_content *c)
+{
+	struct html_restyle *restyles;
+	unsigned int *index;
+	unsigned int size;
+	unsigned int i;
+
+	size = (c->restyle_size == 0) ? RESTYLE_SIZE_MIN : c->restyle_size * 2;
+
+	restyles = realloc(c->restyles, sizeof(struct html_restyle) * size);
+	if (restyles == NULL) {
+		return NSERROR_NOMEM;
+	}
+	c->restyles = restyles;
+
+	index = calloc(size * 2, sizeof(unsigned int));
+	if (index == NULL) {
+		return NSERROR_NOMEM;
+	}
+	free(c->restyle_index);
+	c->restyle_index = index;
+	c->restyle_size = size;
+
+	for (i = 0; i != c->restyle_count; i++) {
+		*html_css_restyle_slot(c, c->restyles[i].node) = i + 1;
+	}
+
+	return NSERROR_OK;
+}
+
+
+/* exported function documented in html/css.h */
+nserror html_css_restyle(html_content *c, dom_node *node, bool siblings)
+{
+	unsigned int *slot;
+	nserror res;
+
+	if (c->restyle_count == c->restyle_size) {
+		res = html_css_restyle_grow(c);
+		if (res != NSERROR_OK) {
+			return res;
+		}
+	}
+
+	slot = html_css_restyle_slot(c, node);
+	if (*slot != 0) {
+		c->restyles[*slot - 1].siblings |= siblings;
+		return NSERROR_OK;
+	}
+
+	c->restyles[c->restyle_count].node = dom_node_ref(node);
+	c->restyles[c->restyle_count].siblings = siblings;
+	c->restyle_count++;
+	*slot = c->restyle_count;
+
+	/* batch changes made together, for example by one script */
+	guit->misc->schedule(0, html_css_process_restyles, c);
+
+	return NSERROR_OK;
+}
+
+
+/* exported function documented in html/css.h */
+bool
+html_css_selectors_use(html_content *c,
+		       enum nscss_selector_name type,
+		       const char *name,
+		       size_t len)
+{
+	struct html_stylesheet *s;
+	unsigned int i;
+
+	for (i = STYLESHEET_BASE, s = &c->stylesheets[STYLESHEET_BASE];
+	     i < c->stylesheet_count; i++, s++) {
+		if ((s->unused == false) && (s->sheet != NULL) &&
+		    nscss_selectors_use(s->sheet, type, name, len)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/* exported function documented in html/css.h */
+bool html_css_selectors_use_siblings(html_content *c)
+{
+	struct html_stylesheet *s;
+	unsigned int i;
+
+	for (i = STYLESHEET_BASE, s = &c->stylesheets[STYLESHEET_BASE];
+	     i < c->stylesheet_count; i++, s++) {
+		if ((s->unused == false) && (s->sheet != NULL) &&
+		    nscss_selectors_use_siblings(s->sheet)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
 /* exported function documented in html/css.h */
 bool html_css_process_style(html_content *c, dom_node *node)
 {
@@ -528,6 +734,17 @@ nserror html_css_free_stylesheets(html_content *html)
 	unsigned int i;
 
 	guit->misc->schedule(-1, html_css_process_modified_styles, html);
+	guit->misc->schedule(-1, html_css_process_restyles, html);
+
+	for (i = 0; i != html->restyle_count; i++) {
+		dom_node_unref(html->restyles[i].node);
+	}
+	free(html->restyles);
+	html->restyles = NULL;
+	free(html->restyle_index);
+	html->restyle_index = NULL;
+	html->restyle_count = 0;
+	html->restyle_size = 0;
 
 	for (i = 0; i != html->stylesheet_count; i++) {
 		if (html->stylesheets[i].sheet != NULL) {
@@ -643,26 +860,54 @@ nserror html_css_new_stylesheets(html_content *c)
 }
 
 
+/**
+ * Find a selection context built from a list of stylesheets
+ *
+ * \param sheets The stylesheets in the order they are added.
+ * \param sheet_count The number of stylesheets.
+ * \return The selection context or NULL if there is none.
+ */
+static struct html_select_ctx *
+html_css_find_selection_context(const struct html_select_sheet *sheets,
+				uint32_t sheet_count)
+{
+	struct html_select_ctx *sctx;
+
+	for (sctx = html_select_ctxs; sctx != NULL; sctx = sctx->next) {
+		if ((sctx->sheet_count == sheet_count) &&
+		    (memcmp(sctx->sheets, sheets,
+			    sheet_count * sizeof(*sheets)) == 0)) {
+			return sctx;
+		}
+	}
+
+	return NULL;
+}
+
+
 /* exported function documented in html/css.h */
 nserror
 html_css_new_selection_context(html_content *c, css_select_ctx **ret_select_ctx)
 {
 	uint32_t i;
+	uint32_t sheet_count = 0;
 	css_error css_ret;
 	css_select_ctx *select_ctx;
+	struct html_select_ctx *sctx;
+	struct html_select_sheet *sheets;
 
 	/* check that the base stylesheet loaded; layout fails without it */
 	if (c->stylesheets[STYLESHEET_BASE].sheet == NULL) {
 		return NSERROR_CSS_BASE;
 	}
 
-	/* Create selection context */
-	css_ret = css_select_ctx_create(&select_ctx);
-	if (css_ret != CSS_OK) {
-		return css_error_to_nserror(css_ret);
+	/* zeroed so structure padding compares equal */
+	sheets = calloc(c->stylesheet_count, sizeof(*sheets));
+	if (sheets == NULL) {
+		return NSERROR_NOMEM;
 	}
 
-	/* Add sheets to it */
+	/* Gather the sheets to add */
 	for (i = STYLESHEET_BASE; i != c->stylesheet_count; i++) {
 		const struct html_stylesheet *hsheet = &c->stylesheets[i];
 		css_stylesheet *sheet = NULL;
@@ -687,26 +932,96 @@ html_css_new_selection_context(html_content *c, css_select_ctx **ret_select_ctx)
 		}
 
 		if (sheet != NULL) {
-			/* TODO: Pass the sheet's full media query, instead of
-			 *       "screen".
-			 */
-			css_ret = css_select_ctx_append_sheet(select_ctx,
-							      sheet,
-							      origin,
-							      "screen");
-			if (css_ret != CSS_OK) {
-				css_select_ctx_destroy(select_ctx);
-				return css_error_to_nserror(css_ret);
-			}
+			sheets[sheet_count].sheet = sheet;
+			sheets[sheet_count].origin = origin;
+			sheet_count++;
 		}
 	}
 
+	/* Reuse a context built from the same sheets, as is usual when
+	 * navigating between pages of a site.
+	 */
+	sctx = html_css_find_selection_context(sheets, sheet_count);
+	if (sctx != NULL) {
+		free(sheets);
+		sctx->users++;
+		NSLOG(netsurf, DEBUG, "Reusing selection context %p (%u users)",
+		      sctx->ctx, sctx->users);
+		*ret_select_ctx = sctx->ctx;
+		return NSERROR_OK;
+	}
+
+	sctx = malloc(sizeof(*sctx) + sheet_count * sizeof(*sheets));
+	if (sctx == NULL) {
+		free(sheets);
+		return NSERROR_NOMEM;
+	}
+
+	/* Create selection context */
+	css_ret = css_select_ctx_create(&select_ctx);
+	if (css_ret != CSS_OK) {
+		free(sctx);
+		free(sheets);
+		return css_error_to_nserror(css_ret);
+	}
+
+	/* Add sheets to it */
+	for (i = 0; i != sheet_count; i++) {
+		/* TODO: Pass the sheet's full media query, instead of
+		 *       "screen".
+		 */
+		css_ret = css_select_ctx_append_sheet(select_ctx,
+						      sheets[i].sheet,
+						      sheets[i].origin,
+						      "screen");
+		if (css_ret != CSS_OK) {
+			css_select_ctx_destroy(select_ctx);
+			free(sctx);
+			free(sheets);
+			return css_error_to_nserror(css_ret);
+		}
+	}
+
+	sctx->ctx = select_ctx;
+	sctx->users = 1;
+	sctx->sheet_count = sheet_count;
+	memcpy(sctx->sheets, sheets, sheet_count * sizeof(*sheets));
+	free(sheets);
+
+	sctx->next = html_select_ctxs;
+	html_select_ctxs = sctx;
+
 	/* return new selection context to caller */
 	*ret_select_ctx = select_ctx;
 	return NSERROR_OK;
 }
 
 
+/* exported function documented in html/css.h */
+void html_css_release_selection_context(css_select_ctx *select_ctx)
+{
+	struct html_select_ctx **prev;
+	struct html_select_ctx *sctx;
+
+	for (prev = &html_select_ctxs; *prev != NULL; prev = &(*prev)->next) {
+		sctx = *prev;
+		if (sctx->ctx != select_ctx) {
+			continue;
+		}
+
+		if (--sctx->users == 0) {
+			*prev = sctx->next;
+			css_select_ctx_destroy(sctx->ctx);
+			free(sctx);
+		}
+		return;
+	}
+
+	/* not a shared context */
+	css_select_ctx_destroy(select_ctx);
+}
+
+
 /* exported function documented in html/css.h */
 nserror html_css_init(void)
 {
@@ -24,6 +24,8 @@
 #ifndef NETSURF_HTML_CSS_H
 #define NETSURF_HTML_CSS_H
 
+#include "css/css.h"
+
 /**
  * Initialise html content css handling.
  *
@@ -39,12 +41,25 @@ void html_css_fini(void);
 /**
  * create a new css selection context for an html content.
  *
+ * An existing context built from the same stylesheets is reused.
+ *
  * \param c The html content to create css selction on.
  * \param select_ctx A pointer to receive the new context.
  * \return NSERROR_OK on success and \a select_ctx updated else error code
  */
 nserror html_css_new_selection_context(struct html_content *c, css_select_ctx **select_ctx);
 
+/**
+ * Release a css selection context obtained for an html content.
+ *
+ * Selection contexts are shared between contents using the same
+ * stylesheets, so the context is destroyed once its last user
+ * releases it.
+ *
+ * \param select_ctx The selection context to release.
+ */
+void html_css_release_selection_context(css_select_ctx *select_ctx);
+
 /**
  * Initialise core stylesheets for a content
  *
@@ -95,6 +110,40 @@ bool html_css_process_link(struct html_content *htmlc, dom_node *node);
  */
 bool html_css_process_style(struct html_content *htmlc, dom_node *node);
 
+/**
+ * queue an element to be restyled
+ *
+ * The element and its descendants are restyled, shortly, along with
+ * their following siblings if required. Changes queued together are
+ * restyled together.
+ *
+ * \param htmlc The HTML content.
+ * \param node The DOM element to restyle.
+ * \param siblings Whether the element's following siblings need restyling.
+ * \return NSERROR_OK on success else error code.
+ */
+nserror html_css_restyle(struct html_content *htmlc, dom_node *node, bool siblings);
+
+/**
+ * determine if the selectors of an HTML content's stylesheets may use a name
+ *
+ * \param htmlc The HTML content.
+ * \param type The kind of name.
+ * \param name The name.
+ * \param len The length of name in bytes.
+ * \return false if no selector uses the name else true.
+ */
+bool html_css_selectors_use(struct html_content *htmlc, enum nscss_selector_name type, const char *name, size_t len);
+
+/**
+ * determine if the selectors of an HTML content's stylesheets may use
+ * sibling combinators
+ *
+ * \param htmlc The HTML content.
+ * \return false if no selector uses sibling combinators else true.
+ */
+bool html_css_selectors_use_siblings(struct html_content *htmlc);
+
 /**
  * process a css style dom node update 
  *
@@ -25,6 +25,7 @@
 #include <string.h>
 
 #include "utils/config.h"
+#include "utils/utils.h"
 #include "utils/corestrings.h"
 #include "utils/nsoption.h"
 #include "utils/log.h"
@@ -33,6 +34,8 @@
 #include "utils/nsurl.h"
 #include "content/content.h"
 #include "javascript/js.h"
+#include "css/select.h"
+#include "css/hints.h"
 
 #include "netsurf/bitmap.h"
 
@@ -577,6 +580,36 @@ static void html_texty_element_update(html_content *htmlc, dom_node *node)
 }
 
 
+/**
+ * Restyle the whole document after its structure has changed
+ *
+ * Insertions and removals can change which elements any selector
+ * matches, not just the styles of the changed node, so every element
+ * is restyled. Nothing is done until box conversion has finished as
+ * boxes are styled when they are constructed.
+ *
+ * \param htmlc The html content
+ */
+static void html_dom_restyle_document(html_content *htmlc)
+{
+	dom_element *html;
+	dom_exception exc;
+
+	if (htmlc->layout == NULL) {
+		return;
+	}
+
+	exc = dom_document_get_document_element(htmlc->document, &html);
+	if ((exc != DOM_NO_ERR) || (html == NULL)) {
+		return;
+	}
+
+	html_css_restyle(htmlc, (dom_node *)html, false);
+
+	dom_node_unref(html);
+}
+
+
 /**
  * callback for DOMNodeInserted end type
  */
@@ -658,10 +691,25 @@ dom_default_action_DOMNodeInserted_cb(struct dom_event *evt, void *pw)
 			}
 		}
 	}
+
+	html_dom_restyle_document(htmlc);
+
 	dom_node_unref(node);
 }
 
 
+/**
+ * callback for DOMNodeRemoved end type
+ */
+static void
+dom_default_action_DOMNodeRemoved_cb(struct dom_event *evt, void *pw)
+{
+	html_content *htmlc = pw;
+
+	html_dom_restyle_document(htmlc);
+}
+
+
 /**
  * callback for DOMNodeInsertedIntoDocument end type
  */
@@ -744,6 +792,194 @@ dom_default_action_DOMSubtreeModified_cb(struct dom_event *evt, void *pw)
 }
 
 
+/**
+ * Determine if a whitespace separated list of names contains a name
+ *
+ * \param list The list
+ * \param list_len The length of the list in bytes
+ * \param name The name to find
+ * \param len The length of the name in bytes
+ * \return true if the name is in the list
+ */
+static bool
+html_name_list_contains(const char *list, size_t list_len,
+			const char *name, size_t len)
+{
+	size_t i = 0;
+	size_t start;
+
+	while (i < list_len) {
+		while (i < list_len && ascii_is_space(list[i])) {
+			i++;
+		}
+		start = i;
+		while (i < list_len && !ascii_is_space(list[i])) {
+			i++;
+		}
+		if ((i > start) && (i - start == len) &&
+		    (memcmp(list + start, name, len) == 0)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/**
+ * Determine if selectors use a name in only one of two lists of names
+ *
+ * Names in both the list of previous values of an attribute and the
+ * list of new values are unchanged so cannot change any style.
+ *
+ * \param htmlc The html content
+ * \param type The kind of names in the lists
+ * \param a One whitespace separated list of names or NULL
+ * \param b The other whitespace separated list of names or NULL
+ * \return true if any name added or removed may be used by a selector
+ */
+static bool
+html_changed_names_used(html_content *htmlc,
+			enum nscss_selector_name type,
+			dom_string *a,
+			dom_string *b)
+{
+	dom_string *lists[2] = { a, b };
+	const char *list, *other;
+	size_t list_len, other_len;
+	size_t i, start;
+	unsigned int l;
+
+	for (l = 0; l < 2; l++) {
+		if (lists[l] == NULL) {
+			continue;
+		}
+		list = dom_string_data(lists[l]);
+		list_len = dom_string_byte_length(lists[l]);
+
+		if (lists[1 - l] != NULL) {
+			other = dom_string_data(lists[1 - l]);
+			other_len = dom_string_byte_length(lists[1 - l]);
+		} else {
+			other = "";
+			other_len = 0;
+		}
+
+		i = 0;
+		while (i < list_len) {
+			while (i < list_len && ascii_is_space(list[i])) {
+				i++;
+			}
+			start = i;
+			while (i < list_len && !ascii_is_space(list[i])) {
+				i++;
+			}
+			if ((i > start) &&
+			    !html_name_list_contains(other, other_len,
+						     list + start, i - start) &&
+			    html_css_selectors_use(htmlc, type,
+						   list + start, i - start)) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+
+/**
+ * callback for DOMAttrModified end type
+ *
+ * The element is only restyled if the stylesheets' selectors or the
+ * presentational hints may depend on the attribute which changed.
+ */
+static void
+dom_default_action_DOMAttrModified_cb(struct dom_event *evt, void *pw)
+{
+	html_content *htmlc = pw;
+	dom_event_target *node;
+	dom_string *name = NULL;
+	dom_string *prev = NULL;
+	dom_string *value = NULL;
+	dom_node_type type;
+	dom_exception exc;
+	bool restyle = false;
+	bool siblings = false;
+
+	if (htmlc->layout == NULL) {
+		/* boxes are styled when box conversion constructs them */
+		return;
+	}
+
+	exc = dom_event_get_target(evt, &node);
+	if ((exc != DOM_NO_ERR) || (node == NULL)) {
+		return;
+	}
+
+	exc = dom_node_get_node_type(node, &type);
+	if ((exc != DOM_NO_ERR) || (type != DOM_ELEMENT_NODE)) {
+		dom_node_unref(node);
+		return;
+	}
+
+	exc = dom_mutation_event_get_attr_name(evt, &name);
+	if ((exc != DOM_NO_ERR) || (name == NULL)) {
+		dom_node_unref(node);
+		return;
+	}
+
+	exc = dom_mutation_event_get_prev_value(evt, &prev);
+	if (exc != DOM_NO_ERR) {
+		prev = NULL;
+	}
+	exc = dom_mutation_event_get_new_value(evt, &value);
+	if (exc != DOM_NO_ERR) {
+		value = NULL;
+	}
+
+	if (dom_string_caseless_isequal(name, corestring_dom_class)) {
+		restyle = siblings = html_changed_names_used(htmlc,
+				NSCSS_SELECTOR_CLASS, prev, value) ||
+			html_css_selectors_use(htmlc, NSCSS_SELECTOR_ATTRIBUTE,
+					"class", SLEN("class"));
+	} else if (dom_string_caseless_isequal(name, corestring_dom_id)) {
+		restyle = siblings = html_changed_names_used(htmlc,
+				NSCSS_SELECTOR_ID, prev, value) ||
+			html_css_selectors_use(htmlc, NSCSS_SELECTOR_ATTRIBUTE,
+					"id", SLEN("id"));
+	} else if (dom_string_caseless_isequal(name, corestring_dom_style)) {
+		/* inline style only applies to the element itself */
+		restyle = true;
+	} else {
+		restyle = siblings = html_css_selectors_use(htmlc,
+				NSCSS_SELECTOR_ATTRIBUTE,
+				dom_string_data(name),
+				dom_string_byte_length(name));
+		if (css_hint_attribute(name)) {
+			restyle = true;
+		}
+	}
+
+	if (siblings) {
+		siblings = html_css_selectors_use_siblings(htmlc);
+	}
+
+	if (restyle) {
+		html_css_restyle(htmlc, (dom_node *)node, siblings);
+	}
+
+	if (value != NULL) {
+		dom_string_unref(value);
+	}
+	if (prev != NULL) {
+		dom_string_unref(prev);
+	}
+	dom_string_unref(name);
+	dom_node_unref(node);
+}
+
+
 /**
  * callback for default action finished
  */
@@ -768,11 +1004,20 @@ html_dom_event_fetcher(dom_string *type,
 
 	if (phase == DOM_DEFAULT_ACTION_END) {
 		if (dom_string_isequal(type, corestring_dom_DOMNodeInserted)) {
+			nscss_select_invalidate_siblings();
 			return dom_default_action_DOMNodeInserted_cb;
 		} else if (dom_string_isequal(type, corestring_dom_DOMNodeInsertedIntoDocument)) {
 			return dom_default_action_DOMNodeInsertedIntoDocument_cb;
+		} else if (dom_string_isequal(type, corestring_dom_DOMNodeRemoved)) {
+			nscss_select_invalidate_siblings();
+			return dom_default_action_DOMNodeRemoved_cb;
 		} else if (dom_string_isequal(type, corestring_dom_DOMSubtreeModified)) {
+			nscss_select_invalidate_siblings();
 			return dom_default_action_DOMSubtreeModified_cb;
+		} else if (dom_string_isequal(type, corestring_dom_DOMAttrModified)) {
+			/* cached selection state depends on attributes */
+			nscss_select_invalidate_siblings();
+			return dom_default_action_DOMAttrModified_cb;
 		}
 	} else if (phase == DOM_DEFAULT_ACTION_FINISHED) {
 		return dom_default_action_finished_cb;
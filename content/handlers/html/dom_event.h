@@ -35,6 +35,7 @@
  *   DOMAttrModified
  *   DOMNodeInserted
  *   DOMNodeInsertedIntoDocument
+ *   DOMNodeRemoved
  *
  * @return callback function pointer or NULL for none
  */
@@ -22,12 +22,56 @@
  * HTML internal font handling implementation.
  */
 
+#include <stdint.h>
+#include <string.h>
+
 #include "utils/nsoption.h"
+#include "utils/log.h"
 #include "netsurf/plot_style.h"
+#include "netsurf/layout.h"
 #include "css/utils.h"
 
 #include "html/font.h"
 
+/** Number of entries in the width measurement cache, must be power of 2 */
+#define FONT_WIDTH_CACHE_SIZE 1024
+
+/** Longest string, in bytes, the width measurement cache will hold */
+#define FONT_WIDTH_CACHE_MAX_LENGTH 31
+
+/** Most font family names a width measurement cache entry will hold */
+#define FONT_WIDTH_CACHE_FAMILIES 4
+
+/**
+ * Entry in the width measurement cache.
+ */
+struct font_width_entry {
+	/** Referenced font family names, NULL terminated if fewer */
+	lwc_string *families[FONT_WIDTH_CACHE_FAMILIES];
+	plot_font_generic_family_t family; /**< Generic family */
+	plot_style_fixed size; /**< Font size */
+	int weight; /**< Font weight */
+	plot_font_flags_t flags; /**< Font flags */
+	int width; /**< Measured width */
+	uint8_t length; /**< Length of string or 0 for an empty entry */
+	char string[FONT_WIDTH_CACHE_MAX_LENGTH]; /**< Measured string */
+};
+
+/**
+ * Width measurement cache.
+ *
+ * Pages frequently contain the same words in the same style many
+ * times (table cells especially) and every text box needs the width
+ * of a space measured. The frontend measurement is comparatively
+ * expensive so recent measurements are held in a direct mapped
+ * table.
+ */
+static struct {
+	struct font_width_entry entry[FONT_WIDTH_CACHE_SIZE];
+	unsigned int hits; /**< Number of cache hits since flush */
+	unsigned int misses; /**< Number of cache misses since flush */
+} font_width_cache;
+
 /**
  * Map a generic CSS font family to a generic plot font family
  *
@@ -162,3 +206,139 @@ void font_plot_style_from_css(
 	fstyle->foreground = nscss_color_to_ns(col);
 	fstyle->background = 0;
 }
+
+
+/**
+ * Count the font family names of a plot style.
+ *
+ * \param families The NULL terminated font family names or NULL.
+ * \return The number of font family names.
+ */
+static unsigned int font_width_family_count(lwc_string * const *families)
+{
+	unsigned int count = 0;
+
+	if (families != NULL) {
+		while (families[count] != NULL) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+
+/**
+ * Release the font family names held by a width measurement cache entry.
+ *
+ * \param entry The cache entry.
+ */
+static void font_width_entry_release(struct font_width_entry *entry)
+{
+	unsigned int idx;
+
+	for (idx = 0; idx < FONT_WIDTH_CACHE_FAMILIES; idx++) {
+		if (entry->families[idx] == NULL) {
+			break;
+		}
+		lwc_string_unref(entry->families[idx]);
+		entry->families[idx] = NULL;
+	}
+}
+
+
+/* exported function documented in html/font.h */
+void html_font_width_cache_flush(void)
+{
+	unsigned int idx;
+
+	NSLOG(layout, DEBUG, "font width cache %u hits %u misses",
+	      font_width_cache.hits, font_width_cache.misses);
+
+	for (idx = 0; idx < FONT_WIDTH_CACHE_SIZE; idx++) {
+		font_width_entry_release(&font_width_cache.entry[idx]);
+	}
+
+	memset(&font_width_cache, 0, sizeof(font_width_cache));
+}
+
+
+/* exported function documented in html/font.h */
+nserror html_font_width(const struct gui_layout_table *font_func,
+			const plot_font_style_t *fstyle,
+			const char *string,
+			size_t length,
+			int *width)
+{
+	struct font_width_entry *entry;
+	uint32_t hash = 0x811c9dc5; /* FNV-1a offset basis */
+	unsigned int count;
+	size_t idx;
+	nserror res;
+
+	count = font_width_family_count(fstyle->families);
+
+	if ((length == 0) || (length > FONT_WIDTH_CACHE_MAX_LENGTH) ||
+	    (count > FONT_WIDTH_CACHE_FAMILIES)) {
+		return font_func->width(fstyle, string, length, width);
+	}
+
+	for (idx = 0; idx < length; idx++) {
+		hash = (hash ^ (uint8_t)string[idx]) * 0x01000193;
+	}
+	for (idx = 0; idx < count; idx++) {
+		hash = (hash ^ (uint32_t)(uintptr_t)fstyle->families[idx]) *
+				0x01000193;
+	}
+	hash = (hash ^ (uint32_t)fstyle->size) * 0x01000193;
+	hash = (hash ^ (uint32_t)fstyle->weight) * 0x01000193;
+	hash = (hash ^ ((uint32_t)fstyle->family << 8 | fstyle->flags)) *
+			0x01000193;
+
+	entry = &font_width_cache.entry[hash & (FONT_WIDTH_CACHE_SIZE - 1)];
+
+	/* family names are interned so are compared by reference */
+	for (idx = 0; idx < count; idx++) {
+		if (entry->families[idx] != fstyle->families[idx]) {
+			break;
+		}
+	}
+
+	if ((entry->length == length) &&
+	    (idx == count) &&
+	    ((count == FONT_WIDTH_CACHE_FAMILIES) ||
+	     (entry->families[count] == NULL)) &&
+	    (entry->family == fstyle->family) &&
+	    (entry->size == fstyle->size) &&
+	    (entry->weight == fstyle->weight) &&
+	    (entry->flags == fstyle->flags) &&
+	    (memcmp(entry->string, string, length) == 0)) {
+		font_width_cache.hits++;
+		*width = entry->width;
+		return NSERROR_OK;
+	}
+
+	font_width_cache.misses++;
+
+	res = font_func->width(fstyle, string, length, width);
+	if (res != NSERROR_OK) {
+		return res;
+	}
+
+	/* the entry holds references to the family names so it
+	 * remains valid after the style it was measured with is freed
+	 */
+	font_width_entry_release(entry);
+	for (idx = 0; idx < count; idx++) {
+		entry->families[idx] = lwc_string_ref(fstyle->families[idx]);
+	}
+	entry->family = fstyle->family;
+	entry->size = fstyle->size;
+	entry->weight = fstyle->weight;
+	entry->flags = fstyle->flags;
+	entry->width = *width;
+	entry->length = length;
+	memcpy(entry->string, string, length);
+
+	return NSERROR_OK;
+}
@@ -28,6 +28,7 @@
 #define NETSURF_HTML_FONT_H
 
 struct plot_font_style;
+struct gui_layout_table;
 
 /**
  * Populate a font style using data from a computed CSS style
@@ -40,4 +41,31 @@ void font_plot_style_from_css(const nscss_len_ctx *len_ctx,
 			      const css_computed_style *css,
 			      struct plot_font_style *fstyle);
 
+/**
+ * Measure the width of a string through the width measurement cache.
+ *
+ * Short strings are looked up in a cache of recent measurements
+ * before falling back to the frontend layout table.
+ *
+ * \param font_func Frontend layout table used to measure on cache miss
+ * \param fstyle    plot style for the text
+ * \param string    UTF-8 string to measure
+ * \param length    length of string, in bytes
+ * \param width     updated to width of string[0..length)
+ * \return NSERROR_OK and width updated or error code on faliure
+ */
+nserror html_font_width(const struct gui_layout_table *font_func,
+			const struct plot_font_style *fstyle,
+			const char *string,
+			size_t length,
+			int *width);
+
+/**
+ * Discard all entries in the width measurement cache.
+ *
+ * Entries hold references to the font family names they were measured
+ * with, which this releases.
+ */
+void html_font_width_cache_flush(void);
+
 #endif
@@ -55,6 +55,7 @@
 #include "desktop/textarea.h"
 #include "netsurf/bitmap.h"
 #include "javascript/js.h"
+#include "css/select.h"
 #include "desktop/gui_internal.h"
 
 #include "html/html.h"
@@ -63,9 +64,11 @@
 #include "html/css.h"
 #include "html/object.h"
 #include "html/html_save.h"
+#include "html/font.h"
 #include "html/interaction.h"
 #include "html/box.h"
 #include "html/box_construct.h"
+#include "html/box_arena.h"
 #include "html/box_inspect.h"
 #include "html/form_internal.h"
 #include "html/imagemap.h"
@@ -460,11 +463,13 @@ html_create_html_data(html_content *c, const http_parameter *params)
 	c->reflowing = false;
 	c->title = NULL;
 	c->bctx = NULL;
+	c->box_arena = NULL;
 	c->layout = NULL;
 	c->background_colour = NS_TRANSPARENT;
 	c->stylesheet_count = 0;
 	c->stylesheets = NULL;
 	c->select_ctx = NULL;
+	c->select_stats = NULL;
 	c->media.type = CSS_MEDIA_SCREEN;
 	c->universal = NULL;
 	c->num_objects = 0;
@@ -493,6 +498,13 @@ html_create_html_data(html_content *c, const http_parameter *params)
 		return NSERROR_NOMEM;
 	}
 
+	nerror = nscss_select_stats_create(&c->select_stats);
+	if (nerror != NSERROR_OK) {
+		lwc_string_unref(c->universal);
+		c->universal = NULL;
+		return nerror;
+	}
+
 	c->sel = selection_create((struct content *)c);
 
 	nerror = http_parameter_list_find_item(params, corestring_lwc_charset, &charset);
@@ -504,6 +516,8 @@ html_create_html_data(html_content *c, const http_parameter *params)
 		if (c->encoding == NULL) {
 			lwc_string_unref(c->universal);
 			c->universal = NULL;
+			nscss_select_stats_destroy(c->select_stats);
+			c->select_stats = NULL;
 			return NSERROR_NOMEM;
 
 		}
@@ -541,6 +555,9 @@ html_create_html_data(html_content *c, const http_parameter *params)
 		lwc_string_unref(c->universal);
 		c->universal = NULL;
 
+		nscss_select_stats_destroy(c->select_stats);
+		c->select_stats = NULL;
+
 		return libdom_hubbub_error_to_nserror(error);
 	}
 
@@ -557,6 +574,9 @@ html_create_html_data(html_content *c, const http_parameter *params)
 		lwc_string_unref(c->universal);
 		c->universal = NULL;
 
+		nscss_select_stats_destroy(c->select_stats);
+		c->select_stats = NULL;
+
 		NSLOG(netsurf, INFO, "Unable to set user data.");
 		return NSERROR_DOM;
 	}
@@ -1158,9 +1178,17 @@ static void html_destroy_iframe(struct content_html_iframe *iframe)
 
 static void html_free_layout(html_content *htmlc)
 {
+	if (htmlc->box_arena != NULL) {
+		/* destroying the arena releases every box and box text
+		 * together rather than walking the tree
+		 */
+		box_arena_destroy(htmlc->box_arena);
+		htmlc->box_arena = NULL;
+	}
+
 	if (htmlc->bctx != NULL) {
-		/* freeing talloc context should let the entire box
-		 * set be destroyed
+		/* freeing talloc context should let the remaining box
+		 * data be destroyed
 		 */
 		talloc_free(htmlc->bctx);
 	}
@@ -1215,6 +1243,8 @@ static void html_destroy(struct content *c)
 	}
 
 	if (html->document != NULL) {
+		/* cached selection state must not outlive the nodes */
+		nscss_select_cache_flush();
 		dom_node_unref(html->document);
 		html->document = NULL;
 	}
@@ -1251,10 +1281,15 @@ static void html_destroy(struct content *c)
 
 	/* Destroy selection context */
 	if (html->select_ctx != NULL) {
-		css_select_ctx_destroy(html->select_ctx);
+		html_css_release_selection_context(html->select_ctx);
 		html->select_ctx = NULL;
 	}
 
+	if (html->select_stats != NULL) {
+		nscss_select_stats_destroy(html->select_stats);
+		html->select_stats = NULL;
+	}
+
 	if (html->universal != NULL) {
 		lwc_string_unref(html->universal);
 		html->universal = NULL;
@@ -1437,9 +1472,10 @@ html_get_contextual_content(struct content *c, int x, int y,
 			continue;
 		}
 
-		if (box->iframe) {
-			float scale = browser_window_get_scale(box->iframe);
-			browser_window_get_features(box->iframe,
+		if ((box->extra != NULL) && (box->extra->iframe != NULL)) {
+			float scale;
+			scale = browser_window_get_scale(box->extra->iframe);
+			browser_window_get_features(box->extra->iframe,
 						    (x - box_x) * scale,
 						    (y - box_y) * scale,
 						    data);
@@ -1455,10 +1491,10 @@ html_get_contextual_content(struct content *c, int x, int y,
 		if (box->href)
 			data->link = box->href;
 
-		if (box->usemap) {
+		if ((box->extra != NULL) && (box->extra->usemap != NULL)) {
 			const char *target = NULL;
-			nsurl *url = imagemap_get(html, box->usemap, box_x,
-					box_y, x, y, &target);
+			nsurl *url = imagemap_get(html, box->extra->usemap,
+					box_x, box_y, x, y, &target);
 			/* Box might have imagemap, but no actual link area
 			 * at point */
 			if (url != NULL)
@@ -1517,10 +1553,11 @@ html_scroll_at_point(struct content *c, int x, int y, int scrx, int scry)
 			continue;
 
 		/* Pass into iframe */
-		if (box->iframe) {
-			float scale = browser_window_get_scale(box->iframe);
+		if ((box->extra != NULL) && (box->extra->iframe != NULL)) {
+			float scale;
+			scale = browser_window_get_scale(box->extra->iframe);
 
-			if (browser_window_scroll_at_point(box->iframe,
+			if (browser_window_scroll_at_point(box->extra->iframe,
 							   (x - box_x) * scale,
 							   (y - box_y) * scale,
 							   scrx, scry) == true)
@@ -1665,10 +1702,11 @@ static bool html_drop_file_at_point(struct content *c, int x, int y, char *file)
 		    css_computed_visibility(box->style) == CSS_VISIBILITY_HIDDEN)
 			continue;
 
-		if (box->iframe) {
-			float scale = browser_window_get_scale(box->iframe);
+		if ((box->extra != NULL) && (box->extra->iframe != NULL)) {
+			float scale;
+			scale = browser_window_get_scale(box->extra->iframe);
 			return browser_window_drop_file_at_point(
-				box->iframe,
+				box->extra->iframe,
 				(x - box_x) * scale,
 				(y - box_y) * scale,
 				file);
@@ -1833,6 +1871,8 @@ html_debug_dump(struct content *c, FILE *f, enum content_debug op)
 		assert(htmlc->layout != NULL);
 		box_dump(f, htmlc->layout, 0, true);
 		ret = NSERROR_OK;
+	} else if (op == CONTENT_DEBUG_SELECT) {
+		ret = nscss_select_stats_dump(htmlc->select_stats, f);
 	} else {
 		if (htmlc->document == NULL) {
 			NSLOG(netsurf, INFO, "No document to dump");
@@ -2179,6 +2219,7 @@ static content_type html_content_type(void)
 
 static void html_fini(void)
 {
+	html_font_width_cache_flush();
 	html_css_fini();
 }
 
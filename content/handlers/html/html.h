@@ -96,6 +96,7 @@ struct content_html_object {
 
 	struct hlcache_handle *content;  /**< Content, or 0. */
 	struct box *box;  /**< Node in box tree containing it. */
+	struct nsurl *url; /**< URL of deferred fetch, or NULL. */
 	/** Bitmap of acceptable content types */
 	content_type permitted_types;
 	bool background;  /**< This object is a background image. */
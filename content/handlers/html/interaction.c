@@ -712,8 +712,8 @@ get_mouse_action_node(html_content *html,
 			}
 		}
 
-		if (box->iframe) {
-			man->iframe = box->iframe;
+		if ((box->extra != NULL) && (box->extra->iframe != NULL)) {
+			man->iframe = box->extra->iframe;
 		}
 
 		if (box->href) {
@@ -723,9 +723,9 @@ get_mouse_action_node(html_content *html,
 			man->link.is_imagemap = false;
 		}
 
-		if (box->usemap) {
+		if ((box->extra != NULL) && (box->extra->usemap != NULL)) {
 			man->link.url = imagemap_get(html,
-						     box->usemap,
+						     box->extra->usemap,
 						     box_x,
 						     box_y,
 						     x, y,
@@ -744,8 +744,8 @@ get_mouse_action_node(html_content *html,
 			}
 		}
 
-		if (box->title) {
-			man->title = box->title;
+		if ((box->extra != NULL) && (box->extra->title != NULL)) {
+			man->title = box->extra->title;
 		}
 
 		man->result.pointer = get_pointer_shape(box, false);
@@ -44,7 +44,6 @@
 #include <dom/dom.h>
 
 #include "utils/log.h"
-#include "utils/talloc.h"
 #include "utils/utils.h"
 #include "utils/nsoption.h"
 #include "utils/nsurl.h"
@@ -63,6 +62,7 @@
 #include "html/private.h"
 #include "html/box.h"
 #include "html/box_inspect.h"
+#include "html/box_arena.h"
 #include "html/font.h"
 #include "html/form_internal.h"
 #include "html/layout.h"
@@ -355,7 +355,8 @@ static void layout_minmax_table(struct box *table,
 	if (table->max_width != UNKNOWN_MAX_WIDTH)
 		return;
 
-	if (table_calculate_column_types(&content->len_ctx, table) == false) {
+	if (table_calculate_column_types(&content->len_ctx,
+			content->box_arena, table) == false) {
 		NSLOG(netsurf, WARNING,
 				"Could not establish table column types.");
 		return;
@@ -650,7 +651,8 @@ layout_minmax_line(struct box *first,
 
 			if (b->next) {
 				if (b->space == UNKNOWN_WIDTH) {
-					font_func->width(&fstyle, " ", 1,
+					html_font_width(font_func,
+							&fstyle, " ", 1,
 							 &b->space);
 				}
 				max += b->space;
@@ -687,7 +689,8 @@ layout_minmax_line(struct box *first,
 							data.select.items; o;
 							o = o->next) {
 						int opt_width;
-						font_func->width(&fstyle,
+						html_font_width(font_func,
+								&fstyle,
 								o->text,
 								strlen(o->text),
 								&opt_width);
@@ -701,7 +704,8 @@ layout_minmax_line(struct box *first,
 						b->width += SCROLLBAR_WIDTH;
 
 				} else {
-					font_func->width(&fstyle, b->text,
+					html_font_width(font_func,
+							&fstyle, b->text,
 						b->length, &b->width);
 					b->flags |= MEASURED;
 				}
@@ -709,7 +713,8 @@ layout_minmax_line(struct box *first,
 			max += b->width;
 			if (b->next) {
 				if (b->space == UNKNOWN_WIDTH) {
-					font_func->width(&fstyle, " ", 1,
+					html_font_width(font_func,
+							&fstyle, " ", 1,
 							 &b->space);
 				}
 				max += b->space;
@@ -736,7 +741,8 @@ layout_minmax_line(struct box *first,
 					for (j = i; j != b->length &&
 							b->text[j] != ' '; j++)
 						;
-					font_func->width(&fstyle, b->text + i,
+					html_font_width(font_func,
+							&fstyle, b->text + i,
 							 j - i, &width);
 					if (min < width)
 						min = width;
@@ -2775,7 +2781,7 @@ layout_text_box_split(html_content *content,
 		/* We're need to add a space, and we don't know how big
 		 * it's to be, OR we have a space of unknown width anyway;
 		 * Calculate space width */
-		font_func->width(fstyle, " ", 1, &space_width);
+		html_font_width(font_func, fstyle, " ", 1, &space_width);
 	}
 
 	if (split_box->space == UNKNOWN_WIDTH)
@@ -2784,9 +2790,10 @@ layout_text_box_split(html_content *content,
 		space_width = 0;
 
 	/* Create clone of split_box, c2 */
-	c2 = talloc_memdup(content->bctx, split_box, sizeof *c2);
+	c2 = box_arena_alloc_box(content->box_arena);
 	if (!c2)
 		return false;
+	memcpy(c2, split_box, sizeof *c2);
 	c2->flags |= CLONE;
 
 	/* Set remaining text in c2 */
@@ -3248,7 +3255,8 @@ layout_line(struct box *first,
 		} else if (b->type == BOX_INLINE_END) {
 			b->width = 0;
 			if (b->space == UNKNOWN_WIDTH) {
-				font_func->width(&fstyle, " ", 1, &b->space);
+				html_font_width(font_func,
+						&fstyle, " ", 1, &b->space);
 				/** \todo handle errors */
 			}
 			space_after = b->space;
@@ -3288,7 +3296,8 @@ layout_line(struct box *first,
 							data.select.items; o;
 							o = o->next) {
 						int opt_width;
-						font_func->width(&fstyle,
+						html_font_width(font_func,
+								&fstyle,
 								o->text,
 								strlen(o->text),
 								&opt_width);
@@ -3300,7 +3309,8 @@ layout_line(struct box *first,
 					if (nsoption_bool(core_select_menu))
 						b->width += SCROLLBAR_WIDTH;
 				} else {
-					font_func->width(&fstyle, b->text,
+					html_font_width(font_func,
+							&fstyle, b->text,
 							b->length, &b->width);
 					b->flags |= MEASURED;
 				}
@@ -3313,14 +3323,15 @@ layout_line(struct box *first,
 			if (b->text && (x + b->width < x1 - x0) &&
 					!(b->flags & MEASURED) &&
 					b->next) {
-				font_func->width(&fstyle, b->text,
+				html_font_width(font_func, &fstyle, b->text,
 						 b->length, &b->width);
 				b->flags |= MEASURED;
 			}
 
 			x += b->width;
 			if (b->space == UNKNOWN_WIDTH) {
-				font_func->width(&fstyle, " ", 1, &b->space);
+				html_font_width(font_func,
+						&fstyle, " ", 1, &b->space);
 				/** \todo handle errors */
 			}
 			space_after = b->space;
@@ -3456,7 +3467,8 @@ layout_line(struct box *first,
 							&content->len_ctx,
 							b->style, &fstyle);
 					/** \todo handle errors */
-					font_func->width(&fstyle, " ", 1,
+					html_font_width(font_func,
+							&fstyle, " ", 1,
 							 &b->space);
 				}
 				space_after = b->space;
@@ -4251,7 +4263,9 @@ layout_block_context(struct box *block,
 		}
 
 		/* Advance to next box. */
-		if (box->type == BOX_BLOCK && !box->object && !(box->iframe) &&
+		if (box->type == BOX_BLOCK && !box->object &&
+				(box->extra == NULL ||
+				 box->extra->iframe == NULL) &&
 				box->children) {
 			/* Down into children. */
 
@@ -4439,7 +4453,7 @@ layout_lists(struct box *box,
 				if (marker->width == UNKNOWN_WIDTH) {
 					font_plot_style_from_css(len_ctx,
 							marker->style, &fstyle);
-					font_func->width(&fstyle,
+					html_font_width(font_func, &fstyle,
 							marker->text,
 							marker->length,
 							&marker->width);
@@ -5322,14 +5336,14 @@ static void layout_calculate_descendant_bboxes(
 			box->descendant_y1 = content_get_height(box->object);
 	}
 
-	if (box->iframe != NULL) {
+	if ((box->extra != NULL) && (box->extra->iframe != NULL)) {
 		int x, y;
 		box_coords(box, &x, &y);
 
-		browser_window_set_position(box->iframe, x, y);
-		browser_window_set_dimensions(box->iframe,
+		browser_window_set_position(box->extra->iframe, x, y);
+		browser_window_set_dimensions(box->extra->iframe,
 				box->width, box->height);
-		browser_window_reformat(box->iframe, true,
+		browser_window_reformat(box->extra->iframe, true,
 				box->width, box->height);
 	}
 
@@ -28,7 +28,9 @@
 #include <strings.h>
 #include <stdlib.h>
 #include <nsutils/time.h>
+#include <dom/dom.h>
 
+#include "utils/utils.h"
 #include "utils/corestrings.h"
 #include "utils/config.h"
 #include "utils/log.h"
@@ -163,6 +165,7 @@ html_object_callback(hlcache_handle *object,
 	html_content *c = (html_content *) o->parent;
 	int x, y;
 	struct box *box;
+	bool shown = false;
 
 	box = o->box;
 
@@ -171,7 +174,8 @@ html_object_callback(hlcache_handle *object,
 		if (c->base.status != CONTENT_STATUS_LOADING && c->bw != NULL)
 			content_open(object,
 					c->bw, &c->base,
-					box->object_params);
+					(box->extra != NULL) ?
+					box->extra->object_params : NULL);
 		break;
 
 	case CONTENT_MSG_READY:
@@ -222,6 +226,11 @@ html_object_callback(hlcache_handle *object,
 		break;
 
 	case CONTENT_MSG_ERROR:
+		if (box->object == object) {
+			/* object was displayed while it was loading */
+			box->object = NULL;
+		}
+
 		hlcache_handle_release(object);
 
 		o->content = NULL;
@@ -234,6 +243,17 @@ html_object_callback(hlcache_handle *object,
 		break;
 
 	case CONTENT_MSG_REDRAW:
+		if ((!o->background) &&
+		    (box->object == NULL) &&
+		    (content_get_type(object) == CONTENT_IMAGE) &&
+		    (content_get_status(object) == CONTENT_STATUS_LOADING)) {
+			/* The image is redrawing as its data arrives so
+			 * display it before it is done.
+			 */
+			html_object_done(box, object, false);
+			shown = true;
+		}
+
 		if (c->base.status != CONTENT_STATUS_LOADING) {
 			union content_msg_data data = event->data;
 
@@ -480,15 +500,18 @@ html_object_callback(hlcache_handle *object,
 		content__reformat(&c->base, false, c->base.available_width,
 				c->base.available_height);
 		content_set_done(&c->base);
-	} else if (nsoption_bool(incremental_reflow) &&
-		   event->type == CONTENT_MSG_DONE &&
+	} else if ((nsoption_bool(incremental_reflow) ||
+		    c->base.status == CONTENT_STATUS_DONE) &&
+		   (event->type == CONTENT_MSG_DONE || shown) &&
 		   box != NULL &&
 		   !(box->flags & REPLACE_DIM) &&
 		   (c->base.status == CONTENT_STATUS_READY ||
 		    c->base.status == CONTENT_STATUS_DONE)) {
 		/* 1) the configuration option to reflow pages while
-		 *      objects are fetched is set
-		 * 2) an object is newly fetched & converted,
+		 *      objects are fetched is set, or the page is done
+		 *      and a deferred object has arrived
+		 * 2) an object is newly fetched & converted, or is
+		 *      displayed while loading,
 		 * 3) the box's dimensions need to change due to being replaced
 		 * 4) the object's parent HTML is ready for reformat,
 		 */
@@ -592,6 +615,169 @@ static void html_object_refresh(void *p)
 }
 
 
+/**
+ * Determine if fetching an object should be deferred.
+ *
+ * \param box The box that will contain the object or NULL.
+ * \param permitted_types The acceptable types of the object.
+ * \param background The object is a background image.
+ * \return true if the fetch should be deferred until the box is needed.
+ */
+static bool
+html_object_is_lazy(struct box *box,
+		    content_type permitted_types,
+		    bool background)
+{
+	dom_string *loading;
+	dom_exception exc;
+	bool lazy = false;
+
+	if (box == NULL || (permitted_types & ~CONTENT_IMAGE) != 0) {
+		/* only images which will be placed in a box are deferred */
+		return false;
+	}
+
+	if (nsoption_bool(lazy_images)) {
+		return true;
+	}
+
+	if (background || box->node == NULL) {
+		return false;
+	}
+
+	exc = dom_element_get_attribute(box->node,
+					corestring_dom_loading,
+					&loading);
+	if (exc == DOM_NO_ERR && loading != NULL) {
+		lazy = dom_string_caseless_lwc_isequal(loading,
+						       corestring_lwc_lazy);
+		dom_string_unref(loading);
+	}
+
+	return lazy;
+}
+
+
+/**
+ * Start the fetch of a deferred object.
+ *
+ * \param c The html content the object belongs to.
+ * \param object The deferred object.
+ */
+static void
+html_object_fetch_deferred(html_content *c,
+			   struct content_html_object *object)
+{
+	hlcache_child_context child;
+	nsurl *url = object->url;
+	nserror error;
+
+	object->url = NULL;
+	c->lazy_objects--;
+
+	child.charset = c->encoding;
+	child.quirks = c->base.quirks;
+
+	error = hlcache_handle_retrieve(url,
+					HLCACHE_RETRIEVE_SNIFF_TYPE,
+					content_get_url(&c->base),
+					NULL,
+					html_object_callback,
+					object,
+					&child,
+					object->permitted_types,
+					&object->content);
+	nsurl_unref(url);
+	if (error != NSERROR_OK) {
+		return;
+	}
+
+	c->base.active++;
+	NSLOG(netsurf, INFO, "%d fetches active", c->base.active);
+}
+
+
+/**
+ * Scheduled callback to fetch deferred objects near the redrawn area.
+ *
+ * \param p The html content.
+ */
+static void html_object_lazy_fetch(void *p)
+{
+	html_content *c = p;
+	struct content_html_object *object;
+	struct rect area = c->lazy_area;
+	int margin = nsoption_int(lazy_image_margin);
+	struct box *box;
+	int x, y;
+
+	c->lazy_area.x0 = c->lazy_area.x1 = 0;
+	c->lazy_area.y0 = c->lazy_area.y1 = 0;
+
+	if (c->aborted || c->layout == NULL) {
+		return;
+	}
+
+	area.x0 -= margin;
+	area.y0 -= margin;
+	area.x1 += margin;
+	area.y1 += margin;
+
+	for (object = c->object_list;
+	     object != NULL && c->lazy_objects > 0;
+	     object = object->next) {
+		if (object->url == NULL) {
+			continue;
+		}
+
+		box = object->box;
+		box_coords(box, &x, &y);
+
+		if ((x + box->padding[LEFT] + box->width +
+		     box->padding[RIGHT] < area.x0) ||
+		    (x > area.x1) ||
+		    (y + box->padding[TOP] + box->height +
+		     box->padding[BOTTOM] < area.y0) ||
+		    (y > area.y1)) {
+			/* not near the redrawn area */
+			continue;
+		}
+
+		html_object_fetch_deferred(c, object);
+	}
+}
+
+
+/* exported interface documented in html/object.h */
+void html_object_lazy_redraw(html_content *html,
+		const struct content_redraw_data *data,
+		const struct rect *clip)
+{
+	struct rect area;
+
+	if (html->lazy_objects == 0) {
+		return;
+	}
+
+	/* redrawn area in document co-ordinates */
+	area.x0 = (clip->x0 - data->x) / data->scale;
+	area.y0 = (clip->y0 - data->y) / data->scale;
+	area.x1 = (clip->x1 - data->x) / data->scale + 1;
+	area.y1 = (clip->y1 - data->y) / data->scale + 1;
+
+	if (html->lazy_area.x0 < html->lazy_area.x1) {
+		/* extend area waiting to be considered */
+		area.x0 = min(area.x0, html->lazy_area.x0);
+		area.y0 = min(area.y0, html->lazy_area.y0);
+		area.x1 = max(area.x1, html->lazy_area.x1);
+		area.y1 = max(area.y1, html->lazy_area.y1);
+	}
+	html->lazy_area = area;
+
+	guit->misc->schedule(0, html_object_lazy_fetch, html);
+}
+
+
 /* exported interface documented in html/object.h */
 nserror html_object_open_objects(html_content *html, struct browser_window *bw)
 {
@@ -609,7 +795,8 @@ nserror html_object_open_objects(html_content *html, struct browser_window *bw)
 		content_open(object->content,
 			     bw,
 			     &html->base,
-			     object->box->object_params);
+			     (object->box->extra != NULL) ?
+			     object->box->extra->object_params : NULL);
 	}
 	return NSERROR_OK;
 }
@@ -641,6 +828,11 @@ nserror html_object_abort_objects(html_content *htmlc)
 
 		default:
 			hlcache_handle_abort(object->content);
+			if ((object->box != NULL) &&
+			    (object->box->object == object->content)) {
+				/* displayed while loading */
+				object->box->object = NULL;
+			}
 			hlcache_handle_release(object->content);
 			object->content = NULL;
 			if (object->box != NULL) {
@@ -684,9 +876,15 @@ nserror html_object_close_objects(html_content *html)
 /* exported interface documented in html/object.h */
 nserror html_object_free_objects(html_content *html)
 {
+	guit->misc->schedule(-1, html_object_lazy_fetch, html);
+
 	while (html->object_list != NULL) {
 		struct content_html_object *victim = html->object_list;
 
+		if (victim->url != NULL) {
+			nsurl_unref(victim->url);
+		}
+
 		if (victim->content != NULL) {
 			NSLOG(netsurf, INFO, "object %p", victim->content);
 
@@ -741,6 +939,19 @@ html_fetch_object(html_content *c,
 	object->permitted_types = permitted_types;
 	object->background = background;
 
+	if (html_object_is_lazy(box, permitted_types, background)) {
+		/* defer the fetch until the box is near the visible area */
+		object->url = nsurl_ref(url);
+
+		object->next = c->object_list;
+		c->object_list = object;
+
+		c->num_objects++;
+		c->lazy_objects++;
+
+		return true;
+	}
+
 	error = hlcache_handle_retrieve(url,
 					HLCACHE_RETRIEVE_SNIFF_TYPE,
 					content_get_url(&c->base),
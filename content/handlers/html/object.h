@@ -28,6 +28,8 @@ struct html_content;
 struct browser_window;
 struct box;
 struct nsurl;
+struct rect;
+struct content_redraw_data;
 
 /**
  * Start a fetch for an object required by a page.
@@ -36,6 +38,10 @@ struct nsurl;
  *  updated as the fetch progresses. The box (if any) is updated when
  *  the object content becomes done.
  *
+ * Images with loading="lazy", or any image when the lazy_images
+ *  option is set, are not fetched until their box is redrawn or comes
+ *  within lazy_image_margin of a redrawn area.
+ *
  * \param c content of type CONTENT_HTML
  * \param url URL of object to fetch
  * \param box box that will contain the object or NULL if none
@@ -83,4 +89,18 @@ nserror html_object_open_objects(struct html_content *html, struct browser_windo
  */
 nserror html_object_abort_objects(struct html_content *html);
 
+/**
+ * Note an area of a HTML content has been redrawn.
+ *
+ * Fetches of deferred objects near the area are started from the
+ * scheduler shortly afterwards.
+ *
+ * \param html The html content that was redrawn.
+ * \param data The redraw data the content was redrawn with.
+ * \param clip The redrawn area in output co-ordinates.
+ */
+void html_object_lazy_redraw(struct html_content *html,
+		const struct content_redraw_data *data,
+		const struct rect *clip);
+
 #endif
@@ -35,6 +35,7 @@ struct gui_layout_table;
 struct scrollbar_msg_data;
 struct content_redraw_data;
 struct selection;
+struct nscss_select_stats;
 
 typedef enum {
 	HTML_DRAG_NONE,			/** No drag */
@@ -135,6 +136,8 @@ typedef struct html_content {
 
 	/** A talloc context purely for the render box tree */
 	int *bctx;
+	/** Arena holding the boxes and box text of the render box tree */
+	struct box_arena *box_arena;
 	/** A context pointer for the box conversion, NULL if no conversion
 	 * is in progress.
 	 */
@@ -160,15 +163,30 @@ typedef struct html_content {
 	struct html_stylesheet *stylesheets;
 	/**< Style selection context */
 	css_select_ctx *select_ctx;
+	/**< Style selection statistics */
+	struct nscss_select_stats *select_stats;
 	/**< Style selection media specification */
 	css_media media;
 	/**< Universal selector */
 	lwc_string *universal;
 
+	/** Number of entries in restyles. */
+	unsigned int restyle_count;
+	/** Number of entries allocated in restyles. */
+	unsigned int restyle_size;
+	/** Elements waiting to be restyled. */
+	struct html_restyle *restyles;
+	/** Hash of restyles by element, twice restyle_size entries. */
+	unsigned int *restyle_index;
+
 	/** Number of entries in object_list. */
 	unsigned int num_objects;
 	/** List of objects. */
 	struct content_html_object *object_list;
+	/** Number of objects whose fetch is deferred until needed. */
+	unsigned int lazy_objects;
+	/** Document area redrawn since deferred objects were considered. */
+	struct rect lazy_area;
 	/** Forms, in reverse order to document. */
 	struct form *forms;
 	/** Hash table of imagemaps. */
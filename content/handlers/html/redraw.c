@@ -63,6 +63,7 @@
 #include "html/form_internal.h"
 #include "html/private.h"
 #include "html/layout.h"
+#include "html/object.h"
 
 
 bool html_redraw_debug = false;
@@ -1824,9 +1825,9 @@ bool html_redraw_box(const html_content *html, struct box *box,
 				      width, height, current_background_color,
 				      BITMAPF_NONE) != NSERROR_OK)
 			return false;
-	} else if (box->iframe) {
+	} else if ((box->extra != NULL) && (box->extra->iframe != NULL)) {
 		/* Offset is passed to browser window redraw unscaled */
-		browser_window_redraw(box->iframe,
+		browser_window_redraw(box->extra->iframe,
 				x + padding_left,
 				y + padding_top, &r, ctx);
 
@@ -1996,6 +1997,8 @@ bool html_redraw(struct content *c, struct content_redraw_data *data,
 				data->scale, clip, ctx);
 	}
 
+	html_object_lazy_redraw(html, data, clip);
+
 	return result;
 
 }
@@ -26,10 +26,10 @@
 #include <dom/dom.h>
 
 #include "utils/log.h"
-#include "utils/talloc.h"
 #include "css/utils.h"
 
 #include "html/box.h"
+#include "html/box_arena.h"
 #include "html/table.h"
 
 /* Define to enable verbose table debug */
@@ -797,7 +797,9 @@ table_used_bottom_border_for_cell(const nscss_len_ctx *len_ctx,
 
 /* exported interface documented in html/table.h */
 bool
-table_calculate_column_types(const nscss_len_ctx *len_ctx, struct box *table)
+table_calculate_column_types(const nscss_len_ctx *len_ctx,
+			     struct box_arena *arena,
+			     struct box *table)
 {
 	unsigned int i, j;
 	struct column *col;
@@ -807,7 +809,8 @@ table_calculate_column_types(const nscss_len_ctx *len_ctx, struct box *table)
 		/* table->col already constructed, for example frameset table */
 		return true;
 
-	table->col = col = talloc_array(table, struct column, table->columns);
+	table->col = col = box_arena_alloc(arena,
+			sizeof(struct column) * table->columns);
 	if (!col)
 		return false;
 
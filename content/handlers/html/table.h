@@ -28,19 +28,22 @@
 #include <stdbool.h>
 
 struct box;
+struct box_arena;
 
 
 /**
  * Determine the column width types for a table.
  *
  * \param len_ctx Length conversion context
+ * \param arena box tree arena to allocate the column array from
  * \param table box of type BOX_TABLE
  * \return true on success, false on memory exhaustion
  *
  * The table->col array is allocated and type and width are filled in for each
  * column.
  */
-bool table_calculate_column_types(const nscss_len_ctx *len_ctx,	struct box *table);
+bool table_calculate_column_types(const nscss_len_ctx *len_ctx,
+		struct box_arena *arena, struct box *table);
 
 
 /**
@@ -49,6 +49,7 @@
 #include "desktop/gui_internal.h"
 
 #include "image/image.h"
+#include "image/image_cache.h"
 #include "image/gif.h"
 
 typedef struct nsgif_content {
@@ -56,6 +57,14 @@ typedef struct nsgif_content {
 
 	struct gif_animation *gif; /**< GIF animation data */
 	int current_frame;   /**< current frame to display [0...(max-1)] */
+
+	struct bitmap **frames; /**< composited frames or NULL if not kept */
+	size_t frames_size; /**< image cache space reserved for frames */
+
+	bool redraw_requested; /**< redraw of current frame was requested */
+	bool redrawn; /**< content was redrawn since the frame advanced */
+	bool full_redraw_requested; /**< redraw of whole image was requested */
+	bool paused; /**< animation stopped as nothing displays it */
 } nsgif_content;
 
 
@@ -125,6 +134,25 @@ static nserror nsgif_create(const content_handler *handler,
 	return NSERROR_OK;
 }
 
+/**
+ * Get the time a frame of an animation is displayed for.
+ *
+ * \param gif The gif content.
+ * \param frame The frame.
+ * \return The frame delay in ms.
+ */
+static int nsgif_frame_delay(nsgif_content *gif, int frame)
+{
+	int delay = gif->gif->frames[frame].frame_delay;
+
+	if (delay <= 1) {
+		/* Assuming too fast to be intended, set default. */
+		delay = 10;
+	}
+
+	return delay * 10;
+}
+
 /**
  * Performs any necessary animation.
  *
@@ -134,9 +162,39 @@ static void nsgif_animate(void *p)
 {
 	nsgif_content *gif = p;
 	union content_msg_data data;
-	int delay;
 	int f;
 
+	if (gif->redraw_requested && !gif->redrawn) {
+		if (gif->full_redraw_requested) {
+			/* Not even the whole image was drawn so nothing
+			 * is displaying the animation. Stop until it is
+			 * redrawn.
+			 */
+			gif->paused = true;
+			return;
+		}
+
+		/* Only the area the previous frame changed is known to
+		 * be hidden; ask for the whole image to be drawn and
+		 * check again before stopping.
+		 */
+		data.redraw.x = 0;
+		data.redraw.y = 0;
+		data.redraw.width = gif->base.width;
+		data.redraw.height = gif->base.height;
+
+		gif->full_redraw_requested = true;
+
+		guit->misc->schedule(nsgif_frame_delay(gif, gif->current_frame),
+				     nsgif_animate,
+				     gif);
+
+		content_broadcast(&gif->base, CONTENT_MSG_REDRAW, &data);
+		return;
+	}
+	gif->redraw_requested = false;
+	gif->full_redraw_requested = false;
+
 	/* Advance by a frame, updating the loop count accordingly */
 	gif->current_frame++;
 	if (gif->current_frame == (int)gif->gif->frame_count_partial) {
@@ -155,12 +213,9 @@ static void nsgif_animate(void *p)
 
 	/* Continue animating if we should */
 	if (gif->gif->loop_count >= 0) {
-		delay = gif->gif->frames[gif->current_frame].frame_delay;
-		if (delay <= 1) {
-			/* Assuming too fast to be intended, set default. */
-			delay = 10;
-		}
-		guit->misc->schedule(delay * 10, nsgif_animate, gif);
+		guit->misc->schedule(nsgif_frame_delay(gif, gif->current_frame),
+				     nsgif_animate,
+				     gif);
 	}
 
 	if ((!nsoption_bool(animate_images)) ||
@@ -211,6 +266,9 @@ static void nsgif_animate(void *p)
 		}
 	}
 
+	gif->redraw_requested = true;
+	gif->redrawn = false;
+
 	content_broadcast(&gif->base, CONTENT_MSG_REDRAW, &data);
 }
 
@@ -267,6 +325,24 @@ static bool nsgif_convert(struct content *c)
 		free(title);
 	}
 
+	/* Small animations keep every composited frame so once each has
+	 * been decoded further loops only plot existing bitmaps.
+	 */
+	if (gif->gif->frame_count_partial > 1) {
+		size_t frames_size = (size_t)c->width * c->height * 4 *
+			gif->gif->frame_count_partial;
+
+		if (image_cache_reserve(frames_size)) {
+			gif->frames = calloc(gif->gif->frame_count_partial,
+					     sizeof(struct bitmap *));
+			if (gif->frames != NULL) {
+				gif->frames_size = frames_size;
+			} else {
+				image_cache_unreserve(frames_size);
+			}
+		}
+	}
+
 	/* Schedule the animation if we have one */
 	gif->current_frame = 0;
 	if (gif->gif->frame_count_partial > 1)
@@ -284,6 +360,54 @@ static bool nsgif_convert(struct content *c)
 }
 
 
+/**
+ * Keep a copy of the frame just decoded in the frame cache.
+ *
+ * \param gif The gif context.
+ * \param frame The frame which has been decoded.
+ */
+static void nsgif_cache_frame(nsgif_content *gif, int frame)
+{
+	struct bitmap *bitmap;
+	uint8_t *src;
+	uint8_t *dst;
+	size_t src_stride;
+	size_t dst_stride;
+	unsigned int row;
+
+	if ((gif->frames == NULL) || (gif->frames[frame] != NULL)) {
+		return;
+	}
+
+	bitmap = guit->bitmap->create(gif->gif->width,
+				      gif->gif->height,
+				      BITMAP_NEW);
+	if (bitmap == NULL) {
+		return;
+	}
+
+	src = guit->bitmap->get_buffer(gif->gif->frame_image);
+	dst = guit->bitmap->get_buffer(bitmap);
+	if ((src == NULL) || (dst == NULL)) {
+		guit->bitmap->destroy(bitmap);
+		return;
+	}
+
+	src_stride = guit->bitmap->get_rowstride(gif->gif->frame_image);
+	dst_stride = guit->bitmap->get_rowstride(bitmap);
+	for (row = 0; row < gif->gif->height; row++) {
+		memcpy(dst + (row * dst_stride),
+		       src + (row * src_stride),
+		       gif->gif->width * 4);
+	}
+
+	guit->bitmap->set_opaque(bitmap,
+			guit->bitmap->get_opaque(gif->gif->frame_image));
+	guit->bitmap->modified(bitmap);
+
+	gif->frames[frame] = bitmap;
+}
+
 /**
  * Updates the GIF bitmap to display the current frame
  *
@@ -308,23 +432,64 @@ static gif_result nsgif_get_frame(nsgif_content *gif)
 
 	for (frame = previous_frame; frame <= current_frame; frame++) {
 		res = gif_decode_frame(gif->gif, frame);
+		if (res == GIF_OK) {
+			nsgif_cache_frame(gif, frame);
+		}
 	}
 
 	return res;
 }
 
-static bool nsgif_redraw(struct content *c, struct content_redraw_data *data,
-		const struct rect *clip, const struct redraw_context *ctx)
+/**
+ * Get the bitmap of the frame to display.
+ *
+ * \param gif The gif context.
+ * \return The bitmap or NULL on error.
+ */
+static struct bitmap *nsgif_frame_bitmap(nsgif_content *gif)
 {
-	nsgif_content *gif = (nsgif_content *) c;
+	int frame = gif->current_frame;
+
+	if (!nsoption_bool(animate_images)) {
+		frame = 0;
+	}
+
+	if ((gif->frames != NULL) && (gif->frames[frame] != NULL)) {
+		return gif->frames[frame];
+	}
 
 	if (gif->current_frame != gif->gif->decoded_frame) {
 		if (nsgif_get_frame(gif) != GIF_OK) {
-			return false;
+			return NULL;
 		}
 	}
 
-	return image_bitmap_plot(gif->gif->frame_image, data, clip, ctx);
+	return gif->gif->frame_image;
+}
+
+static bool nsgif_redraw(struct content *c, struct content_redraw_data *data,
+		const struct rect *clip, const struct redraw_context *ctx)
+{
+	nsgif_content *gif = (nsgif_content *) c;
+	struct bitmap *bitmap;
+
+	gif->redrawn = true;
+	if (gif->paused) {
+		/* displayed again so continue the animation */
+		gif->paused = false;
+		gif->redraw_requested = false;
+		gif->full_redraw_requested = false;
+		guit->misc->schedule(nsgif_frame_delay(gif, gif->current_frame),
+				     nsgif_animate,
+				     gif);
+	}
+
+	bitmap = nsgif_frame_bitmap(gif);
+	if (bitmap == NULL) {
+		return false;
+	}
+
+	return image_bitmap_plot(bitmap, data, clip, ctx);
 }
 
 
@@ -334,6 +499,19 @@ static void nsgif_destroy(struct content *c)
 
 	/* Free all the associated memory buffers */
 	guit->misc->schedule(-1, nsgif_animate, c);
+
+	if (gif->frames != NULL) {
+		unsigned int frame;
+
+		for (frame = 0; frame < gif->gif->frame_count_partial; frame++) {
+			if (gif->frames[frame] != NULL) {
+				guit->bitmap->destroy(gif->frames[frame]);
+			}
+		}
+		free(gif->frames);
+		image_cache_unreserve(gif->frames_size);
+	}
+
 	gif_finalise(gif->gif);
 	free(gif->gif);
 }
@@ -384,6 +562,9 @@ static void nsgif_add_user(struct content *c)
 
 	if (content_count_users(c) == 1) {
 		/* First user, and content already converted, so start the animation. */
+		gif->paused = false;
+		gif->redraw_requested = false;
+		gif->full_redraw_requested = false;
 		if (gif->gif->frame_count_partial > 1) {
 			guit->misc->schedule(gif->gif->frames[0].frame_delay * 10,
 				nsgif_animate, c);
@@ -403,12 +584,7 @@ static void *nsgif_get_internal(const struct content *c, void *context)
 {
 	nsgif_content *gif = (nsgif_content *) c;
 
-	if (gif->current_frame != gif->gif->decoded_frame) {
-		if (nsgif_get_frame(gif) != GIF_OK)
-			return NULL;
-	}
-
-	return gif->gif->frame_image;
+	return nsgif_frame_bitmap(gif);
 }
 
 static content_type nsgif_content_type(void)
@@ -419,14 +595,14 @@ static content_type nsgif_content_type(void)
 static bool nsgif_content_is_opaque(struct content *c)
 {
 	nsgif_content *gif = (nsgif_content *) c;
+	struct bitmap *bitmap;
 
-	if (gif->current_frame != gif->gif->decoded_frame) {
-		if (nsgif_get_frame(gif) != GIF_OK) {
-			return false;
-		}
+	bitmap = nsgif_frame_bitmap(gif);
+	if (bitmap == NULL) {
+		return false;
 	}
 
-	return guit->bitmap->get_opaque(gif->gif->frame_image);
+	return guit->bitmap->get_opaque(bitmap);
 }
 
 static const content_handler nsgif_content_handler = {
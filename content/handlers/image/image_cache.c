@@ -26,13 +26,17 @@
 #include <stdbool.h>
 #include <string.h>
 #include <stdlib.h>
+#include <nsutils/time.h>
 
 #include "netsurf/inttypes.h"
 #include "utils/utils.h"
 #include "utils/log.h"
+#include "utils/pixels.h"
 #include "netsurf/misc.h"
 #include "netsurf/bitmap.h"
+#include "netsurf/plotters.h"
 #include "content/llcache.h"
+#include "content/content.h"
 #include "content/content_protected.h"
 #include "desktop/gui_internal.h"
 
@@ -47,12 +51,22 @@
  */
 typedef unsigned int cache_age;
 
+/**
+ * Number of buckets in the content to entry hash table, must be a
+ * power of two.
+ */
+#define IMAGE_CACHE_HASH_SIZE 256
+
+/** Time in ms each band of a banded conversion is given */
+#define IMAGE_CACHE_BAND_TIME 10
+
 /**
  * Image cache entry
  */
 struct image_cache_entry_s {
 	struct image_cache_entry_s *next; /**< next cache entry in list */
 	struct image_cache_entry_s *prev; /**< previous cache entry in list */
+	struct image_cache_entry_s *hash_next; /**< next entry in hash chain */
 
 	/** content is used as a key */
 	struct content *content;
@@ -60,6 +74,10 @@ struct image_cache_entry_s {
 	struct bitmap *bitmap;
 	/** routine to convert content into bitmap */
 	image_cache_convert_fn *convert;
+	/** routine to convert content into bitmap in bands or NULL */
+	image_cache_band_fn *band;
+	/** content can be converted at any size */
+	bool vector;
 
 	/* Statistics for replacement algorithm */
 
@@ -69,6 +87,26 @@ struct image_cache_entry_s {
 	cache_age bitmap_age; /**< Age of last conversion to a bitmap by cache*/
 
 	int conversion_count; /**< Number of times image has been converted */
+	unsigned int conversion_time; /**< ms taken by the last conversion */
+	unsigned int band_time; /**< ms taken by bands converted so far */
+
+	/** Conversion is waiting to be performed by the decode callback */
+	bool decode_pending;
+	/** Redraw was skipped waiting for the pending conversion */
+	bool redraw_pending;
+
+	/** Largest width the content has been plotted at (0 if unknown) */
+	int display_width;
+	/** Largest height the content has been plotted at (0 if unknown) */
+	int display_height;
+
+	/** Bitmap resampled to the size it was last plotted at */
+	struct bitmap *scaled;
+	/** Scaling is waiting to be performed by the scale callback */
+	bool scale_pending;
+	int scaled_width; /**< Width last plotted at */
+	int scaled_height; /**< Height last plotted at */
+	size_t scaled_size; /**< size of storage occupied by scaled bitmap */
 };
 
 /**
@@ -89,6 +127,15 @@ struct image_cache_s {
 	/* The objects the cache holds */
 	struct image_cache_entry_s *entries;
 
+	/** The cache entries hashed by content */
+	struct image_cache_entry_s *hash[IMAGE_CACHE_HASH_SIZE];
+
+	/** Number of entries waiting to be converted */
+	unsigned int decode_count;
+
+	/** Number of entries waiting to be scaled */
+	unsigned int scale_count;
+
 
 	/* Statistics for management algorithm */
 
@@ -134,6 +181,16 @@ struct image_cache_s {
 	int peak_conversions;
 	/** Size of bitmap with most conversions */
 	unsigned int peak_conversions_size;
+
+	/** Total time spent converting bitmaps in ms */
+	uint64_t conversion_time;
+	/** Number of bitmaps freed by the cleaner */
+	int eviction_count;
+
+	/** Number of scaled bitmaps created */
+	int scaled_count;
+	/** Number of plots made from a scaled bitmap */
+	int scaled_hit_count;
 };
 
 /** image cache state */
@@ -159,6 +216,23 @@ static struct image_cache_entry_s *image_cache__findn(int entryn)
 }
 
 
+/**
+ * Compute the hash table bucket for a content
+ *
+ * \param c The content to hash
+ * \return The index of the hash bucket the content is in.
+ */
+static inline unsigned int image_cache__hash(const struct content *c)
+{
+	uintptr_t key = (uintptr_t)c;
+
+	/* allocations are aligned so the low bits carry no information */
+	key = key >> 4;
+	key ^= key >> 8;
+
+	return key & (IMAGE_CACHE_HASH_SIZE - 1);
+}
+
 /**
  * Find the cache entry for a content
  *
@@ -169,9 +243,9 @@ static struct image_cache_entry_s *image_cache__find(const struct content *c)
 {
 	struct image_cache_entry_s *found;
 
-	found = image_cache->entries;
+	found = image_cache->hash[image_cache__hash(c)];
 	while ((found != NULL) && (found->content != c)) {
-		found = found->next;
+		found = found->hash_next;
 	}
 	return found;
 }
@@ -183,6 +257,10 @@ static struct image_cache_entry_s *image_cache__find(const struct content *c)
  */
 static void image_cache_stats_bitmap_add(struct image_cache_entry_s *centry)
 {
+	/* bitmaps may be converted smaller than the content */
+	centry->bitmap_size = guit->bitmap->get_width(centry->bitmap) *
+		guit->bitmap->get_height(centry->bitmap) * 4;
+
 	centry->bitmap_age = image_cache->current_age;
 	centry->conversion_count++;
 
@@ -218,6 +296,11 @@ static void image_cache_stats_bitmap_add(struct image_cache_entry_s *centry)
 
 static void image_cache__link(struct image_cache_entry_s *centry)
 {
+	unsigned int bucket = image_cache__hash(centry->content);
+
+	centry->hash_next = image_cache->hash[bucket];
+	image_cache->hash[bucket] = centry;
+
 	centry->next = image_cache->entries;
 	centry->prev = NULL;
 	if (centry->next != NULL) {
@@ -228,6 +311,15 @@ static void image_cache__link(struct image_cache_entry_s *centry)
 
 static void image_cache__unlink(struct image_cache_entry_s *centry)
 {
+	struct image_cache_entry_s **link;
+
+	/* remove from hash chain */
+	link = &image_cache->hash[image_cache__hash(centry->content)];
+	while (*link != centry) {
+		link = &(*link)->hash_next;
+	}
+	*link = centry->hash_next;
+
 	/* unlink entry */
 	if (centry->prev == NULL) {
 		/* first in list */
@@ -247,6 +339,21 @@ static void image_cache__unlink(struct image_cache_entry_s *centry)
 	}
 }
 
+/**
+ * free scaled bitmap from an image cache entry
+ *
+ * \param centry The image cache entry to free scaled bitmap from.
+ */
+static void image_cache__free_scaled(struct image_cache_entry_s *centry)
+{
+	if (centry->scaled != NULL) {
+		guit->bitmap->destroy(centry->scaled);
+		centry->scaled = NULL;
+		image_cache_unreserve(centry->scaled_size);
+		centry->scaled_size = 0;
+	}
+}
+
 /**
  * free bitmap from an image cache entry
  *
@@ -254,6 +361,9 @@ static void image_cache__unlink(struct image_cache_entry_s *centry)
  */
 static void image_cache__free_bitmap(struct image_cache_entry_s *centry)
 {
+	/* the scaled bitmap is derived from the bitmap */
+	image_cache__free_scaled(centry);
+
 	if (centry->bitmap != NULL) {
 #ifdef IMAGE_CACHE_VERBOSE
 		NSLOG(netsurf, INFO,
@@ -289,6 +399,14 @@ static void image_cache__free_entry(struct image_cache_entry_s *centry)
 		image_cache->total_unrendered++;
 	}
 
+	if (centry->decode_pending) {
+		image_cache->decode_count--;
+	}
+
+	if (centry->scale_pending) {
+		image_cache->scale_count--;
+	}
+
 	image_cache__free_bitmap(centry);
 
 	image_cache__unlink(centry);
@@ -296,26 +414,79 @@ static void image_cache__free_entry(struct image_cache_entry_s *centry)
 	free(centry);
 }
 
+/**
+ * Compute the value of keeping an image cache entry's bitmap.
+ *
+ * Bitmaps are worth more the more often they have been redrawn and
+ * the longer they take to convert again. They are worth less the
+ * longer it is since they were last redrawn and the more memory they
+ * occupy.
+ *
+ * \param icache The image cache context.
+ * \param centry The image cache entry.
+ * \return The retention score, entries with lower scores are freed first.
+ */
+static uint64_t
+image_cache__retention(const struct image_cache_s *icache,
+		       const struct image_cache_entry_s *centry)
+{
+	uint64_t idle = icache->current_age - centry->redraw_age + 1;
+	uint64_t cost = centry->conversion_time + 1;
+	uint64_t kbytes = (centry->bitmap_size >> 10) + 1;
+
+	return ((centry->redraw_count + 1) * cost * 1000000) / (idle * kbytes);
+}
+
 /**
  * Image cache cleaner
  *
+ * When the cache is over its limit, bitmaps which have not been
+ * redrawn recently are freed lowest retention score first until the
+ * cache is back under the limit less the hysteresis.
+ *
  * \param icache The image cache context.
  */
 static void image_cache__clean(struct image_cache_s *icache)
 {
-	struct image_cache_entry_s *centry = icache->entries;
+	struct image_cache_entry_s *centry;
+	struct image_cache_entry_s *victim;
+	uint64_t score;
+	uint64_t victim_score = 0;
+
+	while (icache->total_bitmap_size >
+	       (icache->params.limit - icache->params.hysteresis)) {
+		victim = NULL;
+
+		for (centry = icache->entries;
+		     centry != NULL;
+		     centry = centry->next) {
+			if ((centry->bitmap == NULL) ||
+			    (centry->convert == NULL)) {
+				/* nothing to free or cannot be recreated */
+				continue;
+			}
+
+			if ((icache->current_age - centry->redraw_age) <=
+			    icache->params.bg_clean_time) {
+				/* only consider older entries, avoids
+				 * active entries
+				 */
+				continue;
+			}
 
-	while (centry != NULL) {
-		if ((icache->current_age - centry->redraw_age) >
-		    icache->params.bg_clean_time) {
-			/* only consider older entries, avoids active entries */
-			if ((icache->total_bitmap_size >
-			     (icache->params.limit - icache->params.hysteresis)) &&
-			    (rand() > (RAND_MAX / 2))) {
-				image_cache__free_bitmap(centry);
+			score = image_cache__retention(icache, centry);
+			if ((victim == NULL) || (score < victim_score)) {
+				victim = centry;
+				victim_score = score;
 			}
 		}
-		centry=centry->next;
+
+		if (victim == NULL) {
+			break;
+		}
+
+		image_cache__free_bitmap(victim);
+		icache->eviction_count++;
 	}
 }
 
@@ -342,6 +513,454 @@ static void image_cache__background_update(void *p)
 				icache);
 }
 
+/**
+ * Get the size an image cache entry should be converted at.
+ *
+ * This is the smallest size, with the aspect ratio of the content, that
+ * covers the largest area the content has been plotted at. Contents
+ * which can be converted at any size are converted at the size they
+ * were last required at instead.
+ *
+ * \param centry The image cache entry.
+ * \param width Updated with the width to convert at.
+ * \param height Updated with the height to convert at.
+ */
+static void
+image_cache__target_size(const struct image_cache_entry_s *centry,
+			 int *width, int *height)
+{
+	const struct content *c = centry->content;
+	int64_t dw = centry->display_width;
+	int64_t dh = centry->display_height;
+
+	if ((dw <= 0) || (dh <= 0) || (c->width <= 0) || (c->height <= 0)) {
+		*width = c->width;
+		*height = c->height;
+	} else if (centry->vector) {
+		*width = dw;
+		*height = dh;
+	} else if (dw * c->height >= dh * c->width) {
+		*width = dw;
+		*height = (c->height * dw + c->width - 1) / c->width;
+	} else {
+		*width = (c->width * dh + c->height - 1) / c->height;
+		*height = dh;
+	}
+}
+
+/**
+ * Determine if an image cache entry's bitmap is smaller than required.
+ *
+ * \param centry The image cache entry.
+ * \return true if the entry has a bitmap too small for its display size.
+ */
+static bool image_cache__too_small(const struct image_cache_entry_s *centry)
+{
+	int target_width, target_height;
+
+	if (centry->bitmap == NULL) {
+		return false;
+	}
+
+	image_cache__target_size(centry, &target_width, &target_height);
+
+	return ((guit->bitmap->get_width(centry->bitmap) < target_width) ||
+		(guit->bitmap->get_height(centry->bitmap) < target_height));
+}
+
+/**
+ * Note the size an image cache entry is required at.
+ *
+ * \param centry The image cache entry.
+ * \param width The width required.
+ * \param height The height required.
+ * \return true if the entry has a bitmap too small for the required size.
+ */
+static bool
+image_cache__require(struct image_cache_entry_s *centry, int width, int height)
+{
+	const struct content *c = centry->content;
+
+	if (centry->vector) {
+		/* converted at the size required now; growing each
+		 * dimension separately could far exceed any one request.
+		 */
+		centry->display_width = width;
+		centry->display_height = height;
+
+		return image_cache__too_small(centry);
+	}
+
+	/* never convert larger than the content itself */
+	width = min(width, c->width);
+	height = min(height, c->height);
+
+	if (width > centry->display_width) {
+		centry->display_width = width;
+	}
+	if (height > centry->display_height) {
+		centry->display_height = height;
+	}
+
+	return image_cache__too_small(centry);
+}
+
+/**
+ * Update the image cache statistics after a conversion.
+ *
+ * \param centry The image cache entry which was converted.
+ * \param plot true if the bitmap is required to plot else false if the
+ *             conversion is speculative.
+ * \return true if the entry has a bitmap else false.
+ */
+static bool
+image_cache__converted(struct image_cache_entry_s *centry, bool plot)
+{
+	if (centry->bitmap == NULL) {
+		image_cache->fail_count++;
+		if (plot) {
+			image_cache->fail_size += centry->bitmap_size;
+		}
+		return false;
+	}
+
+	image_cache_stats_bitmap_add(centry);
+	if (plot) {
+		image_cache->miss_count++;
+		image_cache->miss_size += centry->bitmap_size;
+	}
+
+	return true;
+}
+
+/**
+ * Convert the content of an image cache entry into a bitmap.
+ *
+ * \param centry The image cache entry to convert.
+ * \param plot true if the bitmap is required to plot else false if the
+ *             conversion is speculative.
+ * \return true if the entry has a bitmap else false.
+ */
+static bool image_cache__convert(struct image_cache_entry_s *centry, bool plot)
+{
+	if (centry->decode_pending) {
+		centry->decode_pending = false;
+		image_cache->decode_count--;
+	}
+
+	/* any banded conversion in progress is abandoned */
+	centry->band_time = 0;
+
+	if (centry->convert != NULL) {
+		uint64_t ms_before;
+		uint64_t ms_after;
+
+		nsu_getmonotonic_ms(&ms_before);
+		centry->bitmap = centry->convert(centry->content);
+		nsu_getmonotonic_ms(&ms_after);
+
+		centry->conversion_time = ms_after - ms_before;
+		image_cache->conversion_time += centry->conversion_time;
+	}
+
+	return image_cache__converted(centry, plot);
+}
+
+/**
+ * Convert the next band of the content of an image cache entry.
+ *
+ * \param centry The image cache entry to convert.
+ * \param plot true if the bitmap is required to plot else false if the
+ *             conversion is speculative.
+ * \return true if conversion has finished, successfully or not, else
+ *         false if bands remain to be converted.
+ */
+static bool
+image_cache__convert_band(struct image_cache_entry_s *centry, bool plot)
+{
+	struct bitmap *bitmap = NULL;
+	uint64_t ms_before;
+	uint64_t ms_after;
+	nserror res;
+
+	nsu_getmonotonic_ms(&ms_before);
+	res = centry->band(centry->content, IMAGE_CACHE_BAND_TIME, &bitmap);
+	nsu_getmonotonic_ms(&ms_after);
+
+	centry->band_time += ms_after - ms_before;
+
+	if (res == NSERROR_NEED_DATA) {
+		return false;
+	}
+
+	centry->decode_pending = false;
+	image_cache->decode_count--;
+
+	if (res == NSERROR_OK) {
+		centry->bitmap = bitmap;
+	}
+
+	centry->conversion_time = centry->band_time;
+	image_cache->conversion_time += centry->band_time;
+	centry->band_time = 0;
+
+	image_cache__converted(centry, plot);
+
+	return true;
+}
+
+/**
+ * Cache decode scheduled callback.
+ *
+ * Converts one waiting entry per call so other work, including input
+ * handling and redraw, continues between conversions. Entries waiting
+ * to be drawn are converted before speculative conversions.
+ *
+ * \param p The image cache context.
+ */
+static void image_cache__decode(void *p)
+{
+	struct image_cache_s *icache = p;
+	struct image_cache_entry_s *centry;
+	struct image_cache_entry_s *found = NULL;
+	union content_msg_data data;
+
+	for (centry = icache->entries; centry != NULL; centry = centry->next) {
+		if (centry->decode_pending) {
+			found = centry;
+			if (centry->redraw_pending) {
+				break;
+			}
+		}
+	}
+
+	if (found != NULL) {
+		if (found->redraw_pending && image_cache__too_small(found)) {
+			/* bitmap must be converted again at a larger size */
+			image_cache__free_bitmap(found);
+		}
+
+		if (found->bitmap == NULL) {
+			if (found->band == NULL) {
+				image_cache__convert(found, found->redraw_pending);
+			} else if (!image_cache__convert_band(found,
+						found->redraw_pending)) {
+				/* continue with the next band, or another
+				 * entry, on the next callback.
+				 */
+				guit->misc->schedule(0, image_cache__decode,
+						     icache);
+				return;
+			}
+		} else {
+			/* bitmap was supplied or converted meanwhile */
+			found->decode_pending = false;
+			icache->decode_count--;
+		}
+
+		if (found->redraw_pending) {
+			found->redraw_pending = false;
+			if (found->bitmap != NULL) {
+				data.redraw.x = 0;
+				data.redraw.y = 0;
+				data.redraw.width = found->content->width;
+				data.redraw.height = found->content->height;
+				content_broadcast(found->content,
+						  CONTENT_MSG_REDRAW,
+						  &data);
+			}
+		}
+	}
+
+	if (icache->decode_count > 0) {
+		guit->misc->schedule(0, image_cache__decode, icache);
+	}
+}
+
+/**
+ * Queue an image cache entry for conversion by the decode callback.
+ *
+ * \param centry The image cache entry to convert.
+ * \param redraw true if the entry must be redrawn after conversion.
+ */
+static void
+image_cache__queue_decode(struct image_cache_entry_s *centry, bool redraw)
+{
+	if (redraw) {
+		centry->redraw_pending = true;
+	}
+
+	if (centry->decode_pending) {
+		return;
+	}
+
+	centry->decode_pending = true;
+	if (image_cache->decode_count++ == 0) {
+		guit->misc->schedule(0, image_cache__decode, image_cache);
+	}
+}
+
+/**
+ * Resample an image cache entry's bitmap to the size it was last plotted.
+ *
+ * Scaled bitmaps are accounted within the cache limit and are freed
+ * with the bitmap they were made from.
+ *
+ * \param centry The image cache entry, which must have a bitmap.
+ * \return true if the scaled bitmap was made else false.
+ */
+static bool image_cache__make_scaled(struct image_cache_entry_s *centry)
+{
+	struct bitmap *bitmap = centry->bitmap;
+	struct bitmap *scaled;
+	int width = centry->scaled_width;
+	int height = centry->scaled_height;
+	unsigned char *src;
+	unsigned char *dst;
+	size_t size;
+	bool opaque;
+	nserror res;
+
+	size = (size_t)width * height * 4;
+	if (image_cache_reserve(size) == false) {
+		return false;
+	}
+
+	opaque = guit->bitmap->get_opaque(bitmap);
+	scaled = guit->bitmap->create(width, height,
+			opaque ? BITMAP_OPAQUE : BITMAP_NEW);
+	if (scaled == NULL) {
+		image_cache_unreserve(size);
+		return false;
+	}
+
+	src = guit->bitmap->get_buffer(bitmap);
+	dst = guit->bitmap->get_buffer(scaled);
+	if ((src == NULL) || (dst == NULL)) {
+		res = NSERROR_NOMEM;
+	} else {
+		res = pixels_scale(src,
+				   guit->bitmap->get_width(bitmap),
+				   guit->bitmap->get_height(bitmap),
+				   guit->bitmap->get_rowstride(bitmap),
+				   dst, width, height,
+				   guit->bitmap->get_rowstride(scaled),
+				   opaque);
+		/* frontends may have converted the buffer for access */
+		guit->bitmap->modified(bitmap);
+	}
+	if (res != NSERROR_OK) {
+		guit->bitmap->destroy(scaled);
+		image_cache_unreserve(size);
+		return false;
+	}
+	guit->bitmap->modified(scaled);
+
+	centry->scaled = scaled;
+	centry->scaled_size = size;
+	image_cache->scaled_count++;
+
+	return true;
+}
+
+/**
+ * Cache scale scheduled callback.
+ *
+ * Scales one waiting entry per call and redraws its content so the
+ * scaled bitmap is plotted.
+ *
+ * \param p The image cache context.
+ */
+static void image_cache__scale(void *p)
+{
+	struct image_cache_s *icache = p;
+	struct image_cache_entry_s *centry;
+	union content_msg_data data;
+
+	for (centry = icache->entries; centry != NULL; centry = centry->next) {
+		if (centry->scale_pending) {
+			break;
+		}
+	}
+
+	if (centry != NULL) {
+		centry->scale_pending = false;
+		icache->scale_count--;
+
+		if ((centry->bitmap != NULL) &&
+		    (centry->scaled == NULL) &&
+		    image_cache__make_scaled(centry)) {
+			data.redraw.x = 0;
+			data.redraw.y = 0;
+			data.redraw.width = centry->content->width;
+			data.redraw.height = centry->content->height;
+			content_broadcast(centry->content,
+					  CONTENT_MSG_REDRAW,
+					  &data);
+		}
+	}
+
+	if (icache->scale_count > 0) {
+		guit->misc->schedule(0, image_cache__scale, icache);
+	}
+}
+
+/**
+ * Get an image cache entry's bitmap resampled to the size it is plotted.
+ *
+ * Frontends would otherwise scale the bitmap on every redraw. A scaled
+ * bitmap is only made once the same size has been plotted twice in a
+ * row as sizes change continually while a page is resized or zoomed.
+ * It is made by a scheduled callback, outside of redraw, and kept for
+ * the plots which follow.
+ *
+ * \param centry The image cache entry, which must have a bitmap.
+ * \param width The width being plotted.
+ * \param height The height being plotted.
+ * \param interactive Whether the redraw may be followed by another.
+ * \return The scaled bitmap or NULL if the bitmap should be plotted.
+ */
+static struct bitmap *
+image_cache__scaled(struct image_cache_entry_s *centry,
+		    int width,
+		    int height,
+		    bool interactive)
+{
+	struct bitmap *bitmap = centry->bitmap;
+	int bitmap_width = guit->bitmap->get_width(bitmap);
+	int bitmap_height = guit->bitmap->get_height(bitmap);
+
+	if ((width <= 0) || (height <= 0) ||
+	    ((width == bitmap_width) && (height == bitmap_height)) ||
+	    ((bitmap_width == 1) && (bitmap_height == 1))) {
+		/* nothing to scale or plotted as a solid fill */
+		return NULL;
+	}
+
+	if ((width != centry->scaled_width) ||
+	    (height != centry->scaled_height)) {
+		image_cache__free_scaled(centry);
+		centry->scaled_width = width;
+		centry->scaled_height = height;
+		return NULL;
+	}
+
+	if (centry->scaled != NULL) {
+		image_cache->scaled_hit_count++;
+		return centry->scaled;
+	}
+
+	if (interactive && (centry->scale_pending == false)) {
+		centry->scale_pending = true;
+		if (image_cache->scale_count++ == 0) {
+			guit->misc->schedule(0, image_cache__scale,
+					     image_cache);
+		}
+	}
+
+	return NULL;
+}
+
 /* exported interface documented in image_cache.h */
 struct bitmap *image_cache_get_bitmap(const struct content *c)
 {
@@ -352,19 +971,14 @@ struct bitmap *image_cache_get_bitmap(const struct content *c)
 		return NULL;
 	}
 
-	if (centry->bitmap == NULL) {
-		if (centry->convert != NULL) {
-			centry->bitmap = centry->convert(centry->content);
-		}
+	/* users of the bitmap expect it at the content's own size */
+	if (image_cache__require(centry, c->width, c->height) &&
+	    (centry->convert != NULL)) {
+		image_cache__free_bitmap(centry);
+	}
 
-		if (centry->bitmap != NULL) {
-			image_cache_stats_bitmap_add(centry);
-			image_cache->miss_count++;
-			image_cache->miss_size += centry->bitmap_size;
-		} else {
-			image_cache->fail_count++;
-			image_cache->fail_size += centry->bitmap_size;
-		}
+	if (centry->bitmap == NULL) {
+		image_cache__convert(centry, true);
 	} else {
 		image_cache->hit_count++;
 		image_cache->hit_size += centry->bitmap_size;
@@ -398,6 +1012,41 @@ bool image_cache_speculate(struct content *c)
 	return decision;
 }
 
+/* exported interface documented in image_cache.h */
+void image_cache_display_size(const struct content *c, int *width, int *height)
+{
+	struct image_cache_entry_s *centry;
+
+	centry = image_cache__find(c);
+	if (centry == NULL) {
+		*width = c->width;
+		*height = c->height;
+		return;
+	}
+
+	image_cache__target_size(centry, width, height);
+}
+
+/* exported interface documented in image_cache.h */
+bool image_cache_reserve(size_t size)
+{
+	if ((size > (image_cache->params.limit / 8)) ||
+	    ((image_cache->total_bitmap_size + size) >
+	     image_cache->params.limit)) {
+		return false;
+	}
+
+	image_cache->total_bitmap_size += size;
+
+	return true;
+}
+
+/* exported interface documented in image_cache.h */
+void image_cache_unreserve(size_t size)
+{
+	image_cache->total_bitmap_size -= size;
+}
+
 /* exported interface documented in image_cache.h */
 struct bitmap *image_cache_find_bitmap(struct content *c)
 {
@@ -440,6 +1089,8 @@ nserror image_cache_fini(void)
 	unsigned int op_count;
 
 	guit->misc->schedule(-1, image_cache__background_update, image_cache);
+	guit->misc->schedule(-1, image_cache__decode, image_cache);
+	guit->misc->schedule(-1, image_cache__scale, image_cache);
 
 	NSLOG(netsurf, INFO, "Size at finish %"PRIsizet" (in %d)",
 	      image_cache->total_bitmap_size, image_cache->bitmap_count);
@@ -501,6 +1152,15 @@ nserror image_cache_fini(void)
 	      image_cache->peak_conversions_size,
 	      image_cache->peak_conversions);
 
+	NSLOG(netsurf, INFO,
+	      "Total conversion time %"PRIu64"ms, %d bitmaps evicted",
+	      image_cache->conversion_time,
+	      image_cache->eviction_count);
+
+	NSLOG(netsurf, INFO, "%d scaled bitmaps made, plotted %d times",
+	      image_cache->scaled_count,
+	      image_cache->scaled_hit_count);
+
 	free(image_cache);
 
 	return NSERROR_OK;
@@ -525,8 +1185,8 @@ nserror image_cache_add(struct content *content,
 		if (centry == NULL) {
 			return NSERROR_NOMEM;
 		}
-		image_cache__link(centry);
 		centry->content = content;
+		image_cache__link(centry);
 
 		centry->bitmap_size = content->width * content->height * 4;
 	}
@@ -538,27 +1198,49 @@ nserror image_cache_add(struct content *content,
 
 	/* set bitmap entry if one is passed, free extant one if present */
 	if (bitmap != NULL) {
-		if (centry->bitmap != NULL) {
-			guit->bitmap->destroy(centry->bitmap);
-		} else {
-			image_cache_stats_bitmap_add(centry);
-		}
+		image_cache__free_bitmap(centry);
 		centry->bitmap = bitmap;
+		image_cache_stats_bitmap_add(centry);
 	} else {
-		/* no bitmap, check to see if we should speculatively convert */
+		/* no bitmap, check to see if we should speculatively
+		 * convert, which is done from the scheduler so content
+		 * conversion is not held up.
+		 */
 		if ((centry->convert != NULL) &&
 		    (image_cache_speculate(content) == true)) {
-			centry->bitmap = centry->convert(centry->content);
-
-			if (centry->bitmap != NULL) {
-				image_cache_stats_bitmap_add(centry);
-			} else {
-				image_cache->fail_count++;
-			}
+			image_cache__queue_decode(centry, false);
 		}
 	}
 
+	return NSERROR_OK;
+}
+
+/* exported interface documented in image_cache.h */
+nserror image_cache_set_band(struct content *content, image_cache_band_fn *band)
+{
+	struct image_cache_entry_s *centry;
+
+	centry = image_cache__find(content);
+	if (centry == NULL) {
+		return NSERROR_NOT_FOUND;
+	}
+
+	centry->band = band;
+
+	return NSERROR_OK;
+}
+
+/* exported interface documented in image_cache.h */
+nserror image_cache_set_vector(struct content *content)
+{
+	struct image_cache_entry_s *centry;
 
+	centry = image_cache__find(content);
+	if (centry == NULL) {
+		return NSERROR_NOT_FOUND;
+	}
+
+	centry->vector = true;
 
 	return NSERROR_OK;
 }
@@ -667,6 +1349,10 @@ case chr :					\
 			FMTCHR('v', "d", total_extra_conversions_count);
 			FMTCHR('w', "u", peak_conversions_size);
 			FMTCHR('x', "d", peak_conversions);
+			FMTCHR('y', PRIu64, conversion_time);
+			FMTCHR('z', "d", eviction_count);
+			FMTCHR('A', "d", scaled_count);
+			FMTCHR('B', "d", scaled_hit_count);
 
 
 			}
@@ -728,6 +1414,11 @@ image_cache_snentryf(char *string,
 						"%d", centry->conversion_count);
 				break;
 
+			case 't':
+				slen += snprintf(string + slen, size - slen,
+						"%u", centry->conversion_time);
+				break;
+
 			case 'g':
 				slen += snprintf(string + slen, size - slen,
 						"%.2f", (float)((image_cache->current_age -  centry->bitmap_age)) / 1000);
@@ -801,6 +1492,7 @@ bool image_cache_redraw(struct content *c,
 			const struct redraw_context *ctx)
 {
 	struct image_cache_entry_s *centry;
+	struct bitmap *scaled;
 
 	/* get the cache entry */
 	centry = image_cache__find(c);
@@ -810,18 +1502,28 @@ bool image_cache_redraw(struct content *c,
 		return false;
 	}
 
+	if (image_cache__require(centry, data->width, data->height) &&
+	    (centry->convert != NULL)) {
+		if (ctx->interactive) {
+			/* Plot the existing bitmap until it has been
+			 * converted again at the larger size.
+			 */
+			image_cache__queue_decode(centry, true);
+		} else {
+			image_cache__free_bitmap(centry);
+		}
+	}
+
 	if (centry->bitmap == NULL) {
-		if (centry->convert != NULL) {
-			centry->bitmap = centry->convert(centry->content);
+		if ((centry->convert != NULL) && ctx->interactive) {
+			/* Convert outside of redraw; the content is
+			 * redrawn once the bitmap is available.
+			 */
+			image_cache__queue_decode(centry, true);
+			return true;
 		}
 
-		if (centry->bitmap != NULL) {
-			image_cache_stats_bitmap_add(centry);
-			image_cache->miss_count++;
-			image_cache->miss_size += centry->bitmap_size;
-		} else {
-			image_cache->fail_count++;
-			image_cache->fail_size += centry->bitmap_size;
+		if (image_cache__convert(centry, true) == false) {
 			return false;
 		}
 	} else {
@@ -834,6 +1536,14 @@ bool image_cache_redraw(struct content *c,
 	centry->redraw_count++;
 	centry->redraw_age = image_cache->current_age;
 
+	if ((data->repeat_x == false) && (data->repeat_y == false)) {
+		scaled = image_cache__scaled(centry, data->width, data->height,
+					     ctx->interactive);
+		if (scaled != NULL) {
+			return image_bitmap_plot(scaled, data, clip, ctx);
+		}
+	}
+
 	return image_bitmap_plot(centry->bitmap, data, clip, ctx);
 }
 
@@ -862,7 +1572,11 @@ void *image_cache_get_internal(const struct content *c, void *context)
 bool image_cache_is_opaque(struct content *c)
 {
 	struct bitmap *bmp;
-	bmp = image_cache_get_bitmap(c);
+
+	/* Only consider an existing bitmap, this is asked during redraw
+	 * and until a conversion completes the image is not plotted.
+	 */
+	bmp = image_cache_find_bitmap(c);
 	if (bmp != NULL) {
 		return guit->bitmap->get_opaque(bmp);
 	}
@@ -46,6 +46,22 @@ struct redraw_context;
 
 typedef struct bitmap * (image_cache_convert_fn) (struct content *content);
 
+/**
+ * Convert the next band of rows of a content into a bitmap.
+ *
+ * The content handler keeps the state of the conversion between calls
+ * and must discard it if the content's convert function is called
+ * before the banded conversion is complete.
+ *
+ * \param content The content to convert.
+ * \param ms The time in ms to spend converting before returning.
+ * \param bitmap_out Updated with the bitmap when conversion completes.
+ * \return NSERROR_OK when conversion is complete, NSERROR_NEED_DATA if
+ *         rows remain to be converted or error code on faliure.
+ */
+typedef nserror (image_cache_band_fn) (struct content *content,
+		unsigned int ms, struct bitmap **bitmap_out);
+
 struct image_cache_parameters {
 	/** How frequently the background cache clean process is run (ms) */
 	unsigned int bg_clean_time;
@@ -78,6 +94,34 @@ nserror image_cache_add(struct content *content,
 			struct bitmap *bitmap, 
 			image_cache_convert_fn *convert);
 
+/**
+ * Allow a cached image content to be converted in bands.
+ *
+ * Conversions performed in the background are then split into bands
+ * of rows converted from successive scheduler callbacks, so converting
+ * a large image does not hold up input handling and redraw.
+ *
+ * \param content The content handle used as a key.
+ * \param band A function to convert the content a band at a time.
+ * \return NSERROR_OK on success or NSERROR_NOT_FOUND if the content
+ *         is not in the cache.
+ */
+nserror image_cache_set_band(struct content *content, image_cache_band_fn *band);
+
+/**
+ * Allow a cached content to be converted larger than its own size.
+ *
+ * This is for contents, such as vector images, which lose no quality
+ * when converted at a larger size. Their bitmaps are converted at the
+ * size they are plotted at, whatever its aspect ratio, rather than
+ * scaled up from a bitmap at the content's own size.
+ *
+ * \param content The content handle used as a key.
+ * \return NSERROR_OK on success or NSERROR_NOT_FOUND if the content
+ *         is not in the cache.
+ */
+nserror image_cache_set_vector(struct content *content);
+
 nserror image_cache_remove(struct content *content);
 
 
@@ -91,14 +135,53 @@ struct bitmap *image_cache_find_bitmap(struct content *c);
  *
  * This allows for image content handlers to ask the cache if a bitmap
  * should be generated before it is added to the cache. This is the
- * same decision logic used to decide to perform an immediate
- * conversion when a content is initially added to the cache. 
+ * same decision logic used to decide to schedule a speculative
+ * conversion when a content is initially added to the cache.
  *
  * @param c The content to be considered.
  * @return true if a speculative conversion is desired false otherwise.
  */
 bool image_cache_speculate(struct content *c);
 
+/**
+ * Get the size an image content's bitmap should be converted at.
+ *
+ * Image content convert functions may use this to create a bitmap
+ * smaller than the content when it is only plotted at a smaller
+ * size. The returned size has the aspect ratio of the content and is
+ * never larger than it, unless the content has been allowed to be with
+ * image_cache_set_vector(), when it is the size the content was last
+ * plotted at. A bitmap at least this size, and no larger
+ * than the content, may be returned by the conversion; the cache
+ * converts again if the content is later plotted larger.
+ *
+ * \param c The content being converted.
+ * \param width Updated with the width to convert at.
+ * \param height Updated with the height to convert at.
+ */
+void image_cache_display_size(const struct content *c, int *width, int *height);
+
+/**
+ * Reserve space within the cache limit for bitmaps held elsewhere.
+ *
+ * Allows image content handlers which keep extra bitmaps, such as
+ * the frames of an animation, to have them count against the cache
+ * limit so the cache frees its own bitmaps to make room. A request
+ * for more than an eighth of the limit, or for more than the limit
+ * has room for, is refused.
+ *
+ * \param size The number of bytes to reserve.
+ * \return true if the space was reserved else false.
+ */
+bool image_cache_reserve(size_t size);
+
+/**
+ * Release space reserved with image_cache_reserve().
+ *
+ * \param size The number of bytes to release.
+ */
+void image_cache_unreserve(size_t size);
+
 /**
  * Fill a buffer with information about a cache entry using a format.
  *
@@ -108,6 +191,7 @@ bool image_cache_speculate(struct content *c);
  * %k - The content key
  * %r - The number of redraws of this bitmap
  * %c - The number of times this bitmap has been converted
+ * %t - The time in ms the last conversion of this bitmap took
  * %s - The size of the current bitmap allocation
  *
  * \param string  The buffer in which to place the results.
@@ -156,6 +240,10 @@ int image_cache_snentryf(char *string, size_t size, unsigned int entryn,
  *     of times.
  * x The number of times the image that was converted (read missed cache) 
  *     highest number of times.
+ * y The total time in ms spent converting images.
+ * z The number of bitmaps freed by the cache cleaner.
+ * A The number of bitmaps scaled to the size they are plotted at.
+ * B The number of plots made from scaled bitmaps.
  *
  * format modifiers:
  * A p before the value modifies the replacement to be a percentage.
@@ -177,6 +265,10 @@ int image_cache_snsummaryf(char *string, size_t size, const char *fmt);
  * May be used by image content handlers as their redraw
  * callback. Performs all neccissary cache lookups and conversions and
  * calls the bitmap plot function in the redraw context.
+ *
+ * For interactive redraws an image which has not been converted is
+ * not plotted; the conversion is scheduled instead and a
+ * CONTENT_MSG_REDRAW is broadcast once the bitmap is available.
  */
 bool image_cache_redraw(struct content *c, 
 			struct content_redraw_data *data,
@@ -24,20 +24,26 @@
  * This implementation uses the IJG JPEG library.
  */
 
+#include <assert.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <setjmp.h>
+#include <nsutils/time.h>
 
 #include "utils/utils.h"
 #include "utils/log.h"
 #include "utils/messages.h"
+#include "utils/pixels.h"
+#include "netsurf/misc.h"
 #include "netsurf/bitmap.h"
+#include "netsurf/plotters.h"
 #include "content/llcache.h"
 #include "content/content.h"
 #include "content/content_protected.h"
 #include "content/content_factory.h"
 #include "desktop/gui_internal.h"
 
+#include "image/image.h"
 #include "image/image_cache.h"
 
 #define JPEG_INTERNAL_OPTIONS
@@ -49,6 +55,15 @@
  */
 #define MIN_JPEG_SIZE 20
 
+/** amount of progressive jpeg data received before a preview is decoded */
+#define MIN_JPEG_PREVIEW_SIZE 4096
+
+/** minimum time in ms between decodes of progressive jpeg previews */
+#define JPEG_PREVIEW_DELAY 250
+
+/** number of rows decoded between checks of the time taken by a band */
+#define JPEG_BAND_CHECK_ROWS 16
+
 #ifdef riscos
 /* We prefer the library to be configured with these options to save
  * copying data during decoding. */
@@ -62,6 +77,36 @@ static char nsjpeg_error_buffer[JMSG_LENGTH_MAX];
 
 static unsigned char nsjpeg_eoi[] = { 0xff, JPEG_EOI };
 
+/**
+ * State of a jpeg conversion which may be performed in bands of rows
+ */
+struct nsjpeg_band {
+	struct jpeg_decompress_struct cinfo; /**< decompressor */
+	struct jpeg_error_mgr jerr; /**< decompressor error handler */
+	jmp_buf setjmp_buffer; /**< fatal error exit */
+	struct jpeg_source_mgr source_mgr; /**< decompressor data source */
+	struct bitmap *bitmap; /**< bitmap being converted into */
+	uint8_t *pixels; /**< bitmap buffer */
+	size_t rowstride; /**< bitmap row stride */
+};
+
+/**
+ * JPEG content
+ */
+typedef struct nsjpeg_content {
+	struct content base; /**< base content type */
+
+	bool sof_found; /**< The frame header has been found */
+	bool progressive; /**< The image is progressive */
+
+	struct bitmap *preview; /**< Image decoded from partial data */
+	size_t preview_size; /**< Source size the preview was decoded from */
+	size_t preview_bytes; /**< image cache space reserved for preview */
+	bool preview_scheduled; /**< A preview decode is scheduled */
+
+	struct nsjpeg_band *band; /**< Conversion in bands in progress */
+} nsjpeg_content;
+
 /**
  * Content create entry point.
  */
@@ -70,21 +115,21 @@ static nserror nsjpeg_create(const content_handler *handler,
 		llcache_handle *llcache, const char *fallback_charset,
 		bool quirks, struct content **c)
 {
-	struct content *jpeg;
+	nsjpeg_content *jpeg;
 	nserror error;
 
-	jpeg = calloc(1, sizeof(struct content));
+	jpeg = calloc(1, sizeof(nsjpeg_content));
 	if (jpeg == NULL)
 		return NSERROR_NOMEM;
 
-	error = content__init(jpeg, handler, imime_type, params,
+	error = content__init(&jpeg->base, handler, imime_type, params,
 			      llcache, fallback_charset, quirks);
 	if (error != NSERROR_OK) {
 		free(jpeg);
 		return error;
 	}
 
-	*c = jpeg;
+	*c = (struct content *)jpeg;
 
 	return NSERROR_OK;
 }
@@ -165,29 +210,19 @@ static void nsjpeg_error_exit(j_common_ptr cinfo)
 }
 
 /**
- * create a bitmap from jpeg content.
+ * Begin converting jpeg content into a bitmap.
+ *
+ * \param c The jpeg content.
+ * \param preview Whether to decode a preview at the smallest scale.
+ * \return The conversion state or NULL on error.
  */
-static struct bitmap *
-jpeg_cache_convert(struct content *c)
+static struct nsjpeg_band *nsjpeg_band_create(struct content *c, bool preview)
 {
+	struct nsjpeg_band *band;
 	const uint8_t *source_data; /* Jpeg source data */
 	size_t source_size; /* length of Jpeg source data */
-	struct jpeg_decompress_struct cinfo;
-	struct jpeg_error_mgr jerr;
-	jmp_buf setjmp_buffer;
-	unsigned int height;
-	unsigned int width;
-	struct bitmap * volatile bitmap = NULL;
-	uint8_t * volatile pixels = NULL;
-	size_t rowstride;
-	struct jpeg_source_mgr source_mgr = {
-		0,
-		0,
-		nsjpeg_init_source,
-		nsjpeg_fill_input_buffer,
-		nsjpeg_skip_input_data,
-		jpeg_resync_to_restart,
-		nsjpeg_term_source };
+	int display_width;
+	int display_height;
 
 	/* obtain jpeg source data and perfom minimal sanity checks */
 	source_data = content__get_source_data(c, &source_size);
@@ -197,88 +232,129 @@ jpeg_cache_convert(struct content *c)
 		return NULL;
 	}
 
+	band = calloc(1, sizeof(struct nsjpeg_band));
+	if (band == NULL) {
+		return NULL;
+	}
+
 	/* setup a JPEG library error handler */
-	cinfo.err = jpeg_std_error(&jerr);
-	jerr.error_exit = nsjpeg_error_exit;
-	jerr.output_message = nsjpeg_error_log;
+	band->cinfo.err = jpeg_std_error(&band->jerr);
+	band->jerr.error_exit = nsjpeg_error_exit;
+	band->jerr.output_message = nsjpeg_error_log;
 
 	/* handler for fatal errors during decompression */
-	if (setjmp(setjmp_buffer)) {
-		jpeg_destroy_decompress(&cinfo);
-		return bitmap;
+	if (setjmp(band->setjmp_buffer)) {
+		jpeg_destroy_decompress(&band->cinfo);
+		if (band->bitmap != NULL) {
+			guit->bitmap->destroy(band->bitmap);
+		}
+		free(band);
+		return NULL;
 	}
 
-	cinfo.client_data = &setjmp_buffer;
-	jpeg_create_decompress(&cinfo);
+	band->cinfo.client_data = &band->setjmp_buffer;
+	jpeg_create_decompress(&band->cinfo);
 
 	/* setup data source */
-	source_mgr.next_input_byte = source_data;
-	source_mgr.bytes_in_buffer = source_size;
-	cinfo.src = &source_mgr;
+	band->source_mgr.next_input_byte = source_data;
+	band->source_mgr.bytes_in_buffer = source_size;
+	band->source_mgr.init_source = nsjpeg_init_source;
+	band->source_mgr.fill_input_buffer = nsjpeg_fill_input_buffer;
+	band->source_mgr.skip_input_data = nsjpeg_skip_input_data;
+	band->source_mgr.resync_to_restart = jpeg_resync_to_restart;
+	band->source_mgr.term_source = nsjpeg_term_source;
+	band->cinfo.src = &band->source_mgr;
 
 	/* read JPEG header information */
-	jpeg_read_header(&cinfo, TRUE);
+	jpeg_read_header(&band->cinfo, TRUE);
 
 	/* set output processing parameters */
-	if (cinfo.jpeg_color_space == JCS_CMYK ||
-			cinfo.jpeg_color_space == JCS_YCCK) {
-		cinfo.out_color_space = JCS_CMYK;
+	if (band->cinfo.jpeg_color_space == JCS_CMYK ||
+			band->cinfo.jpeg_color_space == JCS_YCCK) {
+		band->cinfo.out_color_space = JCS_CMYK;
 	} else {
-		cinfo.out_color_space = JCS_RGB;
+		band->cinfo.out_color_space = JCS_RGB;
+	}
+	band->cinfo.dct_method = JDCT_ISLOW;
+
+	/* Images plotted smaller than their size are scaled down by the
+	 * inverse DCT, by up to 1/8, which is much cheaper in time and
+	 * memory than a full size decode.
+	 */
+	image_cache_display_size(c, &display_width, &display_height);
+	band->cinfo.scale_num = 1;
+	band->cinfo.scale_denom = preview ? 8 : 1;
+	while ((band->cinfo.scale_denom < 8) &&
+	       (band->cinfo.image_width / (band->cinfo.scale_denom * 2) >=
+		(unsigned int)display_width) &&
+	       (band->cinfo.image_height / (band->cinfo.scale_denom * 2) >=
+		(unsigned int)display_height)) {
+		band->cinfo.scale_denom *= 2;
 	}
-	cinfo.dct_method = JDCT_ISLOW;
 
 	/* commence the decompression, output parameters now valid */
-	jpeg_start_decompress(&cinfo);
-
-	width = cinfo.output_width;
-	height = cinfo.output_height;
+	jpeg_start_decompress(&band->cinfo);
 
 	/* create opaque bitmap (jpegs cannot be transparent) */
-	bitmap = guit->bitmap->create(width, height, BITMAP_NEW | BITMAP_OPAQUE);
-	if (bitmap == NULL) {
+	band->bitmap = guit->bitmap->create(band->cinfo.output_width,
+					    band->cinfo.output_height,
+					    BITMAP_NEW | BITMAP_OPAQUE);
+	if (band->bitmap == NULL) {
 		/* empty bitmap could not be created */
-		jpeg_destroy_decompress(&cinfo);
+		jpeg_destroy_decompress(&band->cinfo);
+		free(band);
 		return NULL;
 	}
 
-	pixels = guit->bitmap->get_buffer(bitmap);
-	if (pixels == NULL) {
+	band->pixels = guit->bitmap->get_buffer(band->bitmap);
+	if (band->pixels == NULL) {
 		/* bitmap with no buffer available */
-		guit->bitmap->destroy(bitmap);
-		jpeg_destroy_decompress(&cinfo);
+		guit->bitmap->destroy(band->bitmap);
+		jpeg_destroy_decompress(&band->cinfo);
+		free(band);
 		return NULL;
 	}
 
-	/* Convert scanlines from jpeg into bitmap */
-	rowstride = guit->bitmap->get_rowstride(bitmap);
-	do {
+	band->rowstride = guit->bitmap->get_rowstride(band->bitmap);
+
+	return band;
+}
+
+
+/**
+ * Convert scanlines from jpeg into the bitmap.
+ *
+ * A fatal error leaves the rest of the bitmap undecoded and the
+ * conversion is finished with the rows decoded so far.
+ *
+ * \param band The conversion state.
+ * \param ms The time in ms to spend decoding or 0 to decode every row.
+ * \return true if the conversion is finished else false.
+ */
+static bool nsjpeg_band_rows(struct nsjpeg_band *band, unsigned int ms)
+{
+	struct jpeg_decompress_struct *cinfo = &band->cinfo;
+	unsigned int width = cinfo->output_width;
+	unsigned int rows = 0;
+	uint64_t ms_start;
+	uint64_t ms_now;
+
+	nsu_getmonotonic_ms(&ms_start);
+
+	if (setjmp(band->setjmp_buffer)) {
+		return true;
+	}
+
+	while (cinfo->output_scanline != cinfo->output_height) {
 		JSAMPROW scanlines[1];
 
-		scanlines[0] = (JSAMPROW) (pixels +
-					   rowstride * cinfo.output_scanline);
-		jpeg_read_scanlines(&cinfo, scanlines, 1);
+		scanlines[0] = (JSAMPROW) (band->pixels +
+				band->rowstride * cinfo->output_scanline);
+		jpeg_read_scanlines(cinfo, scanlines, 1);
 
-		if (cinfo.out_color_space == JCS_CMYK) {
-			int i;
-			for (i = width - 1; 0 <= i; i--) {
-				/* Trivial inverse CMYK -> RGBA */
-				const int c = scanlines[0][i * 4 + 0];
-				const int m = scanlines[0][i * 4 + 1];
-				const int y = scanlines[0][i * 4 + 2];
-				const int k = scanlines[0][i * 4 + 3];
-
-				const int ck = c * k;
-				const int mk = m * k;
-				const int yk = y * k;
-
-#define DIV255(x) ((x) + 1 + ((x) >> 8)) >> 8
-				scanlines[0][i * 4 + 0] = DIV255(ck);
-				scanlines[0][i * 4 + 1] = DIV255(mk);
-				scanlines[0][i * 4 + 2] = DIV255(yk);
-				scanlines[0][i * 4 + 3] = 0xff;
-#undef DIV255
-			}
+		if (cinfo->out_color_space == JCS_CMYK) {
+			/* Trivial inverse CMYK -> RGBA */
+			pixels_cmyk_to_rgba(scanlines[0], width);
 		} else {
 #if RGB_RED != 0 || RGB_GREEN != 1 || RGB_BLUE != 2 || RGB_PIXELSIZE != 4
 			/* Missmatch between configured libjpeg pixel format and
@@ -295,20 +371,279 @@ jpeg_cache_convert(struct content *c)
 			}
 #endif
 		}
-	} while (cinfo.output_scanline != cinfo.output_height);
+
+		if ((ms != 0) && ((++rows % JPEG_BAND_CHECK_ROWS) == 0)) {
+			nsu_getmonotonic_ms(&ms_now);
+			if ((ms_now - ms_start) >= ms) {
+				return false;
+			}
+		}
+	}
+
+	jpeg_finish_decompress(cinfo);
+
+	return true;
+}
+
+
+/**
+ * Finish converting jpeg content into a bitmap.
+ *
+ * \param band The conversion state which is freed.
+ * \return The converted bitmap.
+ */
+static struct bitmap *nsjpeg_band_finish(struct nsjpeg_band *band)
+{
+	struct bitmap *bitmap = band->bitmap;
+
 	guit->bitmap->modified(bitmap);
 
-	jpeg_finish_decompress(&cinfo);
-	jpeg_destroy_decompress(&cinfo);
+	jpeg_destroy_decompress(&band->cinfo);
+	free(band);
 
 	return bitmap;
 }
 
+
+/**
+ * Abandon converting jpeg content into a bitmap.
+ *
+ * \param band The conversion state which is freed.
+ */
+static void nsjpeg_band_destroy(struct nsjpeg_band *band)
+{
+	guit->bitmap->destroy(band->bitmap);
+	jpeg_destroy_decompress(&band->cinfo);
+	free(band);
+}
+
+
+/**
+ * create a bitmap from jpeg content.
+ */
+static struct bitmap *
+jpeg_cache_convert(struct content *c)
+{
+	nsjpeg_content *jpeg = (nsjpeg_content *)c;
+	struct nsjpeg_band *band;
+
+	if (jpeg->band != NULL) {
+		/* conversion in bands is superseded */
+		nsjpeg_band_destroy(jpeg->band);
+		jpeg->band = NULL;
+	}
+
+	band = nsjpeg_band_create(c, false);
+	if (band == NULL) {
+		return NULL;
+	}
+
+	nsjpeg_band_rows(band, 0);
+
+	return nsjpeg_band_finish(band);
+}
+
+
+/**
+ * create a bitmap from jpeg content a band of rows at a time.
+ */
+static nserror
+jpeg_cache_band(struct content *c, unsigned int ms, struct bitmap **bitmap_out)
+{
+	nsjpeg_content *jpeg = (nsjpeg_content *)c;
+
+	if (jpeg->band == NULL) {
+		jpeg->band = nsjpeg_band_create(c, false);
+		if (jpeg->band == NULL) {
+			return NSERROR_INVALID;
+		}
+	}
+
+	if (nsjpeg_band_rows(jpeg->band, ms) == false) {
+		return NSERROR_NEED_DATA;
+	}
+
+	*bitmap_out = nsjpeg_band_finish(jpeg->band);
+	jpeg->band = NULL;
+
+	return NSERROR_OK;
+}
+
+/**
+ * Find the frame header in jpeg source data.
+ *
+ * \param data The source data.
+ * \param size The length of the source data.
+ * \param width Updated with the image width.
+ * \param height Updated with the image height.
+ * \param progressive Updated with whether the image is progressive.
+ * \return true if the frame header was found else false.
+ */
+static bool
+nsjpeg_find_sof(const uint8_t *data,
+		size_t size,
+		int *width,
+		int *height,
+		bool *progressive)
+{
+	size_t offset = 2;
+	uint8_t marker;
+
+	/* must start with a start of image marker */
+	if ((size < 4) || (data[0] != 0xff) || (data[1] != 0xd8)) {
+		return false;
+	}
+
+	while (offset + 4 <= size) {
+		if (data[offset] != 0xff) {
+			return false;
+		}
+
+		marker = data[offset + 1];
+		if (marker == 0xff) {
+			/* fill byte */
+			offset++;
+			continue;
+		}
+
+		if ((marker >= 0xc0) && (marker <= 0xcf) &&
+		    (marker != 0xc4) && (marker != 0xc8) && (marker != 0xcc)) {
+			/* start of frame, progressive types are 0xc2,
+			 * 0xc6, 0xca and 0xce
+			 */
+			if (offset + 9 > size) {
+				return false;
+			}
+			*height = (data[offset + 5] << 8) | data[offset + 6];
+			*width = (data[offset + 7] << 8) | data[offset + 8];
+			*progressive = ((marker & 0x3) == 0x2);
+			return true;
+		}
+
+		/* skip marker segment */
+		offset += 2 + ((data[offset + 2] << 8) | data[offset + 3]);
+	}
+
+	return false;
+}
+
+
+/**
+ * Discard the preview of a progressive jpeg.
+ *
+ * \param jpeg The jpeg content.
+ */
+static void nsjpeg_preview_discard(nsjpeg_content *jpeg)
+{
+	if (jpeg->preview != NULL) {
+		guit->bitmap->destroy(jpeg->preview);
+		jpeg->preview = NULL;
+		image_cache_unreserve(jpeg->preview_bytes);
+		jpeg->preview_bytes = 0;
+	}
+}
+
+
+/**
+ * Scheduler callback to decode a preview of a progressive jpeg.
+ *
+ * The preview is decoded at an eighth of the image size by the inverse
+ * DCT and counted against the image cache limit.
+ *
+ * \param p The jpeg content.
+ */
+static void nsjpeg_preview(void *p)
+{
+	struct content *c = p;
+	nsjpeg_content *jpeg = p;
+	struct nsjpeg_band *band;
+	size_t source_size;
+	size_t bytes;
+	union content_msg_data msg_data;
+
+	jpeg->preview_scheduled = false;
+
+	content__get_source_data(c, &source_size);
+
+	band = nsjpeg_band_create(c, true);
+	if (band == NULL) {
+		return;
+	}
+
+	bytes = (size_t)band->cinfo.output_width *
+		band->cinfo.output_height * 4;
+	if (!image_cache_reserve(bytes)) {
+		nsjpeg_band_destroy(band);
+		return;
+	}
+
+	nsjpeg_band_rows(band, 0);
+
+	nsjpeg_preview_discard(jpeg);
+	jpeg->preview = nsjpeg_band_finish(band);
+	jpeg->preview_bytes = bytes;
+	jpeg->preview_size = source_size;
+
+	msg_data.redraw.x = 0;
+	msg_data.redraw.y = 0;
+	msg_data.redraw.width = c->width;
+	msg_data.redraw.height = c->height;
+	content_broadcast(c, CONTENT_MSG_REDRAW, &msg_data);
+}
+
+
+/**
+ * Process data for a CONTENT_JPEG.
+ *
+ * Progressive images are decoded from the data received so far so
+ * each scan can be displayed as it arrives. A new preview is decoded
+ * each time the received data doubles, no more often than every
+ * JPEG_PREVIEW_DELAY ms, which keeps the total work to about twice
+ * that of a single decode at preview scale.
+ */
+static bool
+nsjpeg_process_data(struct content *c, const char *data, unsigned int size)
+{
+	nsjpeg_content *jpeg = (nsjpeg_content *)c;
+	const uint8_t *source_data;
+	size_t source_size;
+	int width, height;
+
+	source_data = content__get_source_data(c, &source_size);
+
+	if (!jpeg->sof_found) {
+		jpeg->sof_found = nsjpeg_find_sof(source_data,
+						  source_size,
+						  &width,
+						  &height,
+						  &jpeg->progressive);
+		if (!jpeg->sof_found || !jpeg->progressive) {
+			return true;
+		}
+		c->width = width;
+		c->height = height;
+	}
+
+	if ((!jpeg->progressive) ||
+	    (jpeg->preview_scheduled) ||
+	    (source_size < max(jpeg->preview_size * 2,
+			       MIN_JPEG_PREVIEW_SIZE))) {
+		return true;
+	}
+
+	jpeg->preview_scheduled = true;
+	guit->misc->schedule(JPEG_PREVIEW_DELAY, nsjpeg_preview, c);
+
+	return true;
+}
+
+
 /**
  * Convert a CONTENT_JPEG for display.
  */
 static bool nsjpeg_convert(struct content *c)
 {
+	nsjpeg_content *jpeg = (nsjpeg_content *)c;
 	struct jpeg_decompress_struct cinfo;
 	struct jpeg_error_mgr jerr;
 	jmp_buf setjmp_buffer;
@@ -321,6 +656,10 @@ static bool nsjpeg_convert(struct content *c)
 	size_t size;
 	char *title;
 
+	/* all the data has arrived so no further preview is needed */
+	guit->misc->schedule(-1, nsjpeg_preview, c);
+	jpeg->preview_scheduled = false;
+
 	/* check image header is valid and get width/height */
 	data = content__get_source_data(c, &size);
 
@@ -355,6 +694,7 @@ static bool nsjpeg_convert(struct content *c)
 	jpeg_destroy_decompress(&cinfo);
 
 	image_cache_add(c, NULL, jpeg_cache_convert);
+	image_cache_set_band(c, jpeg_cache_band);
 
 	/* set title text */
 	title = messages_get_buff("JPEGTitle",
@@ -374,6 +714,59 @@ static bool nsjpeg_convert(struct content *c)
 
 
 
+/**
+ * Redraw a CONTENT_JPEG.
+ *
+ * Any preview of a progressive image is plotted while the image is
+ * loading and until the complete image has been converted.
+ */
+static bool
+nsjpeg_redraw(struct content *c,
+	      struct content_redraw_data *data,
+	      const struct rect *clip,
+	      const struct redraw_context *ctx)
+{
+	nsjpeg_content *jpeg = (nsjpeg_content *)c;
+
+	if (jpeg->preview != NULL) {
+		if (c->status == CONTENT_STATUS_LOADING) {
+			return image_bitmap_plot(jpeg->preview,
+						 data, clip, ctx);
+		}
+
+		if (image_cache_find_bitmap(c) == NULL && ctx->interactive) {
+			/* queue the conversion of the complete image */
+			image_cache_redraw(c, data, clip, ctx);
+
+			return image_bitmap_plot(jpeg->preview,
+						 data, clip, ctx);
+		}
+
+		nsjpeg_preview_discard(jpeg);
+	}
+
+	return image_cache_redraw(c, data, clip, ctx);
+}
+
+
+/**
+ * Destroy a CONTENT_JPEG.
+ */
+static void nsjpeg_destroy(struct content *c)
+{
+	nsjpeg_content *jpeg = (nsjpeg_content *)c;
+
+	guit->misc->schedule(-1, nsjpeg_preview, c);
+	nsjpeg_preview_discard(jpeg);
+
+	if (jpeg->band != NULL) {
+		nsjpeg_band_destroy(jpeg->band);
+	}
+
+	image_cache_destroy(c);
+}
+
+
 /**
  * Clone content.
  */
@@ -382,7 +775,7 @@ static nserror nsjpeg_clone(const struct content *old, struct content **newc)
 	struct content *jpeg_c;
 	nserror error;
 
-	jpeg_c = calloc(1, sizeof(struct content));
+	jpeg_c = calloc(1, sizeof(nsjpeg_content));
 	if (jpeg_c == NULL)
 		return NSERROR_NOMEM;
 
@@ -408,9 +801,10 @@ static nserror nsjpeg_clone(const struct content *old, struct content **newc)
 
 static const content_handler nsjpeg_content_handler = {
 	.create = nsjpeg_create,
+	.process_data = nsjpeg_process_data,
 	.data_complete = nsjpeg_convert,
-	.destroy = image_cache_destroy,
-	.redraw = image_cache_redraw,
+	.destroy = nsjpeg_destroy,
+	.redraw = nsjpeg_redraw,
 	.clone = nsjpeg_clone,
 	.get_internal = image_cache_get_internal,
 	.type = image_cache_content_type,
@@ -22,6 +22,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <png.h>
+#include <nsutils/time.h>
 
 #include "netsurf/inttypes.h"
 #include "utils/utils.h"
@@ -29,10 +30,12 @@
 #include "utils/messages.h"
 #include "netsurf/bitmap.h"
 #include "content/llcache.h"
+#include "content/content.h"
 #include "content/content_protected.h"
 #include "content/content_factory.h"
 #include "desktop/gui_internal.h"
 
+#include "image/image.h"
 #include "image/image_cache.h"
 #include "image/png.h"
 
@@ -57,12 +60,20 @@ typedef struct nspng_content {
 	struct bitmap *bitmap;	/**< Created NetSurf bitmap */
 	size_t rowstride, bpp; /**< Bitmap rowstride and bpp */
 	size_t rowbytes; /**< Number of bytes per row */
+	png_uint_32 redraw_y0; /**< First bitmap row changed since redraw */
+	png_uint_32 redraw_y1; /**< Row after last changed since redraw */
+	struct nspng_band *band; /**< Conversion in bands in progress */
 } nspng_content;
 
-static unsigned int interlace_start[8] = {0, 16, 0, 8, 0, 4, 0};
-static unsigned int interlace_step[8] = {28, 28, 12, 12, 4, 4, 0};
-static unsigned int interlace_row_start[8] = {0, 0, 4, 0, 2, 0, 1};
-static unsigned int interlace_row_step[8] = {8, 8, 8, 4, 4, 2, 2};
+/* Adam7 interlace pass geometry in pixels */
+static const unsigned int interlace_start[7] = {0, 4, 0, 2, 0, 1, 0};
+static const unsigned int interlace_step[7] = {8, 8, 4, 4, 2, 2, 1};
+static const unsigned int interlace_row_start[7] = {0, 0, 4, 0, 2, 0, 1};
+static const unsigned int interlace_row_step[7] = {8, 8, 8, 4, 4, 2, 2};
+
+/* Area each pixel of an interlace pass covers until later passes arrive */
+static const unsigned int interlace_block_width[7] = {8, 4, 4, 2, 2, 1, 1};
+static const unsigned int interlace_block_height[7] = {8, 8, 4, 4, 2, 2, 1};
 
 /** Callbak error numbers*/
 enum nspng_cberr {
@@ -88,6 +99,12 @@ static void nspng_error(png_structp png_ptr, png_const_charp error_message)
 	longjmp(png_jmpbuf(png_ptr), CBERR_LIBPNG);
 }
 
+/**
+ * Largest factor an image is reduced by while it is decoded, which
+ * keeps the alpha weighted sums of a block within 32 bits.
+ */
+#define PNG_REDUCE_MAX 255U
+
 static void nspng_setup_transforms(png_structp png_ptr, png_infop info_ptr)
 {
 	int bit_depth, color_type, intent;
@@ -157,8 +174,12 @@ static void info_callback(png_structp png_s, png_infop info)
 	png_c->base.height = height;
 	png_c->base.size += width * height * 4;
 
-	/* see if progressive-conversion should continue */
-	if (image_cache_speculate((struct content *)png_c) == false) {
+	/* see if progressive-conversion should continue, interlaced
+	 * images are always converted so their passes can be displayed
+	 * as they arrive.
+	 */
+	if ((interlace != PNG_INTERLACE_ADAM7) &&
+	    (image_cache_speculate((struct content *)png_c) == false)) {
 		longjmp(png_jmpbuf(png_s), CBERR_NOPRE);
 	}
 
@@ -176,6 +197,8 @@ static void info_callback(png_structp png_s, png_infop info)
 
 	png_c->rowbytes = png_get_rowbytes(png_s, info);
 	png_c->interlace = (interlace == PNG_INTERLACE_ADAM7);
+	png_c->redraw_y0 = height;
+	png_c->redraw_y1 = 0;
 
 	NSLOG(netsurf, INFO, "size %li * %li, rowbytes %"PRIsizet,
 	      (unsigned long)width, (unsigned long)height, png_c->rowbytes);
@@ -203,33 +226,43 @@ static void row_callback(png_structp png_s, png_bytep new_row,
 		longjmp(png_jmpbuf(png_s), 1);
 	}
 
-	/* Calculate address of row start */
-	row = buffer + (png_c->rowstride * row_num);
-
 	/* Handle interlaced sprites using the Adam7 algorithm */
 	if (png_c->interlace) {
-		unsigned long dst_off;
-		unsigned long src_off = 0;
-		unsigned int start, step;
+		png_uint_32 width = png_c->base.width;
+		png_uint_32 height = png_c->base.height;
+		png_uint_32 x, bx, by, block_w, block_h;
 
-		start = interlace_start[pass];
-		step = interlace_step[pass];
 		row_num = interlace_row_start[pass] +
 			interlace_row_step[pass] * row_num;
 
-		/* Copy the data to our current row taking interlacing
-		 * into consideration */
-		row = buffer + (png_c->rowstride * row_num);
-
-		for (dst_off = start; dst_off < rowbytes; dst_off += step) {
-			row[dst_off++] = new_row[src_off++];
-			row[dst_off++] = new_row[src_off++];
-			row[dst_off++] = new_row[src_off++];
-			row[dst_off++] = new_row[src_off++];
+		/* Each pixel fills the block later passes will refine so
+		 * the image is displayed coarsely as the passes arrive.
+		 */
+		block_h = min(interlace_block_height[pass], height - row_num);
+		for (x = interlace_start[pass];
+		     x < width;
+		     x += interlace_step[pass]) {
+			block_w = min(interlace_block_width[pass], width - x);
+			for (by = 0; by < block_h; by++) {
+				row = buffer +
+					(png_c->rowstride * (row_num + by)) +
+					(x * 4);
+				for (bx = 0; bx < block_w; bx++) {
+					memcpy(row + (bx * 4), new_row, 4);
+				}
+			}
+			new_row += 4;
 		}
+
+		png_c->redraw_y0 = min(png_c->redraw_y0, row_num);
+		png_c->redraw_y1 = max(png_c->redraw_y1, row_num + block_h);
 	} else {
 		/* Do a fast memcpy of the row data */
+		row = buffer + (png_c->rowstride * row_num);
 		memcpy(row, new_row, rowbytes);
+
+		png_c->redraw_y0 = min(png_c->redraw_y0, row_num);
+		png_c->redraw_y1 = max(png_c->redraw_y1, row_num + 1);
 	}
 }
 
@@ -314,6 +347,35 @@ nspng_create(const content_handler *handler,
 }
 
 
+/**
+ * Request redraw of the bitmap rows decoded since the last request.
+ *
+ * This allows the image to be displayed as it is received.
+ *
+ * \param png_c The png content.
+ */
+static void nspng_redraw_rows(nspng_content *png_c)
+{
+	union content_msg_data data;
+
+	if ((png_c->bitmap == NULL) ||
+	    (png_c->redraw_y1 <= png_c->redraw_y0)) {
+		return;
+	}
+
+	guit->bitmap->modified(png_c->bitmap);
+
+	data.redraw.x = 0;
+	data.redraw.y = png_c->redraw_y0;
+	data.redraw.width = png_c->base.width;
+	data.redraw.height = png_c->redraw_y1 - png_c->redraw_y0;
+
+	png_c->redraw_y0 = png_c->base.height;
+	png_c->redraw_y1 = 0;
+
+	content_broadcast(&png_c->base, CONTENT_MSG_REDRAW, &data);
+}
+
 static bool nspng_process_data(struct content *c, const char *data,
 			       unsigned int size)
 {
@@ -327,6 +389,7 @@ static bool nspng_process_data(struct content *c, const char *data,
 	switch (setjmp(png_jmpbuf(png_c->png))) {
 	case CBERR_NONE: /* direct return */	
 		png_process_data(png_c->png, png_c->info, (uint8_t *)data, size);
+		nspng_redraw_rows(png_c);
 		break;
 
 	case CBERR_NOPRE: /* not going to progressive convert */
@@ -395,123 +458,341 @@ png_cache_read_fn(png_structp png_ptr, png_bytep data, png_size_t length)
 	png_cache_read_data->size -= length;
 }
 
-/** calculate an array of row pointers into a bitmap data area
+/**
+ * State of a png conversion which may be performed in bands of rows
  */
-static png_bytep *calc_row_pointers(struct bitmap *bitmap)
+struct nspng_band {
+	png_structp png_ptr; /**< png read structure */
+	png_infop info_ptr; /**< png info structure */
+	png_infop end_info_ptr; /**< png end info structure */
+	struct png_cache_read_data_s read_data; /**< remaining source data */
+	struct bitmap *bitmap; /**< bitmap being converted into */
+	unsigned char *pixels; /**< bitmap buffer */
+	size_t rowstride; /**< bitmap row stride */
+	png_uint_32 width; /**< width of the image */
+	png_uint_32 height; /**< height of the image */
+	png_uint_32 rows; /**< number of rows to read over all passes */
+	png_uint_32 row; /**< number of rows read so far */
+	unsigned int factor; /**< factor the image is reduced by */
+	png_bytep reduce_row; /**< image row when reducing */
+	uint32_t *sums; /**< four sums per bitmap pixel when reducing */
+	unsigned int summed; /**< image rows added to the sums */
+};
+
+/**
+ * Number of rows decoded between checks of the time taken by a band
+ */
+#define PNG_BAND_CHECK_ROWS 16
+
+/**
+ * Decode a row of a non interlaced PNG reduced by an integer factor.
+ *
+ * Each bitmap pixel is the alpha weighted average of a factor by factor
+ * block of image pixels so only one image row and one row of sums are
+ * held while decoding. A bitmap row is written once the last image
+ * row of its block has been added.
+ *
+ * \param band The conversion state.
+ */
+static void png_read_reduced_row(struct nspng_band *band)
 {
-	int height = guit->bitmap->get_height(bitmap);
-	unsigned char *buffer= guit->bitmap->get_buffer(bitmap);
-	size_t rowstride = guit->bitmap->get_rowstride(bitmap);
-	png_bytep *row_ptrs;
-	int hloop;
+	unsigned int factor = band->factor;
+	png_uint_32 width = band->width;
+	png_uint_32 out_width = (width + factor - 1) / factor;
+	png_uint_32 y = band->row;
+	png_uint_32 x;
+	unsigned int count;
+	uint32_t *sum;
+	png_bytep pixel;
+	unsigned char *out;
+
+	png_read_row(band->png_ptr, band->reduce_row, NULL);
+
+	for (x = 0; x < width; x++) {
+		pixel = band->reduce_row + (x * 4);
+		sum = band->sums + ((x / factor) * 4);
+		sum[0] += pixel[0] * pixel[3];
+		sum[1] += pixel[1] * pixel[3];
+		sum[2] += pixel[2] * pixel[3];
+		sum[3] += pixel[3];
+	}
+
+	band->summed++;
+	if ((band->summed < factor) && (y != band->height - 1)) {
+		return;
+	}
 
-	/* The buffer allocation may occour when the buffer is aquired
-	 * and therefore may fail.
-	 */
-	if (buffer == NULL) {
-		return NULL;
+	/* emit a bitmap row from the completed block of sums */
+	out = band->pixels + (band->rowstride * (y / factor));
+	for (x = 0; x < out_width; x++) {
+		sum = band->sums + (x * 4);
+		count = band->summed * min(factor, width - (x * factor));
+		if (sum[3] == 0) {
+			out[0] = out[1] = out[2] = out[3] = 0;
+		} else {
+			out[0] = sum[0] / sum[3];
+			out[1] = sum[1] / sum[3];
+			out[2] = sum[2] / sum[3];
+			out[3] = sum[3] / count;
+		}
+		out += 4;
 	}
 
-	row_ptrs = malloc(sizeof(png_bytep) * height);
+	memset(band->sums, 0, out_width * 4 * sizeof(uint32_t));
+	band->summed = 0;
+}
 
-	if (row_ptrs != NULL) {
-		for (hloop = 0; hloop < height; hloop++) {
-			row_ptrs[hloop] = buffer + (rowstride * hloop);
-		}
+/**
+ * Abandon converting png content into a bitmap.
+ *
+ * \param band The conversion state which is freed.
+ */
+static void nspng_band_destroy(struct nspng_band *band)
+{
+	png_destroy_read_struct(&band->png_ptr,
+				&band->info_ptr,
+				&band->end_info_ptr);
+
+	if (band->bitmap != NULL) {
+		guit->bitmap->destroy(band->bitmap);
 	}
 
-	return row_ptrs;
+	free(band->reduce_row);
+	free(band->sums);
+	free(band);
 }
 
-/** PNG content to bitmap conversion.
+/**
+ * Begin converting png content into a bitmap.
  *
- * This routine generates a bitmap object from a PNG image content
+ * \param c The png content.
+ * \return The conversion state or NULL on error.
  */
-static struct bitmap *
-png_cache_convert(struct content *c)
+static struct nspng_band *nspng_band_create(struct content *c)
 {
-	png_structp png_ptr;
-	png_infop info_ptr;
-	png_infop end_info_ptr;
-	volatile struct bitmap * volatile bitmap = NULL;
-	struct png_cache_read_data_s png_cache_read_data;
-	png_uint_32 width, height;
-	volatile png_bytep * volatile row_pointers = NULL;
+	struct nspng_band *band;
+	int display_width, display_height;
+	int passes = 1;
 
-	png_cache_read_data.data = 
-		content__get_source_data(c, &png_cache_read_data.size);
+	band = calloc(1, sizeof(struct nspng_band));
+	if (band == NULL) {
+		return NULL;
+	}
+
+	band->factor = 1;
+	band->read_data.data =
+		content__get_source_data(c, &band->read_data.size);
 
-	if ((png_cache_read_data.data == NULL) || 
-	    (png_cache_read_data.size <= 8)) {
+	if ((band->read_data.data == NULL) ||
+	    (band->read_data.size <= 8)) {
+		free(band);
 		return NULL;
 	}
 
-	png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL,
+	band->png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL,
 			nspng_error, nspng_warning);
-	if (png_ptr == NULL) {
+	if (band->png_ptr == NULL) {
+		free(band);
 		return NULL;
 	}
 
-	info_ptr = png_create_info_struct(png_ptr);
-	if (info_ptr == NULL) {
-		png_destroy_read_struct(&png_ptr, NULL, NULL);
+	band->info_ptr = png_create_info_struct(band->png_ptr);
+	if (band->info_ptr == NULL) {
+		nspng_band_destroy(band);
 		return NULL;
 	}
 
-	end_info_ptr = png_create_info_struct(png_ptr);
-	if (end_info_ptr == NULL) {
-		png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+	band->end_info_ptr = png_create_info_struct(band->png_ptr);
+	if (band->end_info_ptr == NULL) {
+		nspng_band_destroy(band);
 		return NULL;
 	}
 
 	/* setup error exit path */
-	if (setjmp(png_jmpbuf(png_ptr))) {
+	if (setjmp(png_jmpbuf(band->png_ptr))) {
 		/* cleanup and bail */
-		goto png_cache_convert_error;
+		nspng_band_destroy(band);
+		return NULL;
 	}
 
 	/* read from a buffer instead of stdio */
-	png_set_read_fn(png_ptr, &png_cache_read_data, png_cache_read_fn);
+	png_set_read_fn(band->png_ptr, &band->read_data, png_cache_read_fn);
 
 	/* ensure the png info structure is populated */
-	png_read_info(png_ptr, info_ptr);
+	png_read_info(band->png_ptr, band->info_ptr);
+
+	band->width = png_get_image_width(band->png_ptr, band->info_ptr);
+	band->height = png_get_image_height(band->png_ptr, band->info_ptr);
+
+	/* Images plotted at a fraction of their size are reduced while
+	 * they are decoded. Interlaced images are not as their passes
+	 * would have to be assembled at full size first.
+	 */
+	image_cache_display_size(c, &display_width, &display_height);
+	if ((display_width > 0) &&
+	    (display_height > 0) &&
+	    (png_get_interlace_type(band->png_ptr, band->info_ptr) ==
+	     PNG_INTERLACE_NONE)) {
+		band->factor = min(band->width / (unsigned int)display_width,
+				   band->height / (unsigned int)display_height);
+		band->factor = min(band->factor, PNG_REDUCE_MAX);
+		band->factor = max(band->factor, 1U);
+	}
+
+	if (band->factor > 1) {
+		band->reduce_row = malloc(band->width * 4);
+		band->sums = calloc((band->width + band->factor - 1) /
+				    band->factor, 4 * sizeof(uint32_t));
+		if ((band->reduce_row == NULL) || (band->sums == NULL)) {
+			nspng_band_destroy(band);
+			return NULL;
+		}
+	} else {
+		/* libpng expands interlaced rows into the bitmap rows
+		 * once per pass.
+		 */
+		passes = png_set_interlace_handling(band->png_ptr);
+	}
 
 	/* setup output transforms */
-	nspng_setup_transforms(png_ptr, info_ptr);
+	nspng_setup_transforms(band->png_ptr, band->info_ptr);
 
-	width = png_get_image_width(png_ptr, info_ptr);
-	height = png_get_image_height(png_ptr, info_ptr);
+	band->rows = band->height * passes;
 
 	/* Claim the required memory for the converted PNG */
-	bitmap = guit->bitmap->create(width, height, BITMAP_NEW);
-	if (bitmap == NULL) {
-		/* cleanup and bail */
-		goto png_cache_convert_error;
+	band->bitmap = guit->bitmap->create(
+			(band->width + band->factor - 1) / band->factor,
+			(band->height + band->factor - 1) / band->factor,
+			BITMAP_NEW);
+	if (band->bitmap == NULL) {
+		nspng_band_destroy(band);
+		return NULL;
 	}
 
-	row_pointers = calc_row_pointers((struct bitmap *) bitmap);
+	/* The buffer allocation may occour when the buffer is aquired
+	 * and therefore may fail.
+	 */
+	band->pixels = guit->bitmap->get_buffer(band->bitmap);
+	if (band->pixels == NULL) {
+		nspng_band_destroy(band);
+		return NULL;
+	}
 
-	if (row_pointers != NULL) {
-		png_read_image(png_ptr, (png_bytep *) row_pointers);
-	} else {
-		guit->bitmap->destroy((struct bitmap *)bitmap);
-		bitmap = NULL;
+	band->rowstride = guit->bitmap->get_rowstride(band->bitmap);
+
+	return band;
+}
+
+/**
+ * Decode rows from png into the bitmap.
+ *
+ * An error leaves the rest of the bitmap undecoded and the conversion
+ * is finished with the rows decoded so far.
+ *
+ * \param band The conversion state.
+ * \param ms The time in ms to spend decoding or 0 to decode every row.
+ * \return true if the conversion is finished else false.
+ */
+static bool nspng_band_read(struct nspng_band *band, unsigned int ms)
+{
+	unsigned int rows = 0;
+	uint64_t ms_start;
+	uint64_t ms_now;
+
+	nsu_getmonotonic_ms(&ms_start);
+
+	if (setjmp(png_jmpbuf(band->png_ptr))) {
+		return true;
 	}
 
-png_cache_convert_error:
+	while (band->row != band->rows) {
+		if (band->factor > 1) {
+			png_read_reduced_row(band);
+		} else {
+			png_read_row(band->png_ptr,
+				     band->pixels + band->rowstride *
+				     (band->row % band->height),
+				     NULL);
+		}
+		band->row++;
+
+		if ((ms != 0) && ((++rows % PNG_BAND_CHECK_ROWS) == 0)) {
+			nsu_getmonotonic_ms(&ms_now);
+			if ((ms_now - ms_start) >= ms) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Finish converting png content into a bitmap.
+ *
+ * \param band The conversion state which is freed.
+ * \return The converted bitmap.
+ */
+static struct bitmap *nspng_band_finish(struct nspng_band *band)
+{
+	struct bitmap *bitmap = band->bitmap;
+
+	guit->bitmap->modified(bitmap);
+
+	band->bitmap = NULL;
+	nspng_band_destroy(band);
 
-	/* cleanup png read */
-	png_destroy_read_struct(&png_ptr, &info_ptr, &end_info_ptr);
+	return bitmap;
+}
 
-	if (row_pointers != NULL) {
-		free((png_bytep *) row_pointers);
+/** PNG content to bitmap conversion.
+ *
+ * This routine generates a bitmap object from a PNG image content
+ */
+static struct bitmap *
+png_cache_convert(struct content *c)
+{
+	nspng_content *png_c = (nspng_content *)c;
+	struct nspng_band *band;
+
+	if (png_c->band != NULL) {
+		/* conversion in bands is superseded */
+		nspng_band_destroy(png_c->band);
+		png_c->band = NULL;
 	}
 
-	if (bitmap != NULL) {
-		guit->bitmap->modified((struct bitmap *)bitmap);
+	band = nspng_band_create(c);
+	if (band == NULL) {
+		return NULL;
 	}
 
-	return (struct bitmap *)bitmap;
+	nspng_band_read(band, 0);
+
+	return nspng_band_finish(band);
+}
+
+/** PNG content to bitmap conversion a band of rows at a time.
+ */
+static nserror
+png_cache_band(struct content *c, unsigned int ms, struct bitmap **bitmap_out)
+{
+	nspng_content *png_c = (nspng_content *)c;
+
+	if (png_c->band == NULL) {
+		png_c->band = nspng_band_create(c);
+		if (png_c->band == NULL) {
+			return NSERROR_INVALID;
+		}
+	}
+
+	if (nspng_band_read(png_c->band, ms) == false) {
+		return NSERROR_NEED_DATA;
+	}
+
+	*bitmap_out = nspng_band_finish(png_c->band);
+	png_c->band = NULL;
+
+	return NSERROR_OK;
 }
 
 static bool nspng_convert(struct content *c)
@@ -540,6 +821,10 @@ static bool nspng_convert(struct content *c)
 	}
 
 	image_cache_add(c, png_c->bitmap, png_cache_convert);
+	image_cache_set_band(c, png_cache_band);
+
+	/* the bitmap is now owned by the image cache */
+	png_c->bitmap = NULL;
 
 	content_set_ready(c);
 	content_set_done(c);
@@ -549,6 +834,47 @@ static bool nspng_convert(struct content *c)
 }
 
 
+/**
+ * Plot the rows decoded so far while the content is loading.
+ */
+static bool
+nspng_redraw(struct content *c,
+	     struct content_redraw_data *data,
+	     const struct rect *clip,
+	     const struct redraw_context *ctx)
+{
+	nspng_content *png_c = (nspng_content *)c;
+
+	if (c->status == CONTENT_STATUS_LOADING) {
+		if (png_c->bitmap == NULL) {
+			return true;
+		}
+		return image_bitmap_plot(png_c->bitmap, data, clip, ctx);
+	}
+
+	return image_cache_redraw(c, data, clip, ctx);
+}
+
+static void nspng_destroy(struct content *c)
+{
+	nspng_content *png_c = (nspng_content *)c;
+
+	if (png_c->png != NULL) {
+		png_destroy_read_struct(&png_c->png, &png_c->info, 0);
+	}
+
+	if (png_c->bitmap != NULL) {
+		/* destroyed before conversion completed */
+		guit->bitmap->destroy(png_c->bitmap);
+	}
+
+	if (png_c->band != NULL) {
+		nspng_band_destroy(png_c->band);
+	}
+
+	image_cache_destroy(c);
+}
+
 static nserror nspng_clone(const struct content *old_c, struct content **new_c)
 {
 	nspng_content *clone_png_c;
@@ -599,8 +925,8 @@ static const content_handler nspng_content_handler = {
 	.process_data = nspng_process_data,
 	.data_complete = nspng_convert,
 	.clone = nspng_clone,
-	.destroy = image_cache_destroy,
-	.redraw = image_cache_redraw,
+	.destroy = nspng_destroy,
+	.redraw = nspng_redraw,
 	.get_internal = image_cache_get_internal,
 	.type = image_cache_content_type,
 	.is_opaque = image_cache_is_opaque,
@@ -19,6 +19,12 @@
 /**
  * \file
  * implementation of content for image/svg using libsvgtiny.
+ *
+ * Interactive redraws plot the diagram from a bitmap it has been
+ * rasterised into at the size it is plotted, which avoids issuing
+ * every path to the plotters each time. The bitmap is held in the image
+ * cache, which may discard it to reclaim memory. Other redraws, such as
+ * printing, plot the diagram as vectors.
  */
 
 #include <assert.h>
@@ -32,12 +38,24 @@
 #include "utils/utils.h"
 #include "utils/nsurl.h"
 #include "netsurf/plotters.h"
+#include "netsurf/bitmap.h"
 #include "netsurf/content.h"
 #include "content/content_protected.h"
 #include "content/content_factory.h"
+#include "desktop/gui_internal.h"
 
+#include "image/image_cache.h"
+#include "image/svg_raster.h"
 #include "image/svg.h"
 
+/** Largest area in pixels a diagram is plotted from a bitmap at */
+#define SVG_RASTER_AREA_MAX (1024 * 1024)
+
+#define BGR(c) ((c) == svgtiny_TRANSPARENT ? NS_TRANSPARENT :		\
+		((svgtiny_RED((c))) |					\
+		 (svgtiny_GREEN((c)) << 8) |				\
+		 (svgtiny_BLUE((c)) << 16)))
+
 typedef struct svg_content {
 	struct content base;
 
@@ -45,6 +63,9 @@ typedef struct svg_content {
 
 	int current_width;
 	int current_height;
+
+	bool cached; /**< Diagram is in the image cache */
+	bool cache_failed; /**< Diagram failed to be rasterised */
 } svg_content;
 
 
@@ -121,6 +142,132 @@ static bool svg_convert(struct content *c)
 	return true;
 }
 
+/**
+ * Rasterise a CONTENT_SVG into a bitmap for the image cache.
+ *
+ * The diagram is rasterised at the size the image cache requires.
+ */
+
+static struct bitmap *svg_cache_convert(struct content *c)
+{
+	svg_content *svg = (svg_content *) c;
+	struct svgtiny_diagram *diagram = svg->diagram;
+	struct svgtiny_shape *shape;
+	struct svg_raster *r;
+	struct bitmap *bitmap;
+	uint8_t *pixels;
+	size_t rowstride;
+	float transform[6];
+	int width, height, y;
+	unsigned int i;
+	nserror res;
+
+	image_cache_display_size(c, &width, &height);
+	if ((width <= 0) || (height <= 0) || (c->width <= 0) || (c->height <= 0))
+		goto failed;
+
+	if ((int64_t) width * height > SVG_RASTER_AREA_MAX) {
+		/* plotted as vectors at this size */
+		return NULL;
+	}
+
+	bitmap = guit->bitmap->create(width, height, BITMAP_NEW);
+	if (bitmap == NULL)
+		goto failed;
+
+	pixels = guit->bitmap->get_buffer(bitmap);
+	rowstride = guit->bitmap->get_rowstride(bitmap);
+	if (pixels == NULL)
+		goto failed_bitmap;
+
+	for (y = 0; y < height; y++) {
+		memset(pixels + (y * rowstride), 0, width * 4);
+	}
+
+	res = svg_raster_create(width, height, pixels, rowstride, &r);
+	if (res != NSERROR_OK)
+		goto failed_bitmap;
+
+	transform[0] = (float) width / (float) c->width;
+	transform[1] = 0;
+	transform[2] = 0;
+	transform[3] = (float) height / (float) c->height;
+	transform[4] = 0;
+	transform[5] = 0;
+
+	for (i = 0; i != diagram->shape_count; i++) {
+		shape = &diagram->shape[i];
+
+		if (shape->path == NULL)
+			continue;
+
+		if (shape->fill != svgtiny_TRANSPARENT) {
+			if (!svg_raster_path(r, shape->path,
+					shape->path_length, transform, 0))
+				break;
+			svg_raster_composite(r, BGR(shape->fill));
+		}
+
+		if (shape->stroke != svgtiny_TRANSPARENT) {
+			/* stroke width is in pixels as for the plotters */
+			if (!svg_raster_path(r, shape->path,
+					shape->path_length, transform,
+					(shape->stroke_width == 0) ? 1 :
+					shape->stroke_width))
+				break;
+			svg_raster_composite(r, BGR(shape->stroke));
+		}
+	}
+
+	svg_raster_destroy(r);
+
+	if (i != diagram->shape_count)
+		goto failed_bitmap;
+
+	guit->bitmap->modified(bitmap);
+
+	return bitmap;
+
+failed_bitmap:
+	guit->bitmap->destroy(bitmap);
+failed:
+	/* plot as vectors until the diagram changes */
+	svg->cache_failed = true;
+	return NULL;
+}
+
+
+/**
+ * Update the image cache entry of a CONTENT_SVG for its diagram.
+ *
+ * Diagrams containing text are not cached as the text is plotted with
+ * the browser's fonts.
+ */
+
+static void svg_cache_update(svg_content *svg)
+{
+	struct content *c = &svg->base;
+	unsigned int i;
+
+	if (svg->cached) {
+		image_cache_remove(c);
+		svg->cached = false;
+	}
+	svg->cache_failed = false;
+
+	for (i = 0; i != svg->diagram->shape_count; i++) {
+		if (svg->diagram->shape[i].text)
+			return;
+	}
+
+	if (image_cache_add(c, NULL, svg_cache_convert) != NSERROR_OK)
+		return;
+
+	image_cache_set_vector(c);
+	svg->cached = true;
+}
+
+
 /**
  * Reformat a CONTENT_SVG.
  */
@@ -146,6 +293,12 @@ static void svg_reformat(struct content *c, int width, int height)
 
 		svg->current_width = width;
 		svg->current_height = height;
+
+		c->width = svg->diagram->width;
+		c->height = svg->diagram->height;
+
+		/* the diagram may have changed */
+		svg_cache_update(svg);
 	}
 
 	c->width = svg->diagram->width;
@@ -186,11 +339,6 @@ svg_redraw_internal(struct content *c,
 	transform[4] = x;
 	transform[5] = y;
 
-#define BGR(c) ((c) == svgtiny_TRANSPARENT ? NS_TRANSPARENT :		\
-		((svgtiny_RED((c))) |					\
-		 (svgtiny_GREEN((c)) << 8) |				\
-		 (svgtiny_BLUE((c)) << 16)))
-
 	for (i = 0; i != diagram->shape_count; i++) {
 		if (diagram->shape[i].path) {
 			pstyle.stroke_width = plot_style_int_to_fixed(
@@ -229,8 +377,6 @@ svg_redraw_internal(struct content *c,
 		}
 	}
 
-#undef BGR
-
 	return true;
 }
 
@@ -242,6 +388,7 @@ svg_redraw_internal(struct content *c,
 static bool svg_redraw(struct content *c, struct content_redraw_data *data,
 		const struct rect *clip, const struct redraw_context *ctx)
 {
+	svg_content *svg = (svg_content *) c;
 	int x = data->x;
 	int y = data->y;
 
@@ -251,6 +398,21 @@ static bool svg_redraw(struct content *c, struct content_redraw_data *data,
 		return true;
 	}
 
+	if (svg->cached && !svg->cache_failed && ctx->interactive &&
+	    ((int64_t) data->width * data->height <= SVG_RASTER_AREA_MAX)) {
+		if (image_cache_find_bitmap(c) != NULL) {
+			/* Plot the rasterised diagram, which the cache
+			 * converts again if it is plotted larger.
+			 */
+			return image_cache_redraw(c, data, clip, ctx);
+		}
+
+		/* Queue the diagram to be rasterised and plot it as
+		 * vectors meanwhile.
+		 */
+		image_cache_redraw(c, data, clip, ctx);
+	}
+
 	if ((data->repeat_x == false) && (data->repeat_y == false)) {
 		/* Simple case: SVG is not tiled */
 		return svg_redraw_internal(c, x, y,
@@ -303,6 +465,9 @@ static void svg_destroy(struct content *c)
 {
 	svg_content *svg = (svg_content *) c;
 
+	if (svg->cached)
+		image_cache_destroy(c);
+
 	if (svg->diagram != NULL)
 		svgtiny_free(svg->diagram);
 }
@@ -0,0 +1,428 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Path rasteriser implementation.
+ *
+ * Each line of an outline adds the signed area to its right to an
+ * accumulation cell per pixel, split between the cells the line crosses
+ * in proportion to the area of each pixel it covers. A running sum
+ * along a row then gives the winding weighted coverage of each pixel.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "utils/errors.h"
+#include "utils/utils.h"
+#include "netsurf/plotters.h"
+
+#include "image/svg_raster.h"
+
+/** Largest number of lines a bezier curve is flattened into */
+#define SVG_RASTER_BEZIER_LINES_MAX 32
+
+/**
+ * Rasteriser state.
+ */
+struct svg_raster {
+	int width; /**< Width of the raster in pixels */
+	int height; /**< Height of the raster in pixels */
+	float *acc; /**< Area accumulation, width + 2 cells per row */
+	int y0; /**< First row with accumulated area */
+	int y1; /**< Row after the last with accumulated area */
+
+	uint8_t *pixels; /**< Pixel buffer */
+	size_t rowstride; /**< Pixel buffer row stride */
+
+	float half_width; /**< Half the stroke width, or 0 when filling */
+	bool prev; /**< A stroke segment precedes in the subpath */
+	float prev_nx, prev_ny; /**< Offset to edge of preceding segment */
+	bool first; /**< The first segment of the subpath is known */
+	float first_nx, first_ny; /**< Offset to edge of first segment */
+};
+
+
+/* exported interface documented in image/svg_raster.h */
+nserror svg_raster_create(int width, int height,
+		uint8_t *pixels, size_t rowstride,
+		struct svg_raster **raster_out)
+{
+	struct svg_raster *r;
+
+	if ((width <= 0) || (height <= 0)) {
+		return NSERROR_BAD_SIZE;
+	}
+
+	r = calloc(1, sizeof(struct svg_raster));
+	if (r == NULL) {
+		return NSERROR_NOMEM;
+	}
+
+	r->acc = calloc((size_t)(width + 2) * height, sizeof(float));
+	if (r->acc == NULL) {
+		free(r);
+		return NSERROR_NOMEM;
+	}
+
+	r->width = width;
+	r->height = height;
+	r->y0 = height;
+	r->y1 = 0;
+	r->pixels = pixels;
+	r->rowstride = rowstride;
+
+	*raster_out = r;
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in image/svg_raster.h */
+void svg_raster_destroy(struct svg_raster *r)
+{
+	free(r->acc);
+	free(r);
+}
+
+
+/* exported interface documented in image/svg_raster.h */
+void svg_raster_line(struct svg_raster *r,
+		float x0, float y0, float x1, float y1)
+{
+	float dir = 1.0f;
+	float dxdy, x, xnext, dy, d;
+	float xa, xb, xaf, xbf, s, a, am, a1, a2;
+	float *row;
+	int y, ystart, yend, xai, xbi, xi;
+
+	if (y0 == y1)
+		return;
+
+	if (y0 > y1) {
+		float t;
+		t = x0; x0 = x1; x1 = t;
+		t = y0; y0 = y1; y1 = t;
+		dir = -1.0f;
+	}
+
+	dxdy = (x1 - x0) / (y1 - y0);
+	x = x0;
+	if (y0 < 0) {
+		x -= y0 * dxdy;
+	}
+
+	ystart = max((int) floorf(y0), 0);
+	yend = min((int) ceilf(y1), r->height);
+	if (ystart >= yend)
+		return;
+
+	r->y0 = min(r->y0, ystart);
+	r->y1 = max(r->y1, yend);
+
+	for (y = ystart; y < yend; y++) {
+		row = r->acc + (y * (r->width + 2));
+		dy = fminf(y + 1, y1) - fmaxf(y, y0);
+		xnext = x + (dxdy * dy);
+		d = dy * dir;
+
+		/* area left of the raster covers the first pixel and area
+		 * right of it falls in the spare cells.
+		 */
+		xa = fminf(fmaxf(fminf(x, xnext), 0), r->width);
+		xb = fminf(fmaxf(fmaxf(x, xnext), 0), r->width);
+		xai = (int) floorf(xa);
+		xbi = (int) ceilf(xb);
+
+		if (xbi <= xai + 1) {
+			/* line within one pixel */
+			a = ((xa + xb) * 0.5f) - xai;
+			row[xai] += d - (d * a);
+			row[xai + 1] += d * a;
+		} else {
+			/* line across several pixels */
+			s = 1.0f / (xb - xa);
+			xaf = xa - xai;
+			a = 0.5f * s * (1.0f - xaf) * (1.0f - xaf);
+			xbf = xb - xbi + 1.0f;
+			am = 0.5f * s * xbf * xbf;
+			row[xai] += d * a;
+			if (xbi == xai + 2) {
+				row[xai + 1] += d * (1.0f - a - am);
+			} else {
+				a1 = s * (1.5f - xaf);
+				row[xai + 1] += d * (a1 - a);
+				for (xi = xai + 2; xi < xbi - 1; xi++) {
+					row[xi] += d * s;
+				}
+				a2 = a1 + ((xbi - xai - 3) * s);
+				row[xbi - 1] += d * (1.0f - a2 - am);
+			}
+			row[xbi] += d * am;
+		}
+
+		x = xnext;
+	}
+}
+
+/**
+ * Accumulate a convex polygon into the raster with positive winding.
+ */
+static void svg_raster_polygon(struct svg_raster *r,
+		const float *p, unsigned int n)
+{
+	float area = 0;
+	unsigned int i, j;
+
+	for (i = 0; i != n; i++) {
+		j = (i + 1) % n;
+		area += (p[i * 2] * p[j * 2 + 1]) - (p[j * 2] * p[i * 2 + 1]);
+	}
+
+	for (i = 0; i != n; i++) {
+		j = (i + 1) % n;
+		if (area < 0) {
+			svg_raster_line(r, p[j * 2], p[j * 2 + 1],
+					p[i * 2], p[i * 2 + 1]);
+		} else {
+			svg_raster_line(r, p[i * 2], p[i * 2 + 1],
+					p[j * 2], p[j * 2 + 1]);
+		}
+	}
+}
+
+/**
+ * Accumulate the bevel join of two stroke segments at a point.
+ */
+static void svg_raster_join(struct svg_raster *r, float x, float y,
+		float nx0, float ny0, float nx1, float ny1)
+{
+	float p[6];
+
+	p[0] = x; p[1] = y;
+	p[2] = x + nx0; p[3] = y + ny0;
+	p[4] = x + nx1; p[5] = y + ny1;
+	svg_raster_polygon(r, p, 3);
+
+	p[2] = x - nx0; p[3] = y - ny0;
+	p[4] = x - nx1; p[5] = y - ny1;
+	svg_raster_polygon(r, p, 3);
+}
+
+/**
+ * Accumulate a segment of a path into the raster.
+ *
+ * When filling this is the segment itself, when stroking it is the
+ * area within half the stroke width of the segment, joined to the
+ * preceding segment.
+ */
+static void svg_raster_segment(struct svg_raster *r,
+		float x0, float y0, float x1, float y1)
+{
+	float len, nx, ny;
+	float p[8];
+
+	if (r->half_width == 0) {
+		svg_raster_line(r, x0, y0, x1, y1);
+		return;
+	}
+
+	len = sqrtf(((x1 - x0) * (x1 - x0)) + ((y1 - y0) * (y1 - y0)));
+	if (len == 0)
+		return;
+
+	nx = (y0 - y1) * r->half_width / len;
+	ny = (x1 - x0) * r->half_width / len;
+
+	p[0] = x0 + nx; p[1] = y0 + ny;
+	p[2] = x1 + nx; p[3] = y1 + ny;
+	p[4] = x1 - nx; p[5] = y1 - ny;
+	p[6] = x0 - nx; p[7] = y0 - ny;
+	svg_raster_polygon(r, p, 4);
+
+	if (r->prev) {
+		svg_raster_join(r, x0, y0, r->prev_nx, r->prev_ny, nx, ny);
+	}
+	if (r->first == false) {
+		r->first = true;
+		r->first_nx = nx;
+		r->first_ny = ny;
+	}
+	r->prev = true;
+	r->prev_nx = nx;
+	r->prev_ny = ny;
+}
+
+/* exported interface documented in image/svg_raster.h */
+bool svg_raster_path(struct svg_raster *r,
+		const float *p, unsigned int n, const float transform[6],
+		float stroke_width)
+{
+	float x = 0, y = 0; /* current point */
+	float sx = 0, sy = 0; /* subpath start */
+	float px[4], py[4];
+	float t, u, nx, ny;
+	unsigned int i = 0, j, k, lines;
+
+	r->half_width = stroke_width / 2;
+	r->prev = false;
+	r->first = false;
+
+#define TX(x, y) ((transform[0] * (x)) + (transform[2] * (y)) + transform[4])
+#define TY(x, y) ((transform[1] * (x)) + (transform[3] * (y)) + transform[5])
+
+	while (i < n) {
+		switch ((int) p[i]) {
+		case PLOTTER_PATH_MOVE:
+			if (i + 3 > n)
+				return false;
+			if (r->half_width == 0) {
+				/* fills are implicitly closed */
+				svg_raster_line(r, x, y, sx, sy);
+			}
+			x = sx = TX(p[i + 1], p[i + 2]);
+			y = sy = TY(p[i + 1], p[i + 2]);
+			r->prev = false;
+			r->first = false;
+			i += 3;
+			break;
+
+		case PLOTTER_PATH_CLOSE:
+			svg_raster_segment(r, x, y, sx, sy);
+			if (r->prev && r->first) {
+				svg_raster_join(r, sx, sy,
+						r->prev_nx, r->prev_ny,
+						r->first_nx, r->first_ny);
+			}
+			x = sx;
+			y = sy;
+			r->prev = false;
+			r->first = false;
+			i++;
+			break;
+
+		case PLOTTER_PATH_LINE:
+			if (i + 3 > n)
+				return false;
+			nx = TX(p[i + 1], p[i + 2]);
+			ny = TY(p[i + 1], p[i + 2]);
+			svg_raster_segment(r, x, y, nx, ny);
+			x = nx;
+			y = ny;
+			i += 3;
+			break;
+
+		case PLOTTER_PATH_BEZIER:
+			if (i + 7 > n)
+				return false;
+			px[0] = x;
+			py[0] = y;
+			for (k = 1; k != 4; k++) {
+				px[k] = TX(p[i + (k * 2) - 1], p[i + (k * 2)]);
+				py[k] = TY(p[i + (k * 2) - 1], p[i + (k * 2)]);
+			}
+
+			/* flatten into lines about two pixels long */
+			t = 0;
+			for (k = 0; k != 3; k++) {
+				t += fabsf(px[k + 1] - px[k]) +
+					fabsf(py[k + 1] - py[k]);
+			}
+			lines = min((unsigned int) (t / 2) + 1,
+				    (unsigned int) SVG_RASTER_BEZIER_LINES_MAX);
+
+			for (j = 1; j <= lines; j++) {
+				t = (float) j / lines;
+				u = 1 - t;
+				nx = (u * u * u * px[0]) +
+					(3 * u * u * t * px[1]) +
+					(3 * u * t * t * px[2]) +
+					(t * t * t * px[3]);
+				ny = (u * u * u * py[0]) +
+					(3 * u * u * t * py[1]) +
+					(3 * u * t * t * py[2]) +
+					(t * t * t * py[3]);
+				svg_raster_segment(r, x, y, nx, ny);
+				x = nx;
+				y = ny;
+			}
+			i += 7;
+			break;
+
+		default:
+			return false;
+		}
+	}
+
+	if (r->half_width == 0) {
+		svg_raster_line(r, x, y, sx, sy);
+	}
+
+#undef TX
+#undef TY
+
+	return true;
+}
+
+/* exported interface documented in image/svg_raster.h */
+void svg_raster_composite(struct svg_raster *r, colour c)
+{
+	unsigned int red = c & 0xff;
+	unsigned int green = (c >> 8) & 0xff;
+	unsigned int blue = (c >> 16) & 0xff;
+	unsigned int sa, da, oa, dw;
+	uint8_t *pixel;
+	float *row;
+	float sum;
+	int x, y;
+
+	for (y = r->y0; y < r->y1; y++) {
+		row = r->acc + (y * (r->width + 2));
+		pixel = r->pixels + (y * r->rowstride);
+		sum = 0;
+		for (x = 0; x < r->width; x++, pixel += 4) {
+			sum += row[x];
+			row[x] = 0;
+
+			sa = fminf(fabsf(sum), 1.0f) * 255 + 0.5f;
+			if (sa == 0)
+				continue;
+
+			/* source over destination, neither premultiplied */
+			da = pixel[3];
+			dw = da * (255 - sa);
+			oa = (sa * 255) + dw;
+			pixel[0] = ((red * sa * 255) + (pixel[0] * dw) +
+				    (oa / 2)) / oa;
+			pixel[1] = ((green * sa * 255) + (pixel[1] * dw) +
+				    (oa / 2)) / oa;
+			pixel[2] = ((blue * sa * 255) + (pixel[2] * dw) +
+				    (oa / 2)) / oa;
+			pixel[3] = (oa + 127) / 255;
+		}
+		row[r->width] = 0;
+		row[r->width + 1] = 0;
+	}
+
+	r->y0 = r->height;
+	r->y1 = 0;
+}
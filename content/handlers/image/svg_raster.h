@@ -0,0 +1,109 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Path rasteriser interface.
+ *
+ * Paths in the plotter path format are rasterised with anti-aliasing
+ * into a buffer of pixels in the core RGBA bitmap format. Shapes are
+ * accumulated as signed area per pixel and then composited in a single
+ * colour over the pixels.
+ */
+
+#ifndef NETSURF_IMAGE_SVG_RASTER_H
+#define NETSURF_IMAGE_SVG_RASTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "utils/errors.h"
+#include "netsurf/types.h"
+
+struct svg_raster;
+
+/**
+ * Create a rasteriser over a pixel buffer.
+ *
+ * \param width The width of the buffer in pixels.
+ * \param height The height of the buffer in pixels.
+ * \param pixels The pixel buffer.
+ * \param rowstride The distance between rows of the buffer in bytes.
+ * \param raster_out Updated with the rasteriser on success.
+ * \return NSERROR_OK on success, NSERROR_BAD_SIZE if the size is empty
+ *         or NSERROR_NOMEM on memory exhaustion.
+ */
+nserror svg_raster_create(int width, int height,
+		uint8_t *pixels, size_t rowstride,
+		struct svg_raster **raster_out);
+
+/**
+ * Destroy a rasteriser.
+ *
+ * The pixel buffer is not freed.
+ *
+ * \param r The rasteriser to destroy.
+ */
+void svg_raster_destroy(struct svg_raster *r);
+
+/**
+ * Accumulate the area to the right of a line.
+ *
+ * Lines running down add area and lines running up remove it, so a
+ * closed outline accumulates the area it encloses.
+ *
+ * \param r The rasteriser.
+ * \param x0 The x coordinate of the start of the line.
+ * \param y0 The y coordinate of the start of the line.
+ * \param x1 The x coordinate of the end of the line.
+ * \param y1 The y coordinate of the end of the line.
+ */
+void svg_raster_line(struct svg_raster *r,
+		float x0, float y0, float x1, float y1);
+
+/**
+ * Accumulate a path.
+ *
+ * A filled path has each subpath implicitly closed. A stroked path
+ * covers the area within half the stroke width of each segment, with
+ * bevel joins between segments.
+ *
+ * \param r The rasteriser.
+ * \param p The path in the plotter path format.
+ * \param n The number of elements in the path.
+ * \param transform The transform to apply to the path.
+ * \param stroke_width The stroke width in pixels or 0 to fill the path.
+ * \return true on success or false if the path is invalid.
+ */
+bool svg_raster_path(struct svg_raster *r,
+		const float *p, unsigned int n, const float transform[6],
+		float stroke_width);
+
+/**
+ * Composite a colour through the accumulated coverage over the pixels.
+ *
+ * Coverage follows the non-zero winding rule. The accumulation is
+ * cleared ready for the next shape.
+ *
+ * \param r The rasteriser.
+ * \param c The colour to composite.
+ */
+void svg_raster_composite(struct svg_raster *r, colour c);
+
+#endif
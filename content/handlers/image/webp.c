@@ -91,31 +91,44 @@ webp_cache_convert(struct content *c)
 	const uint8_t *source_data; /* webp source data */
 	size_t source_size; /* length of webp source data */
 	VP8StatusCode webpres;
-	WebPBitstreamFeatures webpfeatures;
+	WebPDecoderConfig config;
+	WebPBitstreamFeatures *webpfeatures = &config.input;
 	unsigned int bmap_flags;
 	uint8_t *pixels = NULL;
-	uint8_t *decoded;
 	size_t rowstride;
 	struct bitmap *bitmap = NULL;
+	int width;
+	int height;
 
 	source_data = content__get_source_data(c, &source_size);
 
-	webpres = WebPGetFeatures(source_data, source_size, &webpfeatures);
+	if (WebPInitDecoderConfig(&config) == 0) {
+		return NULL;
+	}
+
+	webpres = WebPGetFeatures(source_data, source_size, webpfeatures);
 
 	if (webpres != VP8_STATUS_OK) {
 		return NULL;
 	}
 
-	if (webpfeatures.has_alpha == 0) {
+	/* decode at the size the image is plotted at if that is smaller */
+	image_cache_display_size(c, &width, &height);
+	if ((width <= 0) || (height <= 0) ||
+	    (width > webpfeatures->width) ||
+	    (height > webpfeatures->height)) {
+		width = webpfeatures->width;
+		height = webpfeatures->height;
+	}
+
+	if (webpfeatures->has_alpha == 0) {
 		bmap_flags = BITMAP_NEW | BITMAP_OPAQUE;
 	} else {
 		bmap_flags = BITMAP_NEW;
 	}
 
 	/* create bitmap */
-	bitmap = guit->bitmap->create(webpfeatures.width,
-				      webpfeatures.height,
-				      bmap_flags);
+	bitmap = guit->bitmap->create(width, height, bmap_flags);
 	if (bitmap == NULL) {
 		/* empty bitmap could not be created */
 		return NULL;
@@ -130,12 +143,22 @@ webp_cache_convert(struct content *c)
 
 	rowstride = guit->bitmap->get_rowstride(bitmap);
 
-	decoded = WebPDecodeRGBAInto(source_data,
-				     source_size,
-				     pixels,
-				     webpfeatures.width * webpfeatures.height * 4,
-				     rowstride);
-	if (decoded == NULL) {
+	/* decode directly into the bitmap, scaling if required */
+	config.output.colorspace = MODE_RGBA;
+	config.output.is_external_memory = 1;
+	config.output.u.RGBA.rgba = pixels;
+	config.output.u.RGBA.stride = rowstride;
+	config.output.u.RGBA.size = rowstride * height;
+	if ((width != webpfeatures->width) ||
+	    (height != webpfeatures->height)) {
+		config.options.use_scaling = 1;
+		config.options.scaled_width = width;
+		config.options.scaled_height = height;
+	}
+
+	webpres = WebPDecode(source_data, source_size, &config);
+	WebPFreeDecBuffer(&config.output);
+	if (webpres != VP8_STATUS_OK) {
 		/* decode failed */
 		guit->bitmap->destroy(bitmap);
 		return NULL;
@@ -316,6 +316,14 @@ static int loaded_cookie_file_version;
  * shockingly wasteful on memory.
  */
 static struct bloom_filter *url_bloom;
+
+/**
+ * Visit data generation.
+ *
+ * Incremented whenever the visit count of any URL may have changed so
+ * users caching visit state can tell when it needs refreshing.
+ */
+static unsigned int visit_generation;
 /**
  * Size of url filter
  */
@@ -2851,6 +2859,8 @@ void urldb_destroy(void)
 	struct host_part *a, *b;
 	int i;
 
+	visit_generation++;
+
 	/* Clean up search trees */
 	for (i = 0; i < NUM_SEARCH_TREES; i++) {
 		if (search_trees[i] != &empty) {
@@ -2894,6 +2904,8 @@ nserror urldb_load(const char *filename)
 	if (url_bloom == NULL)
 		url_bloom = bloom_create(BLOOM_SIZE);
 
+	visit_generation++;
+
 	fp = fopen(filename, "r");
 	if (!fp) {
 		NSLOG(netsurf, INFO, "Failed to open file '%s' for reading",
@@ -3286,6 +3298,7 @@ nserror urldb_update_url_visit_data(nsurl *url)
 
 	p->urld.last_visit = time(NULL);
 	p->urld.visits++;
+	visit_generation++;
 
 	return NSERROR_OK;
 }
@@ -3304,6 +3317,14 @@ void urldb_reset_url_visit_data(nsurl *url)
 
 	p->urld.last_visit = (time_t)0;
 	p->urld.visits = 0;
+	visit_generation++;
+}
+
+
+/* exported interface documented in content/urldb.h */
+unsigned int urldb_get_visit_generation(void)
+{
+	return visit_generation;
 }
 
 
@@ -254,7 +254,9 @@ nserror browser_window_create_iframes(struct browser_window *bw)
 		/* linking */
 		window->box = cur->box;
 		window->parent = bw;
-		window->box->iframe = window;
+		/* box_iframe() gives iframe boxes their extra data */
+		assert(window->box->extra != NULL);
+		window->box->extra->iframe = window;
 
 		/* iframe dimensions */
 		box_bounds(window->box, &rect);
@@ -311,7 +313,8 @@ nserror browser_window_destroy_iframes(struct browser_window *bw)
 	if (bw->iframes != NULL) {
 		for (i = 0; i < bw->iframe_count; i++) {
 			if (bw->iframes[i].box != NULL) {
-				bw->iframes[i].box->iframe = NULL;
+				assert(bw->iframes[i].box->extra != NULL);
+				bw->iframes[i].box->extra->iframe = NULL;
 				bw->iframes[i].box = NULL;
 			}
 			browser_window_destroy_internal(&bw->iframes[i]);
@@ -117,6 +117,14 @@ NSOPTION_BOOL(foreground_images, true)
 /** Whether to fetch background images */
 NSOPTION_BOOL(background_images, true)
 
+/** Whether to defer fetching every image until it is near the visible
+ * area, not only those with loading="lazy" */
+NSOPTION_BOOL(lazy_images, false)
+
+/** Distance (in px) from the visible area at which deferred images
+ * are fetched */
+NSOPTION_INTEGER(lazy_image_margin, 1250)
+
 /** Whether to animate images */
 NSOPTION_BOOL(animate_images, true)
 
@@ -17,6 +17,7 @@
  */
 
 #include <stdint.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <getopt.h>
 #include <assert.h>
@@ -55,6 +56,7 @@
 #include "framebuffer/fetch.h"
 #include "framebuffer/bitmap.h"
 #include "framebuffer/local_history.h"
+#include "framebuffer/tile_cache.h"
 
 
 #define NSFB_TOOLBAR_DEFAULT_LAYOUT "blfsrutc"
@@ -81,8 +83,19 @@ struct browser_widget_s {
 			    * needs to pan the window.
 			    */
 	int panx, pany; /**< Panning required. */
+
+	struct fb_tile_cache *tiles; /**< Rendered tiles or NULL if disabled */
 };
 
+/**
+ * State of scrolling benchmark.
+ */
+static struct {
+	struct gui_window *gw; /**< window being scrolled or NULL */
+	unsigned int frames; /**< number of frames redrawn */
+	uint64_t start; /**< time benchmark started */
+} fb_scroll_bench;
+
 static struct gui_drag {
 	enum state {
 		GUI_DRAG_NONE,
@@ -376,10 +389,17 @@ fb_redraw(fbtk_widget_t *widget,
 	clip.x1 = bwidget->redraw_box.x1;
 	clip.y1 = bwidget->redraw_box.y1;
 
-	browser_window_redraw(bw,
-			x - bwidget->scrollx,
-			y - bwidget->scrolly,
-			&clip, &ctx);
+	if (bwidget->tiles != NULL) {
+		fb_tile_cache_redraw(bwidget->tiles, bw, nsfb,
+				     x - bwidget->scrollx,
+				     y - bwidget->scrolly,
+				     &clip);
+	} else {
+		browser_window_redraw(bw,
+				      x - bwidget->scrollx,
+				      y - bwidget->scrolly,
+				      &clip, &ctx);
+	}
 
 	if (fbtk_get_caret(widget, &caret_x, &caret_y, &caret_h)) {
 		/* This widget has caret, so render it */
@@ -405,6 +425,38 @@ fb_redraw(fbtk_widget_t *widget,
 	bwidget->redraw_required = false;
 }
 
+/**
+ * Render tiles surrounding the browser widget viewport.
+ *
+ * One tile is rendered per call and the callback rescheduled until
+ * all the tiles surrounding the viewport are valid, allowing input
+ * to be processed between tiles.
+ *
+ * \param p The gui window to render tiles for.
+ */
+static void fb_tile_prerender(void *p)
+{
+	struct gui_window *gw = p;
+	struct browser_widget_s *bwidget = fbtk_get_userpw(gw->browser);
+	int margin = nsoption_int(fb_tile_size);
+	struct rect area;
+
+	if ((bwidget == NULL) ||
+	    (bwidget->tiles == NULL) ||
+	    (browser_window_redraw_ready(gw->bw) == false)) {
+		return;
+	}
+
+	area.x0 = bwidget->scrollx - margin;
+	area.y0 = bwidget->scrolly - margin;
+	area.x1 = bwidget->scrollx + fbtk_get_width(gw->browser) + margin;
+	area.y1 = bwidget->scrolly + fbtk_get_height(gw->browser) + margin;
+
+	if (fb_tile_cache_prerender(bwidget->tiles, gw->bw, &area) == NSERROR_OK) {
+		framebuffer_schedule(0, fb_tile_prerender, gw);
+	}
+}
+
 static int
 fb_browser_window_redraw(fbtk_widget_t *widget, fbtk_callback_info *cbi)
 {
@@ -431,6 +483,11 @@ fb_browser_window_redraw(fbtk_widget_t *widget, fbtk_callback_info *cbi)
 		bwidget->redraw_box.y1 = fbtk_get_height(widget);
 		fb_redraw(widget, bwidget, gw->bw);
 	}
+
+	if (bwidget->tiles != NULL) {
+		framebuffer_schedule(0, fb_tile_prerender, gw);
+	}
+
 	return 0;
 }
 
@@ -445,6 +502,10 @@ static int fb_browser_window_destroy(fbtk_widget_t *widget,
 
 	/* Free private data */
 	browser_widget = fbtk_get_userpw(widget);
+	if (browser_widget->tiles != NULL) {
+		framebuffer_schedule(-1, fb_tile_prerender, cbi->context);
+		fb_tile_cache_destroy(browser_widget->tiles);
+	}
 	free(browser_widget);
 
 	return 0;
@@ -611,6 +672,71 @@ static bool nslog_stream_configure(FILE *fptr)
 	return true;
 }
 
+/**
+ * Start the scrolling benchmark on a window if it is configured.
+ *
+ * \param gw The window which has finished loading.
+ */
+static void fb_scroll_bench_start(struct gui_window *gw)
+{
+	if ((nsoption_int(fb_scroll_benchmark) <= 0) ||
+	    (fb_scroll_bench.gw != NULL)) {
+		return;
+	}
+
+	NSLOG(netsurf, INFO, "Starting scroll benchmark");
+
+	/* start from the top of the document */
+	widget_scroll_y(gw, 0, true);
+
+	fb_scroll_bench.gw = gw;
+	fb_scroll_bench.frames = 0;
+	nsu_getmonotonic_ms(&fb_scroll_bench.start);
+}
+
+/**
+ * Advance the scrolling benchmark by one frame.
+ *
+ * Once the bottom of the document is reached the frame rate is
+ * reported and the browser exits.
+ */
+static void fb_scroll_bench_step(void)
+{
+	struct browser_widget_s *bwidget;
+	uint64_t now;
+	uint64_t elapsed;
+
+	if (fb_scroll_bench.gw == NULL) {
+		return;
+	}
+
+	fb_scroll_bench.frames++;
+
+	widget_scroll_y(fb_scroll_bench.gw,
+			nsoption_int(fb_scroll_benchmark),
+			false);
+
+	bwidget = fbtk_get_userpw(fb_scroll_bench.gw->browser);
+	if (bwidget->pan_required) {
+		return;
+	}
+
+	/* reached the end of the document */
+	nsu_getmonotonic_ms(&now);
+	elapsed = now - fb_scroll_bench.start;
+	if (elapsed == 0) {
+		elapsed = 1;
+	}
+
+	fprintf(stdout, "SCROLLBENCH FRAMES %u TIME %"PRIu64" FPS %.2f\n",
+		fb_scroll_bench.frames,
+		elapsed,
+		(fb_scroll_bench.frames * 1000.0) / elapsed);
+
+	fb_scroll_bench.gw = NULL;
+	fb_complete = true;
+}
+
 static void framebuffer_run(void)
 {
 	nsfb_event_t event;
@@ -635,6 +761,8 @@ static void framebuffer_run(void)
 		}
 
 		fbtk_redraw(fbtk);
+
+		fb_scroll_bench_step();
 	}
 }
 
@@ -1616,6 +1744,17 @@ create_browser_widget(struct gui_window *gw, int toolbar_height, int furniture_w
 	struct browser_widget_s *browser_widget;
 	browser_widget = calloc(1, sizeof(struct browser_widget_s));
 
+	if (nsoption_bool(fb_tile_cache)) {
+		nserror res;
+		res = fb_tile_cache_create(nsoption_int(fb_tile_size),
+				(size_t)nsoption_int(fb_tile_cache_size) * 1024,
+				&browser_widget->tiles);
+		if (res != NSERROR_OK) {
+			NSLOG(netsurf, INFO, "Unable to create tile cache");
+			browser_widget->tiles = NULL;
+		}
+	}
+
 	gw->browser = fbtk_create_user(gw->window,
 				       0,
 				       toolbar_height,
@@ -1849,6 +1988,10 @@ gui_window_create(struct browser_window *bw,
 static void
 gui_window_destroy(struct gui_window *gw)
 {
+	if (fb_scroll_bench.gw == gw) {
+		fb_scroll_bench.gw = NULL;
+	}
+
 	gui_window_remove_from_window_list(gw);
 
 	fbtk_destroy_widget(gw->window);
@@ -1869,6 +2012,10 @@ fb_window_invalidate_area(struct gui_window *g, const struct rect *rect)
 {
 	struct browser_widget_s *bwidget = fbtk_get_userpw(g->browser);
 
+	if (bwidget->tiles != NULL) {
+		fb_tile_cache_invalidate(bwidget->tiles, rect);
+	}
+
 	if (rect != NULL) {
 		fb_queue_redraw(g->browser,
 				rect->x0 - bwidget->scrollx,
@@ -2139,6 +2286,11 @@ gui_window_event(struct gui_window *gw, enum gui_window_event event)
 
 	case GW_EVENT_STOP_THROBBER:
 		gui_window_stop_throbber(gw);
+		fb_scroll_bench_start(gw);
+		break;
+
+	case GW_EVENT_NEW_CONTENT:
+		fb_window_invalidate_area(gw, NULL);
 		break;
 
 	default:
@@ -42,6 +42,17 @@ NSOPTION_STRING(fb_toolbar_layout, NULL)
 /** enable on screen keyboard */
 NSOPTION_BOOL(fb_osk, false)
 
+/***** rendering options *****/
+
+/** render browser window content through a cache of tiles */
+NSOPTION_BOOL(fb_tile_cache, false)
+/** width and height of cached tiles in pixels */
+NSOPTION_INTEGER(fb_tile_size, 256)
+/** size of tile cache in kilobytes */
+NSOPTION_INTEGER(fb_tile_cache_size, 16384)
+/** pixels to scroll each frame when benchmarking, zero disables */
+NSOPTION_INTEGER(fb_scroll_benchmark, 0)
+
 /***** font options *****/
 
 /** render all fonts monochrome */
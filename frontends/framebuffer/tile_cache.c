@@ -0,0 +1,439 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Framebuffer browser window tile cache implementation.
+ *
+ * Tiles are square 32bpp RAM surfaces each covering a fixed area of
+ * the (scaled) document. The cache holds at most a fixed number of
+ * tiles and when full the least recently used tile is reused.
+ *
+ * The number of tiles is small (a few screens worth) so they are kept
+ * in a simple array which is searched linearly.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <assert.h>
+#include <libnsfb.h>
+#include <libnsfb_plot.h>
+
+#include "utils/utils.h"
+#include "utils/log.h"
+#include "netsurf/types.h"
+#include "netsurf/plotters.h"
+#include "netsurf/browser_window.h"
+
+#include "framebuffer/gui.h"
+#include "framebuffer/fbtk.h"
+#include "framebuffer/framebuffer.h"
+#include "framebuffer/tile_cache.h"
+
+/** Minimum number of tiles a cache will hold */
+#define TILE_CACHE_MIN_TILES 4
+
+/**
+ * A single cached tile
+ */
+struct fb_tile {
+	nsfb_t *surface; /**< RAM surface holding the rendered tile */
+	int tx; /**< column of tile in document */
+	int ty; /**< row of tile in document */
+	bool valid; /**< surface contents reflect the document */
+	unsigned int used; /**< cache use stamp for least recently used */
+};
+
+/**
+ * Tile cache
+ */
+struct fb_tile_cache {
+	int tile_size; /**< width and height of tiles in pixels */
+	unsigned int tile_count; /**< number of entries in tiles array */
+	unsigned int stamp; /**< use counter */
+	struct fb_tile *tiles; /**< tile array */
+};
+
+
+/* exported interface documented in framebuffer/tile_cache.h */
+nserror
+fb_tile_cache_create(int tile_size, size_t limit,
+		     struct fb_tile_cache **cache_out)
+{
+	struct fb_tile_cache *cache;
+	size_t tile_bytes;
+
+	if (tile_size <= 0) {
+		return NSERROR_BAD_PARAMETER;
+	}
+
+	cache = calloc(1, sizeof(struct fb_tile_cache));
+	if (cache == NULL) {
+		return NSERROR_NOMEM;
+	}
+
+	tile_bytes = (size_t)tile_size * tile_size * 4;
+
+	cache->tile_size = tile_size;
+	cache->tile_count = limit / tile_bytes;
+	if (cache->tile_count < TILE_CACHE_MIN_TILES) {
+		cache->tile_count = TILE_CACHE_MIN_TILES;
+	}
+
+	cache->tiles = calloc(cache->tile_count, sizeof(struct fb_tile));
+	if (cache->tiles == NULL) {
+		free(cache);
+		return NSERROR_NOMEM;
+	}
+
+	NSLOG(netsurf, INFO, "Tile cache of %u %dx%d tiles",
+	      cache->tile_count, tile_size, tile_size);
+
+	*cache_out = cache;
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in framebuffer/tile_cache.h */
+nserror fb_tile_cache_destroy(struct fb_tile_cache *cache)
+{
+	unsigned int idx;
+
+	for (idx = 0; idx < cache->tile_count; idx++) {
+		if (cache->tiles[idx].surface != NULL) {
+			nsfb_free(cache->tiles[idx].surface);
+		}
+	}
+	free(cache->tiles);
+	free(cache);
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in framebuffer/tile_cache.h */
+nserror
+fb_tile_cache_invalidate(struct fb_tile_cache *cache, const struct rect *rect)
+{
+	unsigned int idx;
+	struct fb_tile *tile;
+	int tx0, ty0;
+
+	for (idx = 0; idx < cache->tile_count; idx++) {
+		tile = &cache->tiles[idx];
+		if (tile->valid == false) {
+			continue;
+		}
+
+		if (rect != NULL) {
+			tx0 = tile->tx * cache->tile_size;
+			ty0 = tile->ty * cache->tile_size;
+			if ((rect->x1 <= tx0) ||
+			    (rect->x0 >= tx0 + cache->tile_size) ||
+			    (rect->y1 <= ty0) ||
+			    (rect->y0 >= ty0 + cache->tile_size)) {
+				/* no overlap with this tile */
+				continue;
+			}
+		}
+
+		tile->valid = false;
+	}
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Find a tile in the cache.
+ *
+ * \param cache The tile cache.
+ * \param tx The tile column.
+ * \param ty The tile row.
+ * \return The tile or NULL if the cache does not hold the tile.
+ */
+static struct fb_tile *
+fb_tile_cache_find(struct fb_tile_cache *cache, int tx, int ty)
+{
+	unsigned int idx;
+	struct fb_tile *tile;
+
+	for (idx = 0; idx < cache->tile_count; idx++) {
+		tile = &cache->tiles[idx];
+		if ((tile->surface != NULL) &&
+		    (tile->tx == tx) &&
+		    (tile->ty == ty)) {
+			return tile;
+		}
+	}
+	return NULL;
+}
+
+
+/**
+ * Obtain a tile entry to render a tile into.
+ *
+ * An unused entry is preferred, otherwise the least recently used
+ * entry is taken.
+ *
+ * \param cache The tile cache.
+ * \param tx The tile column.
+ * \param ty The tile row.
+ * \return The tile or NULL if a surface could not be allocated.
+ */
+static struct fb_tile *
+fb_tile_cache_alloc(struct fb_tile_cache *cache, int tx, int ty)
+{
+	unsigned int idx;
+	struct fb_tile *tile = NULL;
+	unsigned int oldest = UINT_MAX;
+
+	for (idx = 0; idx < cache->tile_count; idx++) {
+		if (cache->tiles[idx].surface == NULL) {
+			tile = &cache->tiles[idx];
+			break;
+		}
+		if (cache->tiles[idx].used <= oldest) {
+			oldest = cache->tiles[idx].used;
+			tile = &cache->tiles[idx];
+		}
+	}
+
+	if (tile->surface == NULL) {
+		tile->surface = nsfb_new(NSFB_SURFACE_RAM);
+		if (tile->surface == NULL) {
+			return NULL;
+		}
+
+		nsfb_set_geometry(tile->surface,
+				  cache->tile_size,
+				  cache->tile_size,
+				  NSFB_FMT_XBGR8888);
+
+		if (nsfb_init(tile->surface) == -1) {
+			nsfb_free(tile->surface);
+			tile->surface = NULL;
+			return NULL;
+		}
+	}
+
+	tile->tx = tx;
+	tile->ty = ty;
+	tile->valid = false;
+
+	return tile;
+}
+
+
+/**
+ * Render the document area covered by a tile into its surface.
+ *
+ * \param cache The tile cache.
+ * \param tile The tile to render.
+ * \param bw The browser window to render.
+ */
+static void
+fb_tile_render(struct fb_tile_cache *cache,
+	       struct fb_tile *tile,
+	       struct browser_window *bw)
+{
+	nsfb_t *current;
+	struct rect clip;
+	nsfb_bbox_t box;
+	struct redraw_context ctx = {
+		.interactive = true,
+		.background_images = true,
+		.plot = &fb_plotters
+	};
+
+	clip.x0 = 0;
+	clip.y0 = 0;
+	clip.x1 = cache->tile_size;
+	clip.y1 = cache->tile_size;
+
+	/* the surface may be reused from another tile and the redraw
+	 * need not plot every pixel so clear it first. The plotters
+	 * leave the surface clipped to whatever they last drew.
+	 */
+	box.x0 = 0;
+	box.y0 = 0;
+	box.x1 = cache->tile_size;
+	box.y1 = cache->tile_size;
+	nsfb_plot_set_clip(tile->surface, &box);
+	nsfb_plot_clg(tile->surface, 0xffffffff);
+
+	current = framebuffer_set_surface(tile->surface);
+
+	browser_window_redraw(bw,
+			      -(tile->tx * cache->tile_size),
+			      -(tile->ty * cache->tile_size),
+			      &clip, &ctx);
+
+	framebuffer_set_surface(current);
+
+	tile->valid = true;
+}
+
+
+/**
+ * Get a valid tile, rendering it if required.
+ *
+ * \param cache The tile cache.
+ * \param bw The browser window to render.
+ * \param tx The tile column.
+ * \param ty The tile row.
+ * \return The tile or NULL if a surface could not be allocated.
+ */
+static struct fb_tile *
+fb_tile_cache_get(struct fb_tile_cache *cache,
+		  struct browser_window *bw,
+		  int tx, int ty)
+{
+	struct fb_tile *tile;
+
+	tile = fb_tile_cache_find(cache, tx, ty);
+	if (tile == NULL) {
+		tile = fb_tile_cache_alloc(cache, tx, ty);
+		if (tile == NULL) {
+			return NULL;
+		}
+	}
+
+	if (tile->valid == false) {
+		fb_tile_render(cache, tile, bw);
+	}
+
+	tile->used = cache->stamp++;
+
+	return tile;
+}
+
+
+/* exported interface documented in framebuffer/tile_cache.h */
+nserror
+fb_tile_cache_redraw(struct fb_tile_cache *cache,
+		     struct browser_window *bw,
+		     nsfb_t *nsfb,
+		     int x, int y,
+		     const struct rect *clip)
+{
+	int tx, ty;
+	int tx0, ty0, tx1, ty1;
+	struct fb_tile *tile;
+	nsfb_bbox_t saved_clip;
+	nsfb_bbox_t tilebox;
+	nsfb_bbox_t dstbox;
+	int ts = cache->tile_size;
+	nserror res = NSERROR_OK;
+
+	/* convert the clip area into a range of tiles, the document
+	 * origin is never negative so tiles start at zero.
+	 */
+	tx0 = max(clip->x0 - x, 0) / ts;
+	ty0 = max(clip->y0 - y, 0) / ts;
+	tx1 = (clip->x1 - x + ts - 1) / ts;
+	ty1 = (clip->y1 - y + ts - 1) / ts;
+
+	nsfb_plot_get_clip(nsfb, &saved_clip);
+
+	for (ty = ty0; ty < ty1; ty++) {
+		for (tx = tx0; tx < tx1; tx++) {
+			tile = fb_tile_cache_get(cache, bw, tx, ty);
+			if (tile == NULL) {
+				res = NSERROR_NOMEM;
+				goto out;
+			}
+
+			/* area of tile on target surface clipped */
+			dstbox.x0 = max(x + (tx * ts), clip->x0);
+			dstbox.y0 = max(y + (ty * ts), clip->y0);
+			dstbox.x1 = min(x + ((tx + 1) * ts), clip->x1);
+			dstbox.y1 = min(y + ((ty + 1) * ts), clip->y1);
+
+			if ((dstbox.x1 <= dstbox.x0) ||
+			    (dstbox.y1 <= dstbox.y0)) {
+				continue;
+			}
+
+			/* Copying between surfaces ignores the source box
+			 * and scales the whole source into the destination
+			 * box, so the whole tile is copied unscaled with
+			 * the target clipped to the area required.
+			 */
+			tilebox.x0 = x + (tx * ts);
+			tilebox.y0 = y + (ty * ts);
+			tilebox.x1 = tilebox.x0 + ts;
+			tilebox.y1 = tilebox.y0 + ts;
+
+			nsfb_plot_set_clip(nsfb, &dstbox);
+			nsfb_plot_copy(tile->surface, NULL, nsfb, &tilebox);
+		}
+	}
+
+out:
+	nsfb_plot_set_clip(nsfb, &saved_clip);
+
+	return res;
+}
+
+
+/* exported interface documented in framebuffer/tile_cache.h */
+nserror
+fb_tile_cache_prerender(struct fb_tile_cache *cache,
+			struct browser_window *bw,
+			const struct rect *area)
+{
+	int tx, ty;
+	int tx0, ty0, tx1, ty1;
+	struct fb_tile *tile;
+	int ts = cache->tile_size;
+
+	tx0 = max(area->x0, 0) / ts;
+	ty0 = max(area->y0, 0) / ts;
+	tx1 = (area->x1 + ts - 1) / ts;
+	ty1 = (area->y1 + ts - 1) / ts;
+
+	/* never prerender more tiles than the cache can hold or
+	 * tiles would be evicted only to be rendered again.
+	 */
+	if ((unsigned int)((tx1 - tx0) * (ty1 - ty0)) > cache->tile_count) {
+		return NSERROR_NOT_FOUND;
+	}
+
+	for (ty = ty0; ty < ty1; ty++) {
+		for (tx = tx0; tx < tx1; tx++) {
+			tile = fb_tile_cache_find(cache, tx, ty);
+			if ((tile != NULL) && (tile->valid)) {
+				/* keep tiles in the area from being evicted */
+				tile->used = cache->stamp++;
+				continue;
+			}
+
+			tile = fb_tile_cache_get(cache, bw, tx, ty);
+			if (tile == NULL) {
+				return NSERROR_NOMEM;
+			}
+			return NSERROR_OK;
+		}
+	}
+
+	return NSERROR_NOT_FOUND;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Interface to framebuffer browser window tile cache.
+ *
+ * Page content is rasterised into fixed size RAM surfaces indexed by
+ * document co-ordinates. Redraws and pans of the browser widget then
+ * become copies from the tiles instead of core redraws.
+ */
+
+#ifndef FB_TILE_CACHE_H
+#define FB_TILE_CACHE_H
+
+struct browser_window;
+struct rect;
+struct fb_tile_cache;
+
+/**
+ * Create a tile cache.
+ *
+ * \param tile_size The width and height of each tile in pixels.
+ * \param limit The maximum memory to use for tiles in bytes.
+ * \param cache_out Updated with the new cache on success.
+ * \return NSERROR_OK on success else appropriate error code on faliure.
+ */
+nserror fb_tile_cache_create(int tile_size, size_t limit,
+		struct fb_tile_cache **cache_out);
+
+/**
+ * Destroy a tile cache and release all its tiles.
+ *
+ * \param cache The cache to destroy.
+ * \return NSERROR_OK on success else appropriate error code on faliure.
+ */
+nserror fb_tile_cache_destroy(struct fb_tile_cache *cache);
+
+/**
+ * Invalidate tiles.
+ *
+ * \param cache The cache to invalidate tiles in.
+ * \param rect Area in document co-ordinates or NULL to invalidate all tiles.
+ * \return NSERROR_OK on success else appropriate error code on faliure.
+ */
+nserror fb_tile_cache_invalidate(struct fb_tile_cache *cache,
+		const struct rect *rect);
+
+/**
+ * Redraw an area of a browser window from the tile cache.
+ *
+ * Any tiles covering the area which are missing or invalid are
+ * rendered before being copied to the target surface.
+ *
+ * \param cache The cache to redraw from.
+ * \param bw The browser window being redrawn.
+ * \param nsfb The surface to redraw onto.
+ * \param x The x co-ordinate of the document origin on the surface.
+ * \param y The y co-ordinate of the document origin on the surface.
+ * \param clip The area of the surface to redraw.
+ * \return NSERROR_OK on success else appropriate error code on faliure.
+ */
+nserror fb_tile_cache_redraw(struct fb_tile_cache *cache,
+		struct browser_window *bw,
+		nsfb_t *nsfb,
+		int x, int y,
+		const struct rect *clip);
+
+/**
+ * Render one missing or invalid tile in an area.
+ *
+ * This allows tiles just outside the viewport to be prepared while the
+ * browser is otherwise idle so subsequent pans need only copy them.
+ *
+ * \param cache The cache to render a tile in.
+ * \param bw The browser window being rendered.
+ * \param area The area in document co-ordinates to consider.
+ * \return NSERROR_OK if a tile was rendered, NSERROR_NOT_FOUND if every
+ *         tile within the area is already valid or error code on faliure.
+ */
+nserror fb_tile_cache_prerender(struct fb_tile_cache *cache,
+		struct browser_window *bw,
+		const struct rect *area);
+
+#endif
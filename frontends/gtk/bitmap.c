@@ -32,6 +32,7 @@
 
 #include "utils/utils.h"
 #include "utils/errors.h"
+#include "utils/pixels.h"
 #include "netsurf/content.h"
 #include "netsurf/bitmap.h"
 #include "netsurf/plotters.h"
@@ -134,8 +135,7 @@ static bool bitmap_test_opaque(void *vbitmap)
 {
 	struct bitmap *gbitmap = (struct bitmap *)vbitmap;
 	unsigned char *pixels;
-	int pcount;
-	int ploop;
+	size_t pcount;
 
 	assert(gbitmap);
 
@@ -144,13 +144,7 @@ static bool bitmap_test_opaque(void *vbitmap)
 	pcount = cairo_image_surface_get_stride(gbitmap->surface) *
 		cairo_image_surface_get_height(gbitmap->surface);
 
-	for (ploop = 3; ploop < pcount; ploop += 4) {
-		if (pixels[ploop] != 0xff) {
-			return false;
-		}
-	}
-
-	return true;
+	return pixels_opaque(pixels, pcount / 4);
 }
 
 
@@ -187,11 +181,13 @@ static bool bitmap_get_opaque(void *vbitmap)
 static unsigned char *bitmap_get_buffer(void *vbitmap)
 {
 	struct bitmap *gbitmap = (struct bitmap *)vbitmap;
-	int pixel_loop;
 	int pixel_count;
 	uint8_t *pixels;
-	uint32_t t, r, g, b;
 	cairo_format_t fmt;
+#if G_BYTE_ORDER != G_LITTLE_ENDIAN
+	int pixel_loop;
+	uint32_t t, r, g, b;
+#endif
 
 	assert(gbitmap);
 
@@ -205,62 +201,35 @@ static unsigned char *bitmap_get_buffer(void *vbitmap)
 	pixel_count = cairo_image_surface_get_width(gbitmap->surface) *
 			cairo_image_surface_get_height(gbitmap->surface);
 
-	if (fmt == CAIRO_FORMAT_RGB24) {
-		/* Opaque image */
-		for (pixel_loop=0; pixel_loop < pixel_count; pixel_loop++) {
-			/* Cairo surface is ARGB, written in native endian */
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
-			b = pixels[4 * pixel_loop + 0];
-			g = pixels[4 * pixel_loop + 1];
-			r = pixels[4 * pixel_loop + 2];
-			t = pixels[4 * pixel_loop + 3];
-#else
-			t = pixels[4 * pixel_loop + 0];
-			r = pixels[4 * pixel_loop + 1];
-			g = pixels[4 * pixel_loop + 2];
-			b = pixels[4 * pixel_loop + 3];
-#endif
-
-			/* Core bitmaps always have a component order of rgba,
-			 * regardless of system endianness */
-			pixels[4 * pixel_loop + 0] = r;
-			pixels[4 * pixel_loop + 1] = g;
-			pixels[4 * pixel_loop + 2] = b;
-			pixels[4 * pixel_loop + 3] = t;
-		}
-	} else {
+	/* Cairo surface is ARGB, written in native endian, which is BGRA
+	 * in memory. Core bitmaps always have a component order of rgba.
+	 */
+	if (fmt != CAIRO_FORMAT_RGB24) {
 		/* Alpha image: de-multiply alpha */
-		for (pixel_loop=0; pixel_loop < pixel_count; pixel_loop++) {
-#if G_BYTE_ORDER == G_LITTLE_ENDIAN
-			b = pixels[4 * pixel_loop + 0];
-			g = pixels[4 * pixel_loop + 1];
-			r = pixels[4 * pixel_loop + 2];
-			t = pixels[4 * pixel_loop + 3];
+		pixels_unpremultiply(pixels, pixel_count);
+	}
+	pixels_swap_rb(pixels, pixel_count);
 #else
-			t = pixels[4 * pixel_loop + 0];
-			r = pixels[4 * pixel_loop + 1];
-			g = pixels[4 * pixel_loop + 2];
-			b = pixels[4 * pixel_loop + 3];
-#endif
-
-			if (t != 0) {
-				r = (r << 8) / t;
-				g = (g << 8) / t;
-				b = (b << 8) / t;
-
-				r = (r > 255) ? 255 : r;
-				g = (g > 255) ? 255 : g;
-				b = (b > 255) ? 255 : b;
-			} else {
-				r = g = b = 0;
-			}
-
-			pixels[4 * pixel_loop + 0] = r;
-			pixels[4 * pixel_loop + 1] = g;
-			pixels[4 * pixel_loop + 2] = b;
-			pixels[4 * pixel_loop + 3] = t;
-		}
+	for (pixel_loop=0; pixel_loop < pixel_count; pixel_loop++) {
+		/* Cairo surface is ARGB, written in native endian */
+		t = pixels[4 * pixel_loop + 0];
+		r = pixels[4 * pixel_loop + 1];
+		g = pixels[4 * pixel_loop + 2];
+		b = pixels[4 * pixel_loop + 3];
+
+		/* Core bitmaps always have a component order of rgba,
+		 * regardless of system endianness */
+		pixels[4 * pixel_loop + 0] = r;
+		pixels[4 * pixel_loop + 1] = g;
+		pixels[4 * pixel_loop + 2] = b;
+		pixels[4 * pixel_loop + 3] = t;
+	}
+	if (fmt != CAIRO_FORMAT_RGB24) {
+		/* Alpha image: de-multiply alpha */
+		pixels_unpremultiply(pixels, pixel_count);
 	}
+#endif
 
 	gbitmap->converted = false;
 
@@ -344,11 +313,13 @@ static bool bitmap_save(void *vbitmap, const char *path, unsigned flags)
 static void bitmap_modified(void *vbitmap)
 {
 	struct bitmap *gbitmap = (struct bitmap *)vbitmap;
-	int pixel_loop;
 	int pixel_count;
 	uint8_t *pixels;
-	uint32_t t, r, g, b;
 	cairo_format_t fmt;
+#if G_BYTE_ORDER != G_LITTLE_ENDIAN
+	int pixel_loop;
+	uint32_t t, r, g, b;
+#endif
 
 	assert(gbitmap);
 
@@ -363,58 +334,34 @@ static void bitmap_modified(void *vbitmap)
 		return;
 	}
 
-	if (fmt == CAIRO_FORMAT_RGB24) {
-		/* Opaque image */
-		for (pixel_loop=0; pixel_loop < pixel_count; pixel_loop++) {
-			/* Core bitmaps always have a component order of rgba,
-			 * regardless of system endianness */
-			r = pixels[4 * pixel_loop + 0];
-			g = pixels[4 * pixel_loop + 1];
-			b = pixels[4 * pixel_loop + 2];
-			t = pixels[4 * pixel_loop + 3];
-
-			/* Cairo surface is ARGB, written in native endian */
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
-			pixels[4 * pixel_loop + 0] = b;
-			pixels[4 * pixel_loop + 1] = g;
-			pixels[4 * pixel_loop + 2] = r;
-			pixels[4 * pixel_loop + 3] = t;
-#else
-			pixels[4 * pixel_loop + 0] = t;
-			pixels[4 * pixel_loop + 1] = r;
-			pixels[4 * pixel_loop + 2] = g;
-			pixels[4 * pixel_loop + 3] = b;
-#endif
-		}
-	} else {
+	/* Core bitmaps always have a component order of rgba, the Cairo
+	 * surface is ARGB, written in native endian, which is BGRA in
+	 * memory.
+	 */
+	if (fmt != CAIRO_FORMAT_RGB24) {
 		/* Alpha image: pre-multiply alpha */
-		for (pixel_loop=0; pixel_loop < pixel_count; pixel_loop++) {
-			r = pixels[4 * pixel_loop + 0];
-			g = pixels[4 * pixel_loop + 1];
-			b = pixels[4 * pixel_loop + 2];
-			t = pixels[4 * pixel_loop + 3];
-
-			if (t != 0) {
-				r = ((r * (t + 1)) >> 8) & 0xff;
-				g = ((g * (t + 1)) >> 8) & 0xff;
-				b = ((b * (t + 1)) >> 8) & 0xff;
-			} else {
-				r = g = b = 0;
-			}
-
-#if G_BYTE_ORDER == G_LITTLE_ENDIAN
-			pixels[4 * pixel_loop + 0] = b;
-			pixels[4 * pixel_loop + 1] = g;
-			pixels[4 * pixel_loop + 2] = r;
-			pixels[4 * pixel_loop + 3] = t;
+		pixels_premultiply(pixels, pixel_count);
+	}
+	pixels_swap_rb(pixels, pixel_count);
 #else
-			pixels[4 * pixel_loop + 0] = t;
-			pixels[4 * pixel_loop + 1] = r;
-			pixels[4 * pixel_loop + 2] = g;
-			pixels[4 * pixel_loop + 3] = b;
-#endif
-		}
+	if (fmt != CAIRO_FORMAT_RGB24) {
+		/* Alpha image: pre-multiply alpha */
+		pixels_premultiply(pixels, pixel_count);
 	}
+	for (pixel_loop=0; pixel_loop < pixel_count; pixel_loop++) {
+		r = pixels[4 * pixel_loop + 0];
+		g = pixels[4 * pixel_loop + 1];
+		b = pixels[4 * pixel_loop + 2];
+		t = pixels[4 * pixel_loop + 3];
+
+		/* Cairo surface is ARGB, written in native endian */
+		pixels[4 * pixel_loop + 0] = t;
+		pixels[4 * pixel_loop + 1] = r;
+		pixels[4 * pixel_loop + 2] = g;
+		pixels[4 * pixel_loop + 3] = b;
+	}
+#endif
 
 	cairo_surface_mark_dirty(gbitmap->surface);
 
@@ -30,6 +30,7 @@
 #include "netsurf/mouse.h"
 #include "netsurf/window.h"
 #include "netsurf/browser_window.h"
+#include "netsurf/content_type.h"
 #include "netsurf/plotters.h"
 
 #include "monkey/output.h"
@@ -654,6 +655,55 @@ monkey_window_handle_exec(int argc, char **argv)
 	}
 }
 
+static void
+monkey_window_handle_select_stats(int argc, char **argv)
+{
+	struct gui_window *gw;
+	char line[256];
+	size_t len;
+	nserror res;
+	FILE *f;
+
+	if (argc != 3) {
+		moutf(MOUT_ERROR, "WINDOW SELECT_STATS ARGS BAD");
+		return;
+	}
+
+	gw = monkey_find_window_by_num(atoi(argv[2]));
+
+	if (gw == NULL) {
+		moutf(MOUT_ERROR, "WINDOW NUM BAD");
+		return;
+	}
+
+	f = tmpfile();
+	if (f == NULL) {
+		moutf(MOUT_ERROR, "WINDOW SELECT_STATS TMPFILE BAD");
+		return;
+	}
+
+	res = browser_window_debug_dump(gw->bw, f, CONTENT_DEBUG_SELECT);
+	if (res != NSERROR_OK) {
+		moutf(MOUT_WINDOW, "SELECT_STATS WIN %d FAILED %s",
+		      atoi(argv[2]), messages_get_errorcode(res));
+		fclose(f);
+		return;
+	}
+
+	rewind(f);
+	while (fgets(line, sizeof(line), f) != NULL) {
+		len = strlen(line);
+		if ((len > 0) && (line[len - 1] == '\n')) {
+			line[len - 1] = '\0';
+		}
+		moutf(MOUT_WINDOW, "SELECT_STATS WIN %d %s",
+		      atoi(argv[2]), line);
+	}
+	moutf(MOUT_WINDOW, "SELECT_STATS WIN %d DONE", atoi(argv[2]));
+
+	fclose(f);
+}
+
 
 static void
 monkey_window_handle_click(int argc, char **argv)
@@ -719,6 +769,8 @@ monkey_window_handle_command(int argc, char **argv)
 		monkey_window_handle_exec(argc, argv);
 	} else if (strcmp(argv[1], "CLICK") == 0) {
 		monkey_window_handle_click(argc, argv);
+	} else if (strcmp(argv[1], "SELECT_STATS") == 0) {
+		monkey_window_handle_select_stats(argc, argv);
 	} else {
 		moutf(MOUT_ERROR, "WINDOW COMMAND UNKNOWN %s\n", argv[1]);
 	}
@@ -35,7 +35,10 @@ enum content_debug {
 	CONTENT_DEBUG_DOM,
 
 	/** Debug redraw operations. */
-	CONTENT_DEBUG_REDRAW
+	CONTENT_DEBUG_REDRAW,
+
+	/** Debug the contents style selection. */
+	CONTENT_DEBUG_SELECT
 };
 
 
@@ -0,0 +1,357 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Test pixel buffer conversions.
+ *
+ * Each conversion is checked against a straightforward per component
+ * calculation for every run length up to a few SIMD blocks so both the
+ * block and the remainder handling are exercised.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+
+#include "utils/pixels.h"
+
+/** Longest pixel run tested */
+#define PIXELS_RUN_MAX 70
+
+static uint8_t source[PIXELS_RUN_MAX * 4];
+static uint8_t result[PIXELS_RUN_MAX * 4];
+
+/**
+ * Exactly rounded (c * a) / 255
+ */
+static unsigned int reference_mul(unsigned int c, unsigned int a)
+{
+	return ((c * a * 2) + 255) / 510;
+}
+
+/**
+ * Fill the source pixels with a repeatable pseudo random pattern.
+ */
+static void fill_source(unsigned int seed, bool opaque)
+{
+	unsigned int idx;
+
+	for (idx = 0; idx < sizeof(source); idx++) {
+		seed = (seed * 1103515245) + 12345;
+		source[idx] = seed >> 16;
+	}
+	if (opaque) {
+		for (idx = 0; idx < PIXELS_RUN_MAX; idx++) {
+			source[(idx * 4) + 3] = 0xff;
+		}
+	}
+	memcpy(result, source, sizeof(result));
+}
+
+
+START_TEST(pixels_opaque_test)
+{
+	size_t count = _i;
+	size_t idx;
+
+	fill_source(_i, true);
+	ck_assert(pixels_opaque(source, count) == true);
+
+	/* a single transparent pixel anywhere must be found */
+	for (idx = 0; idx < count; idx++) {
+		source[(idx * 4) + 3] = 0xfe;
+		ck_assert(pixels_opaque(source, count) == false);
+		source[(idx * 4) + 3] = 0xff;
+	}
+}
+END_TEST
+
+START_TEST(pixels_swap_rb_test)
+{
+	size_t count = _i;
+	size_t idx;
+
+	fill_source(_i, false);
+	pixels_swap_rb(result, count);
+
+	for (idx = 0; idx < count; idx++) {
+		ck_assert_uint_eq(result[(idx * 4) + 0], source[(idx * 4) + 2]);
+		ck_assert_uint_eq(result[(idx * 4) + 1], source[(idx * 4) + 1]);
+		ck_assert_uint_eq(result[(idx * 4) + 2], source[(idx * 4) + 0]);
+		ck_assert_uint_eq(result[(idx * 4) + 3], source[(idx * 4) + 3]);
+	}
+	/* pixels beyond the run must be untouched */
+	ck_assert(memcmp(result + (count * 4),
+			 source + (count * 4),
+			 sizeof(source) - (count * 4)) == 0);
+}
+END_TEST
+
+START_TEST(pixels_premultiply_test)
+{
+	size_t count = _i;
+	size_t idx;
+	unsigned int a;
+
+	fill_source(_i, false);
+	pixels_premultiply(result, count);
+
+	for (idx = 0; idx < count; idx++) {
+		a = source[(idx * 4) + 3];
+		ck_assert_uint_eq(result[(idx * 4) + 0],
+				  reference_mul(source[(idx * 4) + 0], a));
+		ck_assert_uint_eq(result[(idx * 4) + 1],
+				  reference_mul(source[(idx * 4) + 1], a));
+		ck_assert_uint_eq(result[(idx * 4) + 2],
+				  reference_mul(source[(idx * 4) + 2], a));
+		ck_assert_uint_eq(result[(idx * 4) + 3], a);
+	}
+}
+END_TEST
+
+START_TEST(pixels_unpremultiply_test)
+{
+	size_t count = _i;
+	size_t idx;
+	unsigned int a;
+
+	fill_source(_i, false);
+	pixels_premultiply(result, count);
+	pixels_unpremultiply(result, count);
+
+	/* premultiplying the result again must give the same
+	 * premultiplied values.
+	 */
+	memcpy(source, result, sizeof(source));
+	pixels_premultiply(result, count);
+
+	for (idx = 0; idx < count; idx++) {
+		a = source[(idx * 4) + 3];
+		if (a == 0) {
+			ck_assert_uint_eq(source[(idx * 4) + 0], 0);
+			ck_assert_uint_eq(source[(idx * 4) + 1], 0);
+			ck_assert_uint_eq(source[(idx * 4) + 2], 0);
+		}
+		ck_assert_uint_eq(result[(idx * 4) + 0],
+				  reference_mul(source[(idx * 4) + 0], a));
+		ck_assert_uint_eq(result[(idx * 4) + 1],
+				  reference_mul(source[(idx * 4) + 1], a));
+		ck_assert_uint_eq(result[(idx * 4) + 2],
+				  reference_mul(source[(idx * 4) + 2], a));
+	}
+}
+END_TEST
+
+START_TEST(pixels_cmyk_to_rgba_test)
+{
+	size_t count = _i;
+	size_t idx;
+	unsigned int k;
+
+	fill_source(_i, false);
+	pixels_cmyk_to_rgba(result, count);
+
+	for (idx = 0; idx < count; idx++) {
+		k = source[(idx * 4) + 3];
+		ck_assert_uint_eq(result[(idx * 4) + 0],
+				  reference_mul(source[(idx * 4) + 0], k));
+		ck_assert_uint_eq(result[(idx * 4) + 1],
+				  reference_mul(source[(idx * 4) + 1], k));
+		ck_assert_uint_eq(result[(idx * 4) + 2],
+				  reference_mul(source[(idx * 4) + 2], k));
+		ck_assert_uint_eq(result[(idx * 4) + 3], 0xff);
+	}
+}
+END_TEST
+
+
+START_TEST(pixels_scale_uniform_test)
+{
+	unsigned int src_width = (_i % 9) + 1;
+	unsigned int src_height = (_i % 7) + 1;
+	unsigned int dst_width = (_i % 11) + 1;
+	unsigned int dst_height = (_i % 13) + 1;
+	uint8_t src[9 * 7 * 4];
+	uint8_t dst[11 * 13 * 4];
+	unsigned int idx;
+	int diff;
+
+	/* a uniform colour over varying alpha must survive resampling
+	 * in either direction.
+	 */
+	for (idx = 0; idx < src_width * src_height; idx++) {
+		src[(idx * 4) + 0] = 10;
+		src[(idx * 4) + 1] = 200;
+		src[(idx * 4) + 2] = 77;
+		src[(idx * 4) + 3] = (idx % 3) ? 128 : 255;
+	}
+
+	ck_assert(pixels_scale(src, src_width, src_height, src_width * 4,
+			       dst, dst_width, dst_height, dst_width * 4,
+			       false) == NSERROR_OK);
+
+	for (idx = 0; idx < dst_width * dst_height; idx++) {
+		diff = dst[(idx * 4) + 0] - 10;
+		ck_assert(abs(diff) <= 1);
+		diff = dst[(idx * 4) + 1] - 200;
+		ck_assert(abs(diff) <= 1);
+		diff = dst[(idx * 4) + 2] - 77;
+		ck_assert(abs(diff) <= 1);
+		ck_assert(dst[(idx * 4) + 3] >= 128);
+	}
+}
+END_TEST
+
+START_TEST(pixels_scale_reduce_test)
+{
+	static const uint8_t src[4 * 4] = {
+		0, 0, 0, 255,
+		100, 100, 100, 255,
+		200, 200, 200, 255,
+		255, 255, 255, 255,
+	};
+	uint8_t dst[2 * 4];
+
+	/* halving averages each pair of source pixels */
+	ck_assert(pixels_scale(src, 4, 1, sizeof(src),
+			       dst, 2, 1, sizeof(dst),
+			       true) == NSERROR_OK);
+
+	ck_assert_uint_eq(dst[0], 50);
+	ck_assert_uint_eq(dst[3], 255);
+	ck_assert_uint_eq(dst[4], 228);
+	ck_assert_uint_eq(dst[7], 255);
+}
+END_TEST
+
+START_TEST(pixels_scale_identity_test)
+{
+	uint8_t dst[PIXELS_RUN_MAX * 4];
+	unsigned int idx;
+
+	/* scaling opaque pixels to their own size changes nothing */
+	fill_source(_i, true);
+
+	ck_assert(pixels_scale(source, 10, 7, 10 * 4,
+			       dst, 10, 7, 10 * 4,
+			       (_i % 2) == 0) == NSERROR_OK);
+
+	for (idx = 0; idx < sizeof(dst); idx++) {
+		ck_assert_uint_eq(dst[idx], source[idx]);
+	}
+}
+END_TEST
+
+START_TEST(pixels_scale_low_alpha_test)
+{
+	static const uint8_t src[4 * 4] = {
+		0, 0, 0, 1,
+		51, 51, 51, 73,
+		255, 0, 128, 2,
+		0, 0, 0, 0,
+	};
+	static const uint8_t expect[4 * 4] = {
+		0, 0, 0, 1,
+		52, 52, 52, 73,
+		255, 0, 128, 2,
+		0, 0, 0, 0,
+	};
+	uint8_t dst[4 * 4];
+	unsigned int idx;
+
+	/* only the loss of premultiplying may change the colour of
+	 * nearly transparent pixels
+	 */
+	ck_assert(pixels_scale(src, 4, 1, sizeof(src),
+			       dst, 4, 1, sizeof(dst),
+			       false) == NSERROR_OK);
+
+	for (idx = 0; idx < sizeof(dst); idx++) {
+		ck_assert_uint_eq(dst[idx], expect[idx]);
+	}
+}
+END_TEST
+
+START_TEST(pixels_scale_empty_test)
+{
+	uint8_t px[4] = { 0, 0, 0, 255 };
+
+	ck_assert(pixels_scale(px, 1, 1, 4, px, 0, 1, 0,
+			       true) == NSERROR_BAD_PARAMETER);
+	ck_assert(pixels_scale(px, 1, 0, 4, px, 1, 1, 4,
+			       true) == NSERROR_BAD_PARAMETER);
+}
+END_TEST
+
+
+/* suite generation */
+static Suite *pixels_suite(void)
+{
+	Suite *s;
+	TCase *tc_pixels;
+	TCase *tc_scale;
+
+	s = suite_create("pixels");
+
+	/* conversions over every run length */
+	tc_pixels = tcase_create("Conversions");
+
+	tcase_add_loop_test(tc_pixels, pixels_opaque_test,
+			    0, PIXELS_RUN_MAX + 1);
+	tcase_add_loop_test(tc_pixels, pixels_swap_rb_test,
+			    0, PIXELS_RUN_MAX + 1);
+	tcase_add_loop_test(tc_pixels, pixels_premultiply_test,
+			    0, PIXELS_RUN_MAX + 1);
+	tcase_add_loop_test(tc_pixels, pixels_unpremultiply_test,
+			    0, PIXELS_RUN_MAX + 1);
+	tcase_add_loop_test(tc_pixels, pixels_cmyk_to_rgba_test,
+			    0, PIXELS_RUN_MAX + 1);
+	suite_add_tcase(s, tc_pixels);
+
+	/* resampling */
+	tc_scale = tcase_create("Scale");
+
+	tcase_add_loop_test(tc_scale, pixels_scale_uniform_test,
+			    0, 11 * 13);
+	tcase_add_test(tc_scale, pixels_scale_reduce_test);
+	tcase_add_loop_test(tc_scale, pixels_scale_identity_test, 0, 4);
+	tcase_add_test(tc_scale, pixels_scale_low_alpha_test);
+	tcase_add_test(tc_scale, pixels_scale_empty_test);
+	suite_add_tcase(s, tc_scale);
+
+	return s;
+}
+
+int main(int argc, char **argv)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = pixels_suite();
+
+	sr = srunner_create(s);
+	srunner_run_all(sr, CK_ENV);
+
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,395 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Test path rasterisation coverage.
+ *
+ * Shapes whose coverage of each pixel is known exactly are rasterised
+ * and the alpha of every pixel compared with it.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+
+#include "utils/errors.h"
+#include "netsurf/plotters.h"
+
+#include "image/svg_raster.h"
+
+/** Width of the test raster */
+#define RASTER_WIDTH 12
+
+/** Height of the test raster */
+#define RASTER_HEIGHT 8
+
+static uint8_t pixels[RASTER_WIDTH * RASTER_HEIGHT * 4];
+static struct svg_raster *raster;
+
+static const float identity[6] = { 1, 0, 0, 1, 0, 0 };
+
+static void raster_create(void)
+{
+	memset(pixels, 0, sizeof(pixels));
+	ck_assert(svg_raster_create(RASTER_WIDTH, RASTER_HEIGHT,
+				    pixels, RASTER_WIDTH * 4,
+				    &raster) == NSERROR_OK);
+}
+
+static void raster_destroy(void)
+{
+	svg_raster_destroy(raster);
+}
+
+/**
+ * Get the alpha of a pixel.
+ */
+static unsigned int alpha(int x, int y)
+{
+	return pixels[((y * RASTER_WIDTH) + x) * 4 + 3];
+}
+
+/**
+ * Check every pixel of the raster has an expected alpha.
+ *
+ * \param expect The expected alpha of each pixel in rows.
+ */
+static void check_alpha(const uint8_t *expect)
+{
+	int x, y;
+
+	for (y = 0; y < RASTER_HEIGHT; y++) {
+		for (x = 0; x < RASTER_WIDTH; x++) {
+			ck_assert_msg(alpha(x, y) ==
+				      expect[(y * RASTER_WIDTH) + x],
+				      "pixel %d,%d alpha %u expected %u",
+				      x, y, alpha(x, y),
+				      expect[(y * RASTER_WIDTH) + x]);
+		}
+	}
+}
+
+
+START_TEST(svg_raster_square_test)
+{
+	static const uint8_t expect[RASTER_WIDTH * RASTER_HEIGHT] = {
+		0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+		0,   0, 255, 255, 255, 255, 255,   0,   0,   0,   0,   0,
+		0,   0, 255, 255, 255, 255, 255,   0,   0,   0,   0,   0,
+		0,   0, 255, 255, 255, 255, 255,   0,   0,   0,   0,   0,
+		0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+		0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+		0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+		0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	};
+	int x;
+
+	/* pixel aligned square outline drawn clockwise */
+	svg_raster_line(raster, 2, 1, 7, 1);
+	svg_raster_line(raster, 7, 1, 7, 4);
+	svg_raster_line(raster, 7, 4, 2, 4);
+	svg_raster_line(raster, 2, 4, 2, 1);
+	svg_raster_composite(raster, 0x0000ff);
+
+	check_alpha(expect);
+
+	/* colour is composited unchanged over transparency */
+	for (x = 2; x < 7; x++) {
+		ck_assert_uint_eq(pixels[((RASTER_WIDTH * 2) + x) * 4 + 0],
+				  0xff);
+		ck_assert_uint_eq(pixels[((RASTER_WIDTH * 2) + x) * 4 + 1], 0);
+		ck_assert_uint_eq(pixels[((RASTER_WIDTH * 2) + x) * 4 + 2], 0);
+	}
+}
+END_TEST
+
+START_TEST(svg_raster_reversed_test)
+{
+	static const uint8_t expect[RASTER_WIDTH * RASTER_HEIGHT] = {
+		0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+		0,   0, 255, 255, 255, 255, 255,   0,   0,   0,   0,   0,
+		0,   0, 255, 255, 255, 255, 255,   0,   0,   0,   0,   0,
+		0,   0, 255, 255, 255, 255, 255,   0,   0,   0,   0,   0,
+		0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+		0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+		0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+		0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	};
+
+	/* the same square drawn anticlockwise covers the same pixels */
+	svg_raster_line(raster, 2, 1, 2, 4);
+	svg_raster_line(raster, 2, 4, 7, 4);
+	svg_raster_line(raster, 7, 4, 7, 1);
+	svg_raster_line(raster, 7, 1, 2, 1);
+	svg_raster_composite(raster, 0x0000ff);
+
+	check_alpha(expect);
+}
+END_TEST
+
+START_TEST(svg_raster_half_pixel_test)
+{
+	static const uint8_t expect[RASTER_WIDTH * RASTER_HEIGHT] = {
+		0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+		0,   0,  64, 128, 128, 128, 128, 128,  64,   0,   0,   0,
+		0,   0, 128, 255, 255, 255, 255, 255, 128,   0,   0,   0,
+		0,   0, 128, 255, 255, 255, 255, 255, 128,   0,   0,   0,
+		0,   0,  64, 128, 128, 128, 128, 128,  64,   0,   0,   0,
+		0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+		0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+		0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+	};
+
+	/* edges half way across pixels cover them by half and corners
+	 * by a quarter.
+	 */
+	svg_raster_line(raster, 2.5, 1.5, 8.5, 1.5);
+	svg_raster_line(raster, 8.5, 1.5, 8.5, 4.5);
+	svg_raster_line(raster, 8.5, 4.5, 2.5, 4.5);
+	svg_raster_line(raster, 2.5, 4.5, 2.5, 1.5);
+	svg_raster_composite(raster, 0x0000ff);
+
+	check_alpha(expect);
+}
+END_TEST
+
+START_TEST(svg_raster_diagonal_test)
+{
+	int x, y;
+
+	/* a diagonal edge through pixel corners halves the pixels it
+	 * crosses.
+	 */
+	svg_raster_line(raster, 0, 0, 8, 8);
+	svg_raster_line(raster, 8, 8, 0, 8);
+	svg_raster_line(raster, 0, 8, 0, 0);
+	svg_raster_composite(raster, 0x0000ff);
+
+	for (y = 0; y < RASTER_HEIGHT; y++) {
+		for (x = 0; x < RASTER_WIDTH; x++) {
+			if (x < y) {
+				ck_assert_uint_eq(alpha(x, y), 255);
+			} else if (x == y) {
+				ck_assert_uint_eq(alpha(x, y), 128);
+			} else {
+				ck_assert_uint_eq(alpha(x, y), 0);
+			}
+		}
+	}
+}
+END_TEST
+
+START_TEST(svg_raster_clip_test)
+{
+	int x, y;
+
+	/* a shape larger than the raster covers all of it */
+	svg_raster_line(raster, -5, -5, 20, -5);
+	svg_raster_line(raster, 20, -5, 20, 20);
+	svg_raster_line(raster, 20, 20, -5, 20);
+	svg_raster_line(raster, -5, 20, -5, -5);
+	svg_raster_composite(raster, 0x0000ff);
+
+	for (y = 0; y < RASTER_HEIGHT; y++) {
+		for (x = 0; x < RASTER_WIDTH; x++) {
+			ck_assert_uint_eq(alpha(x, y), 255);
+		}
+	}
+}
+END_TEST
+
+START_TEST(svg_raster_composite_clear_test)
+{
+	int x, y;
+
+	/* compositing clears the accumulation so a second composite
+	 * with nothing accumulated changes nothing.
+	 */
+	svg_raster_line(raster, 2.5, 1, 2.5, 4);
+	svg_raster_line(raster, 6, 4, 6, 1);
+	svg_raster_composite(raster, 0x0000ff);
+	svg_raster_composite(raster, 0xff0000);
+
+	for (y = 0; y < RASTER_HEIGHT; y++) {
+		for (x = 0; x < RASTER_WIDTH; x++) {
+			ck_assert_uint_eq(pixels[((y * RASTER_WIDTH) + x) * 4 + 2],
+					  0);
+		}
+	}
+	ck_assert_uint_eq(alpha(2, 2), 128);
+	ck_assert_uint_eq(alpha(3, 2), 255);
+}
+END_TEST
+
+START_TEST(svg_raster_blend_test)
+{
+	/* half covered blue over half covered red */
+	svg_raster_line(raster, 0, 0, 0, 1);
+	svg_raster_line(raster, 0.5, 1, 0.5, 0);
+	svg_raster_composite(raster, 0x0000ff);
+	svg_raster_line(raster, 0, 0, 0, 1);
+	svg_raster_line(raster, 0.5, 1, 0.5, 0);
+	svg_raster_composite(raster, 0xff0000);
+
+	ck_assert_uint_eq(pixels[0], 0x55);
+	ck_assert_uint_eq(pixels[1], 0);
+	ck_assert_uint_eq(pixels[2], 0xaa);
+	ck_assert_uint_eq(pixels[3], 192);
+}
+END_TEST
+
+START_TEST(svg_raster_path_test)
+{
+	static const float square[] = {
+		PLOTTER_PATH_MOVE, 1, 1,
+		PLOTTER_PATH_LINE, 5, 1,
+		PLOTTER_PATH_LINE, 5, 3,
+		PLOTTER_PATH_LINE, 1, 3,
+	};
+	static const float transform[6] = { 2, 0, 0, 2, 0, 0 };
+	int x, y;
+
+	/* an unclosed subpath is closed when filled and transformed */
+	ck_assert(svg_raster_path(raster, square,
+				  sizeof(square) / sizeof(float),
+				  transform, 0) == true);
+	svg_raster_composite(raster, 0x0000ff);
+
+	for (y = 0; y < RASTER_HEIGHT; y++) {
+		for (x = 0; x < RASTER_WIDTH; x++) {
+			if ((x >= 2) && (x < 10) && (y >= 2) && (y < 6)) {
+				ck_assert_uint_eq(alpha(x, y), 255);
+			} else {
+				ck_assert_uint_eq(alpha(x, y), 0);
+			}
+		}
+	}
+}
+END_TEST
+
+START_TEST(svg_raster_stroke_test)
+{
+	static const float line[] = {
+		PLOTTER_PATH_MOVE, 1, 3,
+		PLOTTER_PATH_LINE, 11, 3,
+	};
+	int x, y;
+
+	/* a two pixel wide stroke along a pixel boundary */
+	ck_assert(svg_raster_path(raster, line,
+				  sizeof(line) / sizeof(float),
+				  identity, 2) == true);
+	svg_raster_composite(raster, 0x0000ff);
+
+	for (y = 0; y < RASTER_HEIGHT; y++) {
+		for (x = 0; x < RASTER_WIDTH; x++) {
+			if ((x >= 1) && (x < 11) && (y >= 2) && (y < 4)) {
+				ck_assert_uint_eq(alpha(x, y), 255);
+			} else {
+				ck_assert_uint_eq(alpha(x, y), 0);
+			}
+		}
+	}
+}
+END_TEST
+
+START_TEST(svg_raster_bad_path_test)
+{
+	static const float truncated[] = {
+		PLOTTER_PATH_MOVE, 1, 1,
+		PLOTTER_PATH_LINE, 5,
+	};
+
+	ck_assert(svg_raster_path(raster, truncated,
+				  sizeof(truncated) / sizeof(float),
+				  identity, 0) == false);
+}
+END_TEST
+
+START_TEST(svg_raster_empty_test)
+{
+	struct svg_raster *r;
+
+	ck_assert(svg_raster_create(0, 1, pixels, 0, &r) ==
+		  NSERROR_BAD_SIZE);
+	ck_assert(svg_raster_create(1, 0, pixels, 4, &r) ==
+		  NSERROR_BAD_SIZE);
+}
+END_TEST
+
+
+/* suite generation */
+static Suite *svg_raster_suite(void)
+{
+	Suite *s;
+	TCase *tc_coverage;
+	TCase *tc_path;
+	TCase *tc_create;
+
+	s = suite_create("svg_raster");
+
+	/* coverage of outlines */
+	tc_coverage = tcase_create("Coverage");
+
+	tcase_add_checked_fixture(tc_coverage, raster_create, raster_destroy);
+	tcase_add_test(tc_coverage, svg_raster_square_test);
+	tcase_add_test(tc_coverage, svg_raster_reversed_test);
+	tcase_add_test(tc_coverage, svg_raster_half_pixel_test);
+	tcase_add_test(tc_coverage, svg_raster_diagonal_test);
+	tcase_add_test(tc_coverage, svg_raster_clip_test);
+	tcase_add_test(tc_coverage, svg_raster_composite_clear_test);
+	tcase_add_test(tc_coverage, svg_raster_blend_test);
+	suite_add_tcase(s, tc_coverage);
+
+	/* paths */
+	tc_path = tcase_create("Path");
+
+	tcase_add_checked_fixture(tc_path, raster_create, raster_destroy);
+	tcase_add_test(tc_path, svg_raster_path_test);
+	tcase_add_test(tc_path, svg_raster_stroke_test);
+	tcase_add_test(tc_path, svg_raster_bad_path_test);
+	suite_add_tcase(s, tc_path);
+
+	/* creation */
+	tc_create = tcase_create("Create");
+
+	tcase_add_test(tc_create, svg_raster_empty_test);
+	suite_add_tcase(s, tc_create);
+
+	return s;
+}
+
+int main(int argc, char **argv)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = svg_raster_suite();
+
+	sr = srunner_create(s);
+	srunner_run_all(sr, CK_ENV);
+
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -91,6 +91,7 @@ CORESTRING_LWC_STRING(includesubdomains);
 CORESTRING_LWC_STRING(input);
 CORESTRING_LWC_STRING(javascript);
 CORESTRING_LWC_STRING(justify);
+CORESTRING_LWC_STRING(lazy);
 CORESTRING_LWC_STRING(left);
 CORESTRING_LWC_STRING(li);
 CORESTRING_LWC_STRING(link);
@@ -228,6 +229,7 @@ CORESTRING_DOM_STRING(defer);
 CORESTRING_DOM_STRING(DOMAttrModified);
 CORESTRING_DOM_STRING(DOMNodeInserted);
 CORESTRING_DOM_STRING(DOMNodeInsertedIntoDocument);
+CORESTRING_DOM_STRING(DOMNodeRemoved);
 CORESTRING_DOM_STRING(DOMSubtreeModified);
 CORESTRING_DOM_STRING(drag);
 CORESTRING_DOM_STRING(dragend);
@@ -262,6 +264,7 @@ CORESTRING_DOM_STRING(languagechange);
 CORESTRING_DOM_STRING(load);
 CORESTRING_DOM_STRING(loadeddata);
 CORESTRING_DOM_STRING(loadedmetadata);
+CORESTRING_DOM_STRING(loading);
 CORESTRING_DOM_STRING(loadstart);
 CORESTRING_DOM_STRING(map);
 CORESTRING_DOM_STRING(marginheight);
@@ -367,6 +370,7 @@ CORESTRING_DOM_STRING(__ns_key_file_name_node_data);
 CORESTRING_DOM_STRING(__ns_key_image_coords_node_data);
 CORESTRING_DOM_STRING(__ns_key_html_content_data);
 CORESTRING_DOM_STRING(__ns_key_canvas_node_data);
+CORESTRING_DOM_STRING(__ns_key_link_node_data);
 
 /* unusual DOM strings */
 CORESTRING_DOM_VALUE(text_javascript, "text/javascript");
@@ -0,0 +1,614 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Pixel buffer conversion implementation.
+ *
+ * The SIMD paths are selected at compile time from the instruction set
+ * the target is built for. SSE2 is part of the x86-64 baseline and NEON
+ * of the AArch64 baseline so no runtime detection is required. Each
+ * SIMD path handles whole blocks of pixels and leaves any remainder to
+ * the portable code.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define PIXELS_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PIXELS_NEON 1
+#endif
+
+#include "utils/pixels.h"
+
+/**
+ * Multiply a component by an alpha value with rounding.
+ *
+ * This gives the exact rounded result of (c * a) / 255 for all 8bit
+ * values and matches the SIMD implementations.
+ */
+static inline uint8_t pixels_mul(unsigned int c, unsigned int a)
+{
+	unsigned int t = (c * a) + 128;
+	return (t + (t >> 8)) >> 8;
+}
+
+
+#if defined(PIXELS_SSE2)
+/**
+ * Multiply the first three components of four pixels by the fourth.
+ *
+ * \param px The pixels.
+ * \return The pixels with colour components multiplied.
+ */
+static inline __m128i pixels_sse2_mul(__m128i px)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rgb = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+	const __m128i alpha = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+	const __m128i round = _mm_set1_epi16(128);
+	__m128i lo, hi, alo, ahi;
+
+	lo = _mm_unpacklo_epi8(px, zero);
+	hi = _mm_unpackhi_epi8(px, zero);
+
+	/* spread each alpha across its pixel, leaving the alpha
+	 * component itself multiplied by one.
+	 */
+	alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xff), 0xff);
+	ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xff), 0xff);
+	alo = _mm_or_si128(_mm_and_si128(alo, rgb), alpha);
+	ahi = _mm_or_si128(_mm_and_si128(ahi, rgb), alpha);
+
+	lo = _mm_add_epi16(_mm_mullo_epi16(lo, alo), round);
+	hi = _mm_add_epi16(_mm_mullo_epi16(hi, ahi), round);
+	lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+	hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+	return _mm_packus_epi16(lo, hi);
+}
+#endif
+
+
+#if defined(PIXELS_NEON)
+/**
+ * Multiply eight components by eight alpha values.
+ */
+static inline uint8x8_t pixels_neon_mul(uint8x8_t c, uint8x8_t a)
+{
+	uint16x8_t t = vmull_u8(c, a);
+	return vraddhn_u16(t, vrshrq_n_u16(t, 8));
+}
+
+/**
+ * Multiply sixteen components by sixteen alpha values.
+ */
+static inline uint8x16_t pixels_neonq_mul(uint8x16_t c, uint8x16_t a)
+{
+	return vcombine_u8(pixels_neon_mul(vget_low_u8(c), vget_low_u8(a)),
+			   pixels_neon_mul(vget_high_u8(c), vget_high_u8(a)));
+}
+#endif
+
+
+/* exported interface documented in utils/pixels.h */
+bool pixels_opaque(const uint8_t *pixels, size_t count)
+{
+	static const uint8_t mask_bytes[4] = { 0, 0, 0, 0xff };
+	uint32_t mask;
+	uint32_t acc;
+	uint32_t px;
+	size_t idx;
+
+#if defined(PIXELS_SSE2)
+	const __m128i amask = _mm_slli_epi32(_mm_set1_epi32(0xff), 24);
+	__m128i vacc;
+
+	while (count >= 16) {
+		vacc = _mm_and_si128(
+			_mm_and_si128(
+				_mm_loadu_si128((const __m128i *)pixels),
+				_mm_loadu_si128((const __m128i *)(pixels + 16))),
+			_mm_and_si128(
+				_mm_loadu_si128((const __m128i *)(pixels + 32)),
+				_mm_loadu_si128((const __m128i *)(pixels + 48))));
+		vacc = _mm_cmpeq_epi8(_mm_and_si128(vacc, amask), amask);
+		if (_mm_movemask_epi8(vacc) != 0xffff) {
+			return false;
+		}
+		pixels += 64;
+		count -= 16;
+	}
+#elif defined(PIXELS_NEON)
+	uint8x16x4_t v;
+	uint8x8_t a;
+
+	while (count >= 16) {
+		v = vld4q_u8(pixels);
+		a = vand_u8(vget_low_u8(v.val[3]), vget_high_u8(v.val[3]));
+		if (vget_lane_u64(vreinterpret_u64_u8(a), 0) != UINT64_MAX) {
+			return false;
+		}
+		pixels += 64;
+		count -= 16;
+	}
+#endif
+
+	/* a word at a time, checking the accumulated alpha every
+	 * eight pixels so transparency is still found early.
+	 */
+	memcpy(&mask, mask_bytes, sizeof(mask));
+	while (count >= 8) {
+		acc = ~(uint32_t)0;
+		for (idx = 0; idx < 8; idx++) {
+			memcpy(&px, pixels + (idx * 4), sizeof(px));
+			acc &= px;
+		}
+		if ((acc & mask) != mask) {
+			return false;
+		}
+		pixels += 32;
+		count -= 8;
+	}
+
+	for (idx = 0; idx < count; idx++) {
+		if (pixels[(idx * 4) + 3] != 0xff) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/* exported interface documented in utils/pixels.h */
+void pixels_swap_rb(uint8_t *pixels, size_t count)
+{
+	uint8_t t;
+
+#if defined(PIXELS_SSE2)
+	const __m128i ga = _mm_set1_epi32(0xff00ff00);
+	const __m128i rb = _mm_set1_epi32(0x00ff00ff);
+	__m128i px, c;
+
+	while (count >= 4) {
+		px = _mm_loadu_si128((const __m128i *)pixels);
+		c = _mm_and_si128(px, rb);
+		c = _mm_or_si128(_mm_slli_epi32(c, 16), _mm_srli_epi32(c, 16));
+		px = _mm_or_si128(_mm_and_si128(px, ga), c);
+		_mm_storeu_si128((__m128i *)pixels, px);
+		pixels += 16;
+		count -= 4;
+	}
+#elif defined(PIXELS_NEON)
+	uint8x16x4_t v;
+	uint8x16_t c;
+
+	while (count >= 16) {
+		v = vld4q_u8(pixels);
+		c = v.val[0];
+		v.val[0] = v.val[2];
+		v.val[2] = c;
+		vst4q_u8(pixels, v);
+		pixels += 64;
+		count -= 16;
+	}
+#endif
+
+	while (count-- > 0) {
+		t = pixels[0];
+		pixels[0] = pixels[2];
+		pixels[2] = t;
+		pixels += 4;
+	}
+}
+
+
+/* exported interface documented in utils/pixels.h */
+void pixels_premultiply(uint8_t *pixels, size_t count)
+{
+	unsigned int a;
+
+#if defined(PIXELS_SSE2)
+	__m128i px;
+
+	while (count >= 4) {
+		px = _mm_loadu_si128((const __m128i *)pixels);
+		_mm_storeu_si128((__m128i *)pixels, pixels_sse2_mul(px));
+		pixels += 16;
+		count -= 4;
+	}
+#elif defined(PIXELS_NEON)
+	uint8x16x4_t v;
+
+	while (count >= 16) {
+		v = vld4q_u8(pixels);
+		v.val[0] = pixels_neonq_mul(v.val[0], v.val[3]);
+		v.val[1] = pixels_neonq_mul(v.val[1], v.val[3]);
+		v.val[2] = pixels_neonq_mul(v.val[2], v.val[3]);
+		vst4q_u8(pixels, v);
+		pixels += 64;
+		count -= 16;
+	}
+#endif
+
+	while (count-- > 0) {
+		a = pixels[3];
+		if (a != 0xff) {
+			pixels[0] = pixels_mul(pixels[0], a);
+			pixels[1] = pixels_mul(pixels[1], a);
+			pixels[2] = pixels_mul(pixels[2], a);
+		}
+		pixels += 4;
+	}
+}
+
+
+/* exported interface documented in utils/pixels.h */
+void pixels_unpremultiply(uint8_t *pixels, size_t count)
+{
+	unsigned int a;
+	unsigned int c;
+	int i;
+
+	/* division does not vectorise usefully, but almost all pixels
+	 * in real images are either opaque or fully transparent and
+	 * need no division at all.
+	 */
+	while (count-- > 0) {
+		a = pixels[3];
+		if (a == 0) {
+			pixels[0] = pixels[1] = pixels[2] = 0;
+		} else if (a != 0xff) {
+			for (i = 0; i < 3; i++) {
+				c = ((pixels[i] * 255) + (a / 2)) / a;
+				pixels[i] = (c > 255) ? 255 : c;
+			}
+		}
+		pixels += 4;
+	}
+}
+
+
+/* exported interface documented in utils/pixels.h */
+void pixels_cmyk_to_rgba(uint8_t *pixels, size_t count)
+{
+	unsigned int k;
+
+#if defined(PIXELS_SSE2)
+	const __m128i amask = _mm_slli_epi32(_mm_set1_epi32(0xff), 24);
+	__m128i px;
+
+	while (count >= 4) {
+		px = _mm_loadu_si128((const __m128i *)pixels);
+		px = _mm_or_si128(pixels_sse2_mul(px), amask);
+		_mm_storeu_si128((__m128i *)pixels, px);
+		pixels += 16;
+		count -= 4;
+	}
+#elif defined(PIXELS_NEON)
+	uint8x16x4_t v;
+
+	while (count >= 16) {
+		v = vld4q_u8(pixels);
+		v.val[0] = pixels_neonq_mul(v.val[0], v.val[3]);
+		v.val[1] = pixels_neonq_mul(v.val[1], v.val[3]);
+		v.val[2] = pixels_neonq_mul(v.val[2], v.val[3]);
+		v.val[3] = vdupq_n_u8(0xff);
+		vst4q_u8(pixels, v);
+		pixels += 64;
+		count -= 16;
+	}
+#endif
+
+	while (count-- > 0) {
+		k = pixels[3];
+		pixels[0] = pixels_mul(pixels[0], k);
+		pixels[1] = pixels_mul(pixels[1], k);
+		pixels[2] = pixels_mul(pixels[2], k);
+		pixels[3] = 0xff;
+		pixels += 4;
+	}
+}
+
+
+/** Number of bits of fraction in resampling weights */
+#define PIXELS_WEIGHT_SHIFT 14
+
+/** Resampling weight of a single source pixel */
+#define PIXELS_WEIGHT_ONE (1U << PIXELS_WEIGHT_SHIFT)
+
+/** Half of one eight bit step in a vertically accumulated value */
+#define PIXELS_ROUND (PIXELS_WEIGHT_ONE << 7)
+
+/**
+ * Resampling filter along one axis
+ *
+ * Each destination pixel is the weighted sum of up to taps consecutive
+ * source pixels.
+ */
+struct pixels_filter {
+	unsigned int taps; /**< Maximum number of source pixels used */
+	unsigned int *first; /**< First source pixel for each output */
+	unsigned int *count; /**< Number of source pixels for each output */
+	uint16_t *weight; /**< Weights, taps entries for each output */
+};
+
+
+/**
+ * Release the tables of a resampling filter.
+ *
+ * \param filter The filter to finalise.
+ */
+static void pixels_filter_fini(struct pixels_filter *filter)
+{
+	free(filter->first);
+	free(filter->count);
+	free(filter->weight);
+}
+
+
+/**
+ * Create the tables for a resampling filter.
+ *
+ * \param filter The filter to initialise.
+ * \param src The number of source pixels.
+ * \param dst The number of destination pixels.
+ * \return NSERROR_OK on success or NSERROR_NOMEM.
+ */
+static nserror
+pixels_filter_init(struct pixels_filter *filter, unsigned int src, unsigned int dst)
+{
+	unsigned int i, n;
+	uint64_t start, end, lo, hi, pos, j;
+	unsigned int total;
+	uint16_t *w;
+
+	if (src > dst) {
+		filter->taps = ((src + dst - 1) / dst) + 1;
+	} else {
+		filter->taps = 2;
+	}
+
+	filter->first = malloc(dst * sizeof(unsigned int));
+	filter->count = malloc(dst * sizeof(unsigned int));
+	filter->weight = calloc((size_t)dst * filter->taps, sizeof(uint16_t));
+	if ((filter->first == NULL) ||
+	    (filter->count == NULL) ||
+	    (filter->weight == NULL)) {
+		pixels_filter_fini(filter);
+		return NSERROR_NOMEM;
+	}
+
+	for (i = 0; i < dst; i++) {
+		w = filter->weight + ((size_t)i * filter->taps);
+
+		if (src > dst) {
+			/* reduction: measured in units where a source
+			 * pixel is dst long and an output pixel src long,
+			 * weight each source pixel by its overlap.
+			 */
+			start = (uint64_t)i * src;
+			end = start + src;
+			j = start / dst;
+			filter->first[i] = j;
+			total = 0;
+			for (n = 0; (j * dst) < end; n++, j++) {
+				lo = (j * dst > start) ? j * dst : start;
+				hi = ((j + 1) * dst < end) ? (j + 1) * dst : end;
+				w[n] = ((hi - lo) << PIXELS_WEIGHT_SHIFT) / src;
+				total += w[n];
+			}
+			/* rounding remainder keeps the weights summing
+			 * to exactly one.
+			 */
+			w[0] += PIXELS_WEIGHT_ONE - total;
+			filter->count[i] = n;
+		} else {
+			/* enlargement: centre of the output pixel in
+			 * source co-ordinates, scaled by 2 * dst.
+			 */
+			pos = ((2 * (uint64_t)i) + 1) * src;
+			pos = (pos > dst) ? pos - dst : 0;
+			j = pos / (2 * dst);
+			if (j + 1 >= src) {
+				filter->first[i] = src - 1;
+				filter->count[i] = 1;
+				w[0] = PIXELS_WEIGHT_ONE;
+			} else {
+				filter->first[i] = j;
+				filter->count[i] = 2;
+				w[1] = ((pos % (2 * dst)) << PIXELS_WEIGHT_SHIFT) /
+					(2 * dst);
+				w[0] = PIXELS_WEIGHT_ONE - w[1];
+			}
+		}
+	}
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Resample a row of pixels horizontally.
+ *
+ * The output keeps eight bits of fraction so the vertical pass does
+ * not compound rounding errors.
+ *
+ * \param filter The horizontal filter.
+ * \param src The source row.
+ * \param dst The destination row.
+ * \param width The width of the destination row.
+ */
+static void
+pixels_scale_row(const struct pixels_filter *filter,
+		 const uint8_t *src, uint16_t *dst, unsigned int width)
+{
+	const uint16_t *w;
+	const uint8_t *p;
+	uint32_t acc[4];
+	unsigned int i, t;
+
+	for (i = 0; i < width; i++) {
+		w = filter->weight + ((size_t)i * filter->taps);
+		p = src + ((size_t)filter->first[i] * 4);
+
+		acc[0] = acc[1] = acc[2] = acc[3] = PIXELS_WEIGHT_ONE >> 9;
+		for (t = 0; t < filter->count[i]; t++) {
+			acc[0] += p[0] * w[t];
+			acc[1] += p[1] * w[t];
+			acc[2] += p[2] * w[t];
+			acc[3] += p[3] * w[t];
+			p += 4;
+		}
+
+		dst[0] = acc[0] >> (PIXELS_WEIGHT_SHIFT - 8);
+		dst[1] = acc[1] >> (PIXELS_WEIGHT_SHIFT - 8);
+		dst[2] = acc[2] >> (PIXELS_WEIGHT_SHIFT - 8);
+		dst[3] = acc[3] >> (PIXELS_WEIGHT_SHIFT - 8);
+		dst += 4;
+	}
+}
+
+
+/* exported interface documented in utils/pixels.h */
+nserror pixels_scale(const uint8_t *src,
+		unsigned int src_width, unsigned int src_height,
+		size_t src_stride,
+		uint8_t *dst,
+		unsigned int dst_width, unsigned int dst_height,
+		size_t dst_stride,
+		bool opaque)
+{
+	struct pixels_filter hfilter;
+	struct pixels_filter vfilter;
+	size_t row_bytes = (size_t)dst_width * 4;
+	uint16_t *inter; /* ring of vfilter.taps horizontally scaled rows */
+	uint8_t *row; /* premultiplied source row */
+	uint32_t *acc; /* vertical accumulators */
+	uint8_t *out;
+	const uint8_t *p;
+	const uint16_t *ip;
+	const uint16_t *w;
+	unsigned int y, t;
+	unsigned int scaled = 0; /* source rows horizontally scaled */
+	uint32_t a, c;
+	size_t k;
+	nserror res;
+
+	if ((src_width == 0) || (src_height == 0) ||
+	    (dst_width == 0) || (dst_height == 0)) {
+		return NSERROR_BAD_PARAMETER;
+	}
+
+	res = pixels_filter_init(&hfilter, src_width, dst_width);
+	if (res != NSERROR_OK) {
+		return res;
+	}
+	res = pixels_filter_init(&vfilter, src_height, dst_height);
+	if (res != NSERROR_OK) {
+		pixels_filter_fini(&hfilter);
+		return res;
+	}
+
+	inter = malloc(row_bytes * vfilter.taps * sizeof(uint16_t));
+	row = malloc((size_t)src_width * 4);
+	acc = malloc(row_bytes * sizeof(uint32_t));
+	if ((inter == NULL) || (row == NULL) || (acc == NULL)) {
+		res = NSERROR_NOMEM;
+		goto out;
+	}
+
+	for (y = 0; y < dst_height; y++) {
+		/* horizontal pass over the source rows this output row
+		 * needs. The rows used by successive output rows never
+		 * move backwards and span at most vfilter.taps rows so
+		 * each is held in the ring until it is no longer needed.
+		 */
+		while (scaled < vfilter.first[y] + vfilter.count[y]) {
+			p = src + (scaled * src_stride);
+			if (!opaque) {
+				memcpy(row, p, (size_t)src_width * 4);
+				pixels_premultiply(row, src_width);
+				p = row;
+			}
+			pixels_scale_row(&hfilter, p,
+					 inter + ((scaled % vfilter.taps) *
+						  row_bytes),
+					 dst_width);
+			scaled++;
+		}
+
+		/* vertical pass, accumulating whole rows at a time */
+		w = vfilter.weight + ((size_t)y * vfilter.taps);
+
+		for (k = 0; k < row_bytes; k++) {
+			acc[k] = 0;
+		}
+		for (t = 0; t < vfilter.count[y]; t++) {
+			ip = inter + (((vfilter.first[y] + t) % vfilter.taps) *
+				      row_bytes);
+			for (k = 0; k < row_bytes; k++) {
+				acc[k] += ip[k] * w[t];
+			}
+		}
+
+		out = dst + (y * dst_stride);
+		if (opaque) {
+			for (k = 0; k < row_bytes; k++) {
+				out[k] = (acc[k] + PIXELS_ROUND) >>
+					(PIXELS_WEIGHT_SHIFT + 8);
+			}
+			continue;
+		}
+
+		/* divide out the alpha at full precision, only the alpha
+		 * itself is rounded as the division rounds the colour.
+		 */
+		for (k = 0; k < row_bytes; k += 4) {
+			a = acc[k + 3] >> PIXELS_WEIGHT_SHIFT;
+			out[k + 3] = (acc[k + 3] + PIXELS_ROUND) >>
+				(PIXELS_WEIGHT_SHIFT + 8);
+			if (out[k + 3] == 0) {
+				out[k] = out[k + 1] = out[k + 2] = 0;
+				continue;
+			}
+			for (t = 0; t < 3; t++) {
+				c = (((acc[k + t] >> PIXELS_WEIGHT_SHIFT) * 255) +
+				     (a / 2)) / a;
+				out[k + t] = (c > 255) ? 255 : c;
+			}
+		}
+	}
+
+out:
+	free(acc);
+	free(row);
+	free(inter);
+	pixels_filter_fini(&vfilter);
+	pixels_filter_fini(&hfilter);
+
+	return res;
+}
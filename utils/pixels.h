@@ -0,0 +1,119 @@
+/*
+ * Copyright 2026 The NetSurf Browser Project
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Pixel buffer conversion interface.
+ *
+ * These operate on runs of 32bpp pixels stored as four bytes with the
+ * alpha (or equivalent) component in the last byte, such as the core
+ * RGBA bitmap format. Where the target supports it the runs are
+ * processed with SIMD instructions, otherwise a portable implementation
+ * is used. All implementations give identical results.
+ */
+
+#ifndef NETSURF_UTILS_PIXELS_H
+#define NETSURF_UTILS_PIXELS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "utils/errors.h"
+
+/**
+ * Test whether every pixel in a run is fully opaque.
+ *
+ * \param pixels The pixel run.
+ * \param count The number of pixels in the run.
+ * \return true if every alpha byte is 0xff else false.
+ */
+bool pixels_opaque(const uint8_t *pixels, size_t count);
+
+/**
+ * Exchange the first and third bytes of each pixel in a run.
+ *
+ * This converts between RGBA and BGRA in place.
+ *
+ * \param pixels The pixel run.
+ * \param count The number of pixels in the run.
+ */
+void pixels_swap_rb(uint8_t *pixels, size_t count);
+
+/**
+ * Premultiply the colour components of each pixel by its alpha.
+ *
+ * Components are rounded to nearest.
+ *
+ * \param pixels The pixel run.
+ * \param count The number of pixels in the run.
+ */
+void pixels_premultiply(uint8_t *pixels, size_t count);
+
+/**
+ * Divide the colour components of each pixel by its alpha.
+ *
+ * Components are rounded to nearest and clamped, pixels with zero
+ * alpha become transparent black.
+ *
+ * \param pixels The pixel run.
+ * \param count The number of pixels in the run.
+ */
+void pixels_unpremultiply(uint8_t *pixels, size_t count);
+
+/**
+ * Convert inverted CMYK pixels to opaque RGBA in place.
+ *
+ * This is the inverted CMYK as output by libjpeg for Adobe images
+ * where each of the red, green and blue components is the product of
+ * the respective colour and the black channel.
+ *
+ * \param pixels The pixel run.
+ * \param count The number of pixels in the run.
+ */
+void pixels_cmyk_to_rgba(uint8_t *pixels, size_t count);
+
+/**
+ * Resample a pixel buffer to a different size.
+ *
+ * Reduction averages the source area covered by each destination
+ * pixel and enlargement interpolates bilinearly. Unless the source is
+ * opaque colour components are weighted by alpha so the colour of
+ * transparent pixels does not bleed into their neighbours.
+ *
+ * \param src The source pixels.
+ * \param src_width The width of the source in pixels.
+ * \param src_height The height of the source in pixels.
+ * \param src_stride The distance between source rows in bytes.
+ * \param dst The destination pixels.
+ * \param dst_width The width of the destination in pixels.
+ * \param dst_height The height of the destination in pixels.
+ * \param dst_stride The distance between destination rows in bytes.
+ * \param opaque true if every source pixel is known to be opaque.
+ * \return NSERROR_OK on success, NSERROR_BAD_PARAMETER if either size
+ *         is empty or NSERROR_NOMEM if working memory is unavailable.
+ */
+nserror pixels_scale(const uint8_t *src,
+		unsigned int src_width, unsigned int src_height,
+		size_t src_stride,
+		uint8_t *dst,
+		unsigned int dst_width, unsigned int dst_height,
+		size_t dst_stride,
+		bool opaque);
+
+#endif